@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../game/params.hpp"
+#include "../game/layouts.hpp"
+#include "../game/ballstore.hpp"
+#include "../game/broadphase.hpp"
+#include "../game/pockets.hpp"
+#include "../game/kernels.hpp"
+#include "../game/contacts.hpp"
+#include "../game/physics.hpp"
+
+
+//-------------------------------------------------------
+//	headless physics benchmark
+//-------------------------------------------------------
+
+// usage: benchmark [--baseline file] [--threshold percent] [--update]
+// Times the step phases and a full break for several table sizes and compares the
+// ns per ball step against a baseline file, the exit code is 1 when any case got
+// slower than the threshold allows.
+
+namespace
+{
+	struct Case
+	{
+		std::string name;
+		int balls = 0;
+		double nsPerBallStep = 0.0;
+		double stepsPerSecond = 0.0;
+	};
+
+
+	struct Timer
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		double seconds() const
+		{
+			return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+		}
+	};
+
+
+	// every size gets about the same amount of ball steps per run,
+	// the fastest of the runs is reported to keep scheduler noise out
+	constexpr double ballStepsPerPhase = 1e6;
+	constexpr int runs = 3;
+	constexpr int maxBreakSteps = 20000;
+
+
+	std::vector< Vector2 > layoutFor( int balls )
+	{
+		if ( balls == 7 )
+			return Layouts::standard();
+		if ( balls == 16 )
+			return Layouts::rack( 15 );
+		return Layouts::stress( balls - 1 );
+	}
+
+
+	// a mid break state: every ball moving in a reproducible direction
+	Physics::BallStore movingState( int balls )
+	{
+		Physics::BallStore state;
+		state.assign( layoutFor( balls ) );
+
+		std::uint32_t seed = 12345u;
+		auto next = [ &seed ]()
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return float( seed >> 8 ) / float( 1u << 24 ) * 2.f - 1.f;
+		};
+
+		for ( int i = 0; i < state.size(); i++ )
+		{
+			state.vx[ i ] = next() * Params::Table::width;
+			state.vy[ i ] = next() * Params::Table::width;
+		}
+		return state;
+	}
+
+
+	template< class Phase >
+	Case timePhase( char const* name, int balls, Phase phase )
+	{
+		Physics::BallStore state = movingState( balls );
+		const int steps = std::max( 10, int( ballStepsPerPhase / balls ) );
+
+		for ( int i = 0; i < steps / 10; i++ )
+			phase( state );
+
+		double seconds = 0.0;
+		for ( int run = 0; run < runs; run++ )
+		{
+			Timer timer;
+			for ( int i = 0; i < steps; i++ )
+				phase( state );
+			seconds = run ? std::min( seconds, timer.seconds() ) : timer.seconds();
+		}
+
+		Case result;
+		result.name = std::string( name ) + "/" + std::to_string( balls );
+		result.balls = balls;
+		result.nsPerBallStep = seconds * 1e9 / ( double( steps ) * balls );
+		result.stepsPerSecond = steps / seconds;
+		return result;
+	}
+
+
+	Case timeBreak( int balls )
+	{
+		Physics::Simulation table;
+		const std::vector< Vector2 > layout = layoutFor( balls );
+
+		// aims at the first object ball when there is one
+		const Vector2 target = layout.size() > 1 ? layout[ 1 ] : Vector2{ 0.f, 0.f };
+
+		const double budget = ballStepsPerPhase / balls;
+
+		// small tables repeat the break, big ones stop mid break once the budget is used up
+		int steps = 0;
+		double seconds = 0.0;
+		for ( int run = 0; run < runs; run++ )
+		{
+			steps = 0;
+			Timer timer;
+			while ( steps < budget )
+			{
+				table.reset( layout );
+				table.shoot( target, 1.f );
+				for ( int i = 0; i < maxBreakSteps && steps < budget && table.isBallsMoving(); i++, steps++ )
+					table.step();
+			}
+			seconds = run ? std::min( seconds, timer.seconds() ) : timer.seconds();
+		}
+
+		Case result;
+		result.name = "break/" + std::to_string( balls );
+		result.balls = balls;
+		result.nsPerBallStep = seconds * 1e9 / ( double( steps ) * balls );
+		result.stepsPerSecond = steps / seconds;
+		return result;
+	}
+
+
+	std::map< std::string, double > loadBaselines( char const* path )
+	{
+		std::map< std::string, double > baselines;
+		std::ifstream file( path );
+		std::string line;
+		while ( std::getline( file, line ) )
+		{
+			if ( line.empty() || line[ 0 ] == '#' )
+				continue;
+
+			std::istringstream fields( line );
+			std::string name;
+			double value = 0.0;
+			if ( fields >> name >> value )
+				baselines[ name ] = value;
+		}
+		return baselines;
+	}
+
+
+	bool saveBaselines( char const* path, std::vector< Case > const& cases )
+	{
+		std::ofstream file( path );
+		file << "# case ns_per_ball_step, written by benchmark --update (" << Physics::Kernels::instructionSet() << " kernels)\n";
+		for ( Case const& c : cases )
+			file << c.name << " " << c.nsPerBallStep << "\n";
+		return bool( file );
+	}
+}
+
+
+int main( int argc, char** argv )
+{
+	char const* baselinePath = "benchmark/baselines.txt";
+	double threshold = 10.0;
+	bool update = false;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( !std::strcmp( argv[ i ], "--baseline" ) && i + 1 < argc )
+			baselinePath = argv[ ++i ];
+		else if ( !std::strcmp( argv[ i ], "--threshold" ) && i + 1 < argc )
+			threshold = std::atof( argv[ ++i ] );
+		else if ( !std::strcmp( argv[ i ], "--update" ) )
+			update = true;
+		else
+		{
+			std::fprintf( stderr, "usage: %s [--baseline file] [--threshold percent] [--update]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	const std::map< std::string, double > baselines = loadBaselines( baselinePath );
+
+	std::printf( "kernels: %s\n", Physics::Kernels::instructionSet() );
+	std::printf( "%-18s %8s %14s %14s %10s\n", "case", "balls", "ns/ball-step", "steps/sec", "vs base" );
+
+	std::vector< Case > cases;
+	int regressions = 0;
+
+	auto report = [ & ]( Case const& c )
+	{
+		char change[ 32 ] = "-";
+		auto it = baselines.find( c.name );
+		if ( it != baselines.end() && it->second > 0.0 )
+		{
+			const double percent = 100.0 * ( c.nsPerBallStep / it->second - 1.0 );
+			const bool regressed = percent > threshold;
+			std::snprintf( change, sizeof( change ), "%+.1f%%%s", percent, regressed ? " !" : "" );
+			regressions += regressed;
+		}
+
+		std::printf( "%-18s %8d %14.2f %14.0f %10s\n", c.name.c_str(), c.balls, c.nsPerBallStep, c.stepsPerSecond, change );
+		std::fflush( stdout );
+		cases.push_back( c );
+	};
+
+	constexpr float dt = Params::Physics::timeStep;
+	Physics::BroadPhase broadPhase;
+	Physics::ContactSolver solver;
+	const Physics::PocketLookup pockets;
+
+	for ( int balls : { 7, 16, 128, 1024, 10000 } )
+	{
+		report( timePhase( "pockets", balls, [ &pockets ]( Physics::BallStore& state )
+		{
+			Physics::Phases::checkPockets( state, pockets );
+		} ) );
+		report( timePhase( "borders", balls, []( Physics::BallStore& state )
+		{
+			Physics::Kernels::checkBorders( state, Physics::Contacts::Table< Rules::Pool >::cushions );
+		} ) );
+		report( timePhase( "collisions", balls, [ &broadPhase, &solver ]( Physics::BallStore& state )
+		{
+			Physics::Phases::checkBallCollisions( state, broadPhase, solver );
+		} ) );
+		report( timePhase( "integration", balls, [ dt ]( Physics::BallStore& state )
+		{
+			Physics::Kernels::integrate( state, dt );
+			Physics::Kernels::applyFriction( state, Params::Physics::deceleration, dt );
+		} ) );
+		report( timeBreak( balls ) );
+	}
+
+	if ( update )
+	{
+		if ( !saveBaselines( baselinePath, cases ) )
+		{
+			std::fprintf( stderr, "cannot write %s\n", baselinePath );
+			return 2;
+		}
+		std::printf( "baselines written to %s\n", baselinePath );
+		return 0;
+	}
+
+	if ( regressions )
+	{
+		std::printf( "%d case(s) slower than the baseline by more than %.1f%%\n", regressions, threshold );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "arena.hpp"
+
+
+Arena::Arena( size_t chunkSize ) :
+	chunkSize( chunkSize )
+{
+}
+
+
+void* Arena::allocate( size_t size, size_t alignment )
+{
+	// the current chunk first, then the ones after it that reset made free again
+	for ( ; current < chunks.size(); current++, offset = 0 )
+	{
+		Chunk& chunk = chunks[ current ];
+		const std::uintptr_t base = reinterpret_cast< std::uintptr_t >( chunk.memory.get() );
+		const size_t aligned = size_t( ( base + offset + alignment - 1 ) / alignment * alignment - base );
+		if ( aligned + size <= chunk.size )
+		{
+			offset = aligned + size;
+			return chunk.memory.get() + aligned;
+		}
+	}
+
+	// a chunk big enough for the request even at the worst alignment
+	const size_t newSize = std::max( chunkSize, size + alignment );
+	chunks.push_back( { std::unique_ptr< unsigned char[] >( new unsigned char[ newSize ] ), newSize } );
+	current = chunks.size() - 1;
+	offset = 0;
+	return allocate( size, alignment );
+}
+
+
+void Arena::reset()
+{
+	current = 0;
+	offset = 0;
+}
+
+
+size_t Arena::capacity() const
+{
+	size_t total = 0;
+	for ( Chunk const& chunk : chunks )
+		total += chunk.size;
+	return total;
+}
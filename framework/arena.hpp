@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	bump allocator for scratch memory of one pass
+//-------------------------------------------------------
+
+// hands out memory from chunks it keeps for its whole life, reset makes all of it
+// free again at once, so a pass that is repeated forever only goes to the heap until
+// the chunks have grown to the largest pass seen
+class Arena
+{
+public:
+	explicit Arena( size_t chunkSize = 64 * 1024 );
+	Arena( Arena const& ) = delete;
+
+	void* allocate( size_t size, size_t alignment );
+
+	// uninitialized, nothing allocated here is ever destroyed
+	template< class T >
+	T* allocate( size_t count )
+	{
+		static_assert( std::is_trivially_destructible< T >::value, "arena memory is released without destructors" );
+		return static_cast< T* >( allocate( count * sizeof( T ), alignof( T ) ) );
+	}
+
+	// everything allocated so far is released, the chunks stay
+	void reset();
+
+	// bytes held in chunks
+	size_t capacity() const;
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr< unsigned char[] > memory;
+		size_t size;
+	};
+
+	std::vector< Chunk > chunks;
+	size_t chunkSize;
+	size_t current = 0;
+	size_t offset = 0;
+};
+
+
+//-------------------------------------------------------
+//	standard allocator over an arena
+//-------------------------------------------------------
+
+// lets containers take their storage from an arena, deallocation does nothing,
+// so a container is best built once in the pass and let go with the arena reset
+template< class T >
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	explicit ArenaAllocator( Arena& arena ) :
+		arena( &arena )
+	{
+	}
+
+	template< class U >
+	ArenaAllocator( ArenaAllocator< U > const& other ) :
+		arena( other.arena )
+	{
+	}
+
+	T* allocate( size_t count )
+	{
+		return static_cast< T* >( arena->allocate( count * sizeof( T ), alignof( T ) ) );
+	}
+
+	void deallocate( T*, size_t )
+	{
+	}
+
+	template< class U >
+	bool operator==( ArenaAllocator< U > const& other ) const
+	{
+		return arena == other.arena;
+	}
+
+	template< class U >
+	bool operator!=( ArenaAllocator< U > const& other ) const
+	{
+		return arena != other.arena;
+	}
+
+private:
+	template< class U >
+	friend class ArenaAllocator;
+
+	Arena* arena;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+
+//-------------------------------------------------------
+//	engine only interface: platform backend
+//-------------------------------------------------------
+
+// Everything the engine needs from the operating system: a window with a gl
+// context, its input and a clock. A build compiles one backend, win32backend.cpp
+// on Windows and x11backend.cpp elsewhere, both can open an offscreen surface.
+namespace Backend
+{
+	// clock ticks, only differences between two of them mean anything
+	using Ticks = std::int64_t;
+
+	// callable from any thread
+	Ticks now();
+	double secondsBetween( Ticks from, Ticks to );
+
+
+	enum class Surface
+	{
+		// a visible window, frames go to the screen with swapBuffers
+		window,
+		// nothing on screen and no input, the engine draws into a framebuffer object of its own
+		offscreen
+	};
+
+	enum class MouseEvent
+	{
+		pressed,
+		released,
+		moved
+	};
+
+	enum class Key
+	{
+		escape,
+		space,
+		f1,
+		f2
+	};
+
+	// called from processEvents, a handler left empty drops the event
+	struct Handlers
+	{
+		// x from the left and y from the bottom of the window in [0, 1], time when the event came in
+		void ( *mouse )( MouseEvent event, float x, float y, Ticks time ) = nullptr;
+		void ( *keyPressed )( Key key ) = nullptr;
+		// the window contents were lost and the next frame has to be drawn whole
+		void ( *contentsLost )() = nullptr;
+	};
+
+
+	// makes a gl context current on the calling thread, with a window of that client size
+	// or an offscreen surface, false when either cannot be created
+	bool open( Surface surface, int width, int height, char const* title, Handlers const& handlers );
+	void close();
+
+	// dispatches the pending events to the handlers, false once the window was closed
+	bool processEvents();
+	// processEvents returns false from the next call on
+	void requestClose();
+
+	void swapBuffers();
+	// 1 waits for the display with every swap, 0 does not, false when the driver cannot change it
+	bool setSwapInterval( int interval );
+
+	// gl entry points beyond 1.1, null when the context does not have them
+	void* glProcAddress( char const* name );
+	// gl objects outliving the context must not be deleted anymore
+	bool isContextCurrent();
+
+
+	// sleeps for most of a wait and leaves the rest to spinning, a sleeper belongs to one thread
+	class Sleeper
+	{
+	public:
+		Sleeper();
+		Sleeper( Sleeper const& ) = delete;
+		~Sleeper();
+
+		// may return early but rarely later than the margin
+		void sleep( double seconds );
+		// how much earlier a sleep should end than the deadline
+		double margin() const;
+
+	private:
+		void* timer = nullptr;
+		bool highResolution = false;
+	};
+
+	// cheap pause inside a spin loop
+	void spinPause();
+}
@@ -1,255 +1,504 @@
-
-#define NOMINMAX
-#include <cassert>
-#include <windows.h>
-#include <windowsx.h>
-#include <GL/gl.h>
-
-#include "game.hpp"
-#include "scene.hpp"
-
-
-//-------------------------------------------------------
-//	window related stuff
-//-------------------------------------------------------
-
-namespace
-{
-	HWND windowHandle = nullptr;
-
-	constexpr int windowWidth = 1280;
-	constexpr int windowHeight = 720;
-
-
-	//-------------------------------------------------------
-	LRESULT CALLBACK windowProcedure( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
-	{
-		switch ( message )
-		{
-			case WM_DESTROY:
-				PostQuitMessage( 0 );
-				break;
-
-			case WM_LBUTTONDOWN:
-			case WM_RBUTTONDOWN:
-			case WM_LBUTTONDBLCLK:
-			case WM_RBUTTONDBLCLK:
-				Game::mouseButtonPressed(
-					Scene::screenToWorldX( float( GET_X_LPARAM( lParam ) ) / windowWidth ),
-					Scene::screenToWorldY( 1.f - float( GET_Y_LPARAM( lParam ) ) / windowHeight ) );
-				break;
-
-			case WM_LBUTTONUP:
-			case WM_RBUTTONUP:
-				Game::mouseButtonReleased(
-					Scene::screenToWorldX( float( GET_X_LPARAM( lParam ) ) / windowWidth ),
-					Scene::screenToWorldY( 1.f - float( GET_Y_LPARAM( lParam ) ) / windowHeight ) );
-				break;
-
-			case WM_KEYDOWN:
-				if ( wParam == VK_ESCAPE )
-					DestroyWindow( windowHandle );
-				if ( wParam == VK_SPACE )
-				{
-					Game::deinit();
-					Game::init();
-				}
-				break;
-		}
-		return DefWindowProc( hwnd, message, wParam, lParam );
-	}
-
-
-	//-------------------------------------------------------
-	void initWindow()
-	{
-		WNDCLASSEX windowClass;
-
-		windowClass.cbSize = sizeof( windowClass );
-		windowClass.hInstance = GetModuleHandle( nullptr );
-		windowClass.lpszClassName = TEXT( "MiniBill_WndClass" );
-		windowClass.lpfnWndProc = windowProcedure;
-		windowClass.style = CS_DBLCLKS;
-
-		windowClass.hIcon = nullptr;
-		windowClass.hIconSm = nullptr;
-		windowClass.hCursor = LoadCursor( nullptr, IDC_ARROW );
-		windowClass.lpszMenuName = nullptr;
-		windowClass.cbClsExtra = 0;
-		windowClass.cbWndExtra = 0;
-		windowClass.hbrBackground = nullptr;
-
-		RegisterClassEx( &windowClass );
-
-		RECT windowRect;
-		windowRect.left = windowRect.top = 0;
-		windowRect.bottom = windowHeight;
-		windowRect.right = windowWidth;
-		AdjustWindowRect( &windowRect, WS_CAPTION | WS_SYSMENU, FALSE );
-
-		int screenWidth = GetSystemMetrics( SM_CXFULLSCREEN );
-		int screenHeight = GetSystemMetrics( SM_CYFULLSCREEN );
-
-		windowHandle = CreateWindowEx( 0, TEXT( "MiniBill_WndClass" ), TEXT( "Mini Billiard [Pre-Alpha]" ), WS_CAPTION | WS_SYSMENU,
-								screenWidth / 2 - windowWidth / 2, screenHeight / 2 - windowHeight / 2, windowRect.right - windowRect.left, windowRect.bottom - windowRect.top,
-								HWND_DESKTOP, nullptr, GetModuleHandle( nullptr ), nullptr );
-
-		ShowWindow( windowHandle, SW_SHOW );
-	}
-
-
-	//-------------------------------------------------------
-	void deinitWindow()
-	{
-		DestroyWindow( windowHandle );
-	}
-
-
-	//-------------------------------------------------------
-	bool processWindowMessages()
-	{
-		MSG msg;
-		while ( PeekMessage( &msg, nullptr, 0, 0, PM_REMOVE ) )
-		{
-			if ( msg.message == WM_QUIT )
-				return false;
-			TranslateMessage( &msg );
-			DispatchMessage( &msg );
-		}
-		return true;
-	}
-}
-
-
-//-------------------------------------------------------
-//	opengl related stuff
-//-------------------------------------------------------
-
-namespace
-{
-	HDC windowDC = nullptr;
-	HGLRC openGLHandle = nullptr;
-
-
-	//-------------------------------------------------------
-	void initOGL()
-	{
-		windowDC = GetDC( windowHandle );
-
-		PIXELFORMATDESCRIPTOR pfd;
-		memset( &pfd, 0, sizeof( pfd ) );
-		pfd.nSize = sizeof( pfd );
-		pfd.nVersion = 1;
-		pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
-		pfd.iPixelType = PFD_TYPE_RGBA;
-		pfd.iLayerType = PFD_MAIN_PLANE;
-		int npfd = ChoosePixelFormat( windowDC, &pfd );
-
-		memset( &pfd, 0, sizeof( pfd ) );
-		pfd.nSize = sizeof( pfd );
-		SetPixelFormat( windowDC, npfd, &pfd );
-
-		openGLHandle = wglCreateContext( windowDC );
-		wglMakeCurrent( windowDC, openGLHandle );
-
-		using PFNWGLSWAPINTERVALEXTPROC = BOOL (WINAPI *)( int );
-		if ( PFNWGLSWAPINTERVALEXTPROC wglSwapInterval = ( PFNWGLSWAPINTERVALEXTPROC )wglGetProcAddress( "wglSwapIntervalEXT" ) )
-			wglSwapInterval( 0 );
-	}
-
-
-	//-------------------------------------------------------
-	void deinitOGL()
-	{
-		wglMakeCurrent( nullptr, nullptr );
-		wglDeleteContext( openGLHandle );
-		ReleaseDC( windowHandle, windowDC );
-		openGLHandle = nullptr;
-		windowDC = nullptr;
-	}
-
-
-	//-------------------------------------------------------
-	void draw()
-	{
-		Scene::draw();
-		SwapBuffers( windowDC );
-
-		assert( glGetError() == 0 );
-	}
-}
-
-
-//-------------------------------------------------------
-//	update and time related stuff
-//-------------------------------------------------------
-
-namespace
-{
-	constexpr int minFPS = 5;
-	constexpr int maxFPS = 200;
-	int targetFPS = maxFPS;
-
-	LARGE_INTEGER clockFrequency;
-	LARGE_INTEGER clockLastTick;
-
-
-	//-------------------------------------------------------
-	void initClock()
-	{
-		QueryPerformanceFrequency( &clockFrequency );
-		QueryPerformanceCounter( &clockLastTick );
-	}
-
-
-	//-------------------------------------------------------
-	void update()
-	{
-		float dt = 0.f;
-
-		while ( true )
-		{
-			LARGE_INTEGER clockTick;
-			QueryPerformanceCounter( &clockTick );
-			double deltaTime = double( clockTick.QuadPart - clockLastTick.QuadPart ) / double( clockFrequency.QuadPart );
-			if ( deltaTime >= 1.0 / targetFPS )
-			{
-				dt = float( deltaTime );
-				clockLastTick = clockTick;
-				break;
-			}
-		}
-
-		Game::update( dt );
-	}
-}
-
-
-//-------------------------------------------------------
-//	public engine interface
-//-------------------------------------------------------
-
-namespace Engine
-{
-	void setTargetFPS( int fps )
-	{
-		targetFPS = fps > maxFPS ? maxFPS : fps < minFPS ? minFPS : fps;
-	}
-
-
-	void run()
-	{
-		initWindow();
-		initOGL();
-		initClock();
-		Game::init();
-		while ( processWindowMessages() )
-		{
-			update();
-			draw();
-		}
-		Game::deinit();
-		deinitOGL();
-		deinitWindow();
-	}
-}
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "opengl.hpp"
+#include "backend.hpp"
+#include "engine.hpp"
+#include "game.hpp"
+#include "scene.hpp"
+#include "renderer.hpp"
+#include "profiler.hpp"
+#include "spscqueue.hpp"
+#include "framearena.hpp"
+
+
+//-------------------------------------------------------
+//	input related stuff
+//-------------------------------------------------------
+
+namespace
+{
+	// serializes game calls from the event handlers with the update thread,
+	// drawing never takes it
+	std::mutex gameLock;
+
+	constexpr int windowWidth = 1280;
+	constexpr int windowHeight = 720;
+	char const* const windowTitle = "Mini Billiard [Pre-Alpha]";
+
+
+	// mouse buttons go through a queue instead of the lock, the update thread plays
+	// them before the step they fall into, at the time they happened
+	struct InputEvent
+	{
+		Backend::MouseEvent type;
+		float x;
+		float y;
+		Backend::Ticks time;
+	};
+
+	// room for the cursor moves of a few stalled updates
+	SpscQueue< InputEvent, 256 > inputEvents;
+
+
+	//-------------------------------------------------------
+	void queueInput( Backend::MouseEvent type, float x, float y, Backend::Ticks time )
+	{
+		InputEvent event;
+		event.time = time;
+		event.type = type;
+		event.x = Scene::screenToWorldX( x );
+		event.y = Scene::screenToWorldY( y );
+		// a full queue means the update thread stalled, the click is dropped
+		inputEvents.push( event );
+	}
+
+
+	//-------------------------------------------------------
+	void keyPressed( Backend::Key key )
+	{
+		switch ( key )
+		{
+			case Backend::Key::escape:
+				Backend::requestClose();
+				break;
+
+			case Backend::Key::f1:
+				Scene::toggleProfilerOverlay();
+				break;
+
+			case Backend::Key::f2:
+				Profiler::exportChromeTrace( "trace.json" );
+				break;
+
+			case Backend::Key::space:
+			{
+				std::lock_guard< std::mutex > lock( gameLock );
+				Game::deinit();
+				Game::init();
+				break;
+			}
+		}
+	}
+
+
+	//-------------------------------------------------------
+	Backend::Handlers handlers()
+	{
+		Backend::Handlers result;
+		result.mouse = queueInput;
+		result.keyPressed = keyPressed;
+		result.contentsLost = Scene::invalidate;
+		return result;
+	}
+}
+
+
+//-------------------------------------------------------
+//	opengl related stuff
+//-------------------------------------------------------
+
+namespace
+{
+	std::atomic< bool > vsyncRequested{ false };
+	bool vsyncApplied = false;
+	// false when the driver has no say over the swap interval
+	bool swapControl = false;
+
+
+	//-------------------------------------------------------
+	// presentation follows the display when vsync is on, the update thread keeps its own pace
+	void initSwapInterval()
+	{
+		vsyncApplied = vsyncRequested;
+		swapControl = Backend::setSwapInterval( vsyncApplied ? 1 : 0 );
+	}
+
+
+	//-------------------------------------------------------
+	// without swap control presentation is never synchronized and the limiter paces it
+	bool isVSyncActive()
+	{
+		return swapControl && vsyncApplied;
+	}
+
+
+	//-------------------------------------------------------
+	// false when the scene had nothing new and the previous frame is still on screen
+	bool draw()
+	{
+		if ( swapControl && vsyncApplied != vsyncRequested )
+		{
+			vsyncApplied = vsyncRequested;
+			Backend::setSwapInterval( vsyncApplied ? 1 : 0 );
+		}
+
+		bool changed;
+		{
+			PROFILE_SCOPE( draw );
+			Game::prepareDraw();
+			changed = Scene::draw();
+		}
+		if ( changed )
+		{
+			PROFILE_SCOPE( swap );
+			Backend::swapBuffers();
+		}
+
+		assert( glGetError() == 0 );
+		return changed;
+	}
+}
+
+
+//-------------------------------------------------------
+//	update and time related stuff
+//-------------------------------------------------------
+
+namespace
+{
+	constexpr int minFPS = 5;
+	constexpr int maxFPS = 200;
+	std::atomic< int > targetFPS{ maxFPS };
+	std::atomic< bool > updating{ false };
+	std::thread updateThread;
+
+
+	//-------------------------------------------------------
+	// frame interval statistics, written by one thread and read from any
+	class PacingStats
+	{
+	public:
+		static constexpr int window = 240;
+
+		void add( double interval, double target );
+		Engine::FramePacing summary() const;
+
+	private:
+		double sum = 0.0;
+		double sumSquares = 0.0;
+		double worst = 0.0;
+		int count = 0;
+
+		mutable std::mutex lock;
+		Engine::FramePacing last;
+	};
+
+
+	//-------------------------------------------------------
+	void PacingStats::add( double interval, double target )
+	{
+		sum += interval;
+		sumSquares += interval * interval;
+		worst = std::max( worst, interval - target );
+		if ( ++count < window )
+			return;
+
+		const double mean = sum / count;
+		Engine::FramePacing pacing;
+		pacing.frames = count;
+		pacing.targetMs = float( 1000.0 * target );
+		pacing.meanMs = float( 1000.0 * mean );
+		pacing.jitterMs = float( 1000.0 * std::sqrt( std::max( sumSquares / count - mean * mean, 0.0 ) ) );
+		pacing.worstLateMs = float( 1000.0 * worst );
+
+		{
+			std::lock_guard< std::mutex > guard( lock );
+			last = pacing;
+		}
+		sum = sumSquares = worst = 0.0;
+		count = 0;
+	}
+
+
+	//-------------------------------------------------------
+	Engine::FramePacing PacingStats::summary() const
+	{
+		std::lock_guard< std::mutex > guard( lock );
+		return last;
+	}
+
+
+	//-------------------------------------------------------
+	// sleeps for most of the period and spins only for the rest, how much is left
+	// to spinning depends on how precisely the backend can sleep
+	class FrameLimiter
+	{
+	public:
+		// returns once the period has passed since the previous return, gives the real interval
+		double wait( double period );
+		// only measures, for frames paced by something else
+		double mark();
+		// clock tick of the previous return
+		Backend::Ticks lastMark() const;
+
+		PacingStats const& pacing() const;
+
+	private:
+		Backend::Sleeper sleeper;
+		bool started = false;
+		Backend::Ticks lastTick = 0;
+		PacingStats stats;
+	};
+
+
+	//-------------------------------------------------------
+	double FrameLimiter::wait( double period )
+	{
+		if ( !started )
+			return mark();
+
+		PROFILE_SCOPE( limiterWait );
+
+		Backend::Ticks clockTick = Backend::now();
+		sleeper.sleep( period - Backend::secondsBetween( lastTick, clockTick ) - sleeper.margin() );
+
+		while ( true )
+		{
+			clockTick = Backend::now();
+			if ( Backend::secondsBetween( lastTick, clockTick ) >= period )
+				break;
+			Backend::spinPause();
+		}
+
+		const double interval = Backend::secondsBetween( lastTick, clockTick );
+		lastTick = clockTick;
+		stats.add( interval, period );
+		return interval;
+	}
+
+
+	//-------------------------------------------------------
+	double FrameLimiter::mark()
+	{
+		const Backend::Ticks clockTick = Backend::now();
+
+		double interval = 0.0;
+		if ( started )
+		{
+			interval = Backend::secondsBetween( lastTick, clockTick );
+			stats.add( interval, interval );
+		}
+
+		started = true;
+		lastTick = clockTick;
+		return interval;
+	}
+
+
+	//-------------------------------------------------------
+	Backend::Ticks FrameLimiter::lastMark() const
+	{
+		return lastTick;
+	}
+
+
+	//-------------------------------------------------------
+	PacingStats const& FrameLimiter::pacing() const
+	{
+		return stats;
+	}
+
+
+	FrameLimiter updateLimiter;
+	FrameLimiter drawLimiter;
+
+
+	//-------------------------------------------------------
+	// the step covers the time since stepStart, an event is placed where it happened in it,
+	// one that came in while waiting for the lock counts as its end
+	void step( Backend::Ticks stepStart, float dt )
+	{
+		std::lock_guard< std::mutex > lock( gameLock );
+		PROFILE_SCOPE( update );
+		FrameArena::beginTick();
+
+		InputEvent event;
+		while ( inputEvents.pop( event ) )
+		{
+			const float offset = std::min( std::max( float( Backend::secondsBetween( stepStart, event.time ) ), 0.f ), dt );
+			if ( event.type == Backend::MouseEvent::pressed )
+				Game::mouseButtonPressed( event.x, event.y, offset );
+			else if ( event.type == Backend::MouseEvent::released )
+				Game::mouseButtonReleased( event.x, event.y, offset );
+			else
+				Game::mouseMoved( event.x, event.y );
+		}
+
+		Game::update( dt );
+		FrameArena::endTick();
+	}
+
+
+	//-------------------------------------------------------
+	void update()
+	{
+		const Backend::Ticks stepStart = updateLimiter.lastMark();
+		const float dt = float( updateLimiter.wait( 1.0 / targetFPS ) );
+		step( stepStart, dt );
+	}
+
+
+	//-------------------------------------------------------
+	void present()
+	{
+		FrameArena::beginTick();
+		const bool presented = draw();
+		FrameArena::endTick();
+
+		// the swap blocks on the display with vsync, otherwise the loop is capped,
+		// an idle frame swaps nothing and sleeps until the next update could have changed the scene
+		if ( presented && isVSyncActive() )
+			drawLimiter.mark();
+		else
+			drawLimiter.wait( presented ? 1.0 / maxFPS : 1.0 / targetFPS );
+	}
+
+
+	//-------------------------------------------------------
+	void startUpdateThread()
+	{
+		updating = true;
+		updateThread = std::thread( []
+		{
+			updateLimiter.mark();
+			while ( updating )
+				update();
+		} );
+	}
+
+
+	//-------------------------------------------------------
+	void stopUpdateThread()
+	{
+		updating = false;
+		updateThread.join();
+	}
+}
+
+
+//-------------------------------------------------------
+//	offscreen related stuff
+//-------------------------------------------------------
+
+namespace
+{
+	//-------------------------------------------------------
+	bool writeImage( char const* path, Renderer::RenderTarget const& target, int width, int height )
+	{
+		std::vector< unsigned char > rgb;
+		target.read( rgb );
+
+		std::FILE* file = std::fopen( path, "wb" );
+		if ( !file )
+			return false;
+		std::fprintf( file, "P6\n%d %d\n255\n", width, height );
+		const bool written = std::fwrite( rgb.data(), 1, rgb.size(), file ) == rgb.size();
+		return std::fclose( file ) == 0 && written;
+	}
+
+
+	//-------------------------------------------------------
+	// updates and frames alternate on this thread, a frame is held up by nothing but drawing
+	void playOffscreen( int frames )
+	{
+		const float dt = 1.f / float( targetFPS );
+		drawLimiter.mark();
+		for ( int frame = 0; frame < frames; frame++ )
+		{
+			step( Backend::now(), dt );
+
+			FrameArena::beginTick();
+			{
+				PROFILE_SCOPE( draw );
+				Game::prepareDraw();
+				Scene::draw();
+			}
+			FrameArena::endTick();
+			drawLimiter.mark();
+
+			assert( glGetError() == 0 );
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	public engine interface
+//-------------------------------------------------------
+
+namespace Engine
+{
+	void setTargetFPS( int fps )
+	{
+		targetFPS = fps > maxFPS ? maxFPS : fps < minFPS ? minFPS : fps;
+	}
+
+
+	void setVSync( bool enabled )
+	{
+		vsyncRequested = enabled;
+	}
+
+
+	FramePacing updatePacing()
+	{
+		return updateLimiter.pacing().summary();
+	}
+
+
+	FramePacing drawPacing()
+	{
+		return drawLimiter.pacing().summary();
+	}
+
+
+	void run()
+	{
+		if ( !Backend::open( Backend::Surface::window, windowWidth, windowHeight, windowTitle, handlers() ) )
+			return;
+
+		initSwapInterval();
+		Game::init();
+		startUpdateThread();
+		drawLimiter.mark();
+		while ( Backend::processEvents() )
+			present();
+
+		stopUpdateThread();
+		Game::deinit();
+		Backend::close();
+	}
+
+
+	bool runOffscreen( int width, int height, int frames, char const* imagePath )
+	{
+		if ( !Backend::open( Backend::Surface::offscreen, width, height, windowTitle, Backend::Handlers() ) )
+			return false;
+
+		bool done = false;
+		{
+			// released before the context goes
+			Renderer::RenderTarget target;
+			if ( target.create( width, height ) )
+			{
+				target.bind();
+				// the game sets the target rate the frames step with
+				Game::init();
+				playOffscreen( frames );
+				done = !imagePath || writeImage( imagePath, target, width, height );
+				Game::deinit();
+			}
+		}
+
+		Backend::close();
+		return done;
+	}
+}
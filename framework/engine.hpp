@@ -1,10 +1,35 @@
-
-#pragma once
-
-
-namespace Engine
-{
-	void setTargetFPS( int fps );
-	void run();
-}
-
+
+#pragma once
+
+
+namespace Engine
+{
+	// frame intervals over the last completed window of frames
+	struct FramePacing
+	{
+		int frames = 0;
+		float targetMs = 0.f;
+		float meanMs = 0.f;
+		// standard deviation of the interval
+		float jitterMs = 0.f;
+		// largest overshoot past the target
+		float worstLateMs = 0.f;
+	};
+
+	// update rate, drawing runs at display rate
+	void setTargetFPS( int fps );
+	// when off, or unsupported by the driver, drawing is capped by the frame limiter instead
+	void setVSync( bool enabled );
+
+	// callable from any thread
+	FramePacing updatePacing();
+	FramePacing drawPacing();
+
+	// both run once per process, the renderer keeps what it made in the first context
+	void run();
+	// draws into a framebuffer object of that size with no window and no input, every frame
+	// steps the game by one update at the target rate without waiting for anything,
+	// the last frame goes to the path as a binary ppm, false when it could not be drawn or written
+	bool runOffscreen( int width, int height, int frames, char const* imagePath );
+}
+
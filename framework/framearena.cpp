@@ -0,0 +1,119 @@
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#include "framearena.hpp"
+
+
+namespace FrameArena
+{
+	namespace
+	{
+		// containers grow to their steady size in the first ticks of a thread
+		constexpr int warmupTicks = 240;
+
+		thread_local std::uint64_t allocations = 0;
+		thread_local std::uint64_t tickStart = 0;
+		thread_local int ticks = 0;
+		thread_local bool allowed = false;
+	}
+
+
+	Arena& current()
+	{
+		thread_local Arena arena;
+		return arena;
+	}
+
+
+	void allowHeapAllocations()
+	{
+		allowed = true;
+	}
+
+
+	std::uint64_t heapAllocations()
+	{
+		return allocations;
+	}
+
+
+	void beginTick()
+	{
+		current().reset();
+		tickStart = allocations;
+		allowed = false;
+	}
+
+
+	void endTick()
+	{
+#ifdef ALLOCATION_TRACKING
+		assert( allowed || ticks < warmupTicks || allocations == tickStart );
+#endif
+		if ( ticks < warmupTicks )
+			ticks++;
+	}
+}
+
+
+//-------------------------------------------------------
+//	counting global allocation functions
+//-------------------------------------------------------
+
+// the replaceable forms everything else forwards to, over aligned new keeps the
+// library version and is not counted
+#ifdef ALLOCATION_TRACKING
+
+void* operator new( size_t size )
+{
+	FrameArena::allocations++;
+	if ( void* memory = std::malloc( size ? size : 1 ) )
+		return memory;
+	throw std::bad_alloc();
+}
+
+
+void* operator new[]( size_t size )
+{
+	return operator new( size );
+}
+
+
+void* operator new( size_t size, std::nothrow_t const& ) noexcept
+{
+	FrameArena::allocations++;
+	return std::malloc( size ? size : 1 );
+}
+
+
+void* operator new[]( size_t size, std::nothrow_t const& ) noexcept
+{
+	return operator new( size, std::nothrow );
+}
+
+
+void operator delete( void* memory ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete[]( void* memory ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete( void* memory, size_t ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete[]( void* memory, size_t ) noexcept
+{
+	std::free( memory );
+}
+
+#endif
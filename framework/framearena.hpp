@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "arena.hpp"
+
+
+//-------------------------------------------------------
+//	per tick scratch memory
+//-------------------------------------------------------
+
+// Every thread has its own arena. The engine resets the one of the update thread at
+// the top of every update and the one of the render thread at the top of every
+// frame, so nothing taken from it may outlive the tick it was taken in.
+//
+// With ALLOCATION_TRACKING the global operator new counts heap allocations per
+// thread, and the engine asserts that a tick after the warm up made none. A tick
+// that allocates for a good reason, a reset of the table, says so.
+namespace FrameArena
+{
+	Arena& current();
+
+	template< class T >
+	using Vector = std::vector< T, ArenaAllocator< T > >;
+
+	// an empty vector on the arena of the calling thread
+	template< class T >
+	Vector< T > vector()
+	{
+		return Vector< T >( ArenaAllocator< T >( current() ) );
+	}
+
+	// the current tick of the calling thread may go to the heap
+	void allowHeapAllocations();
+	// heap allocations of the calling thread so far, zero without ALLOCATION_TRACKING
+	std::uint64_t heapAllocations();
+}
+
+
+//-------------------------------------------------------
+//	engine only interface
+//-------------------------------------------------------
+
+namespace FrameArena
+{
+	// resets the arena of the calling thread
+	void beginTick();
+	// checks the tick against the allocation counter
+	void endTick();
+}
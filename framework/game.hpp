@@ -1,13 +1,20 @@
-
-#pragma once
-
-
-namespace Game
-{
-	void init();
-	void deinit();
-	void update( float dt );
-
-	void mouseButtonPressed( float x, float y );
-	void mouseButtonReleased( float x, float y );
-}
+
+#pragma once
+
+
+namespace Game
+{
+	void init();
+	void deinit();
+	// update thread, under the engine game lock like every call except prepareDraw
+	void update( float dt );
+	// render thread, right before the scene is drawn
+	void prepareDraw();
+
+	// update thread, right before the update whose step the button went down or up in,
+	// offset is the time into that step
+	void mouseButtonPressed( float x, float y, float offset );
+	void mouseButtonReleased( float x, float y, float offset );
+	// update thread, the cursor position in world units
+	void mouseMoved( float x, float y );
+}
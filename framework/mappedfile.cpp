@@ -0,0 +1,129 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mappedfile.hpp"
+
+
+//-------------------------------------------------------
+//	windows
+//-------------------------------------------------------
+
+#ifdef _WIN32
+
+MappedFile::MappedFile( char const* path )
+{
+	// writers and deleters are let in, a tool replacing the file does not fail on us
+	HANDLE handle = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( handle == INVALID_HANDLE_VALUE )
+		return;
+	file = handle;
+
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx( handle, &fileSize ) || !fileSize.QuadPart )
+		return;
+
+	mapping = CreateFileMappingA( handle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if ( !mapping )
+		return;
+
+	view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if ( view )
+		bytes = size_t( fileSize.QuadPart );
+}
+
+
+MappedFile::~MappedFile()
+{
+	if ( view )
+		UnmapViewOfFile( view );
+	if ( mapping )
+		CloseHandle( mapping );
+	if ( file )
+		CloseHandle( file );
+}
+
+
+std::uint64_t MappedFile::modificationTime( char const* path )
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if ( !GetFileAttributesExA( path, GetFileExInfoStandard, &attributes ) )
+		return 0;
+
+	return ( std::uint64_t( attributes.ftLastWriteTime.dwHighDateTime ) << 32 ) | attributes.ftLastWriteTime.dwLowDateTime;
+}
+
+
+//-------------------------------------------------------
+//	posix
+//-------------------------------------------------------
+
+#else
+
+MappedFile::MappedFile( char const* path )
+{
+	int handle = ::open( path, O_RDONLY | O_CLOEXEC );
+	if ( handle < 0 )
+		return;
+
+	struct stat status;
+	if ( fstat( handle, &status ) == 0 && status.st_size > 0 )
+	{
+		// the mapping keeps the file alive, a tool replacing it by a rename does not touch this view
+		void* mapped = mmap( nullptr, size_t( status.st_size ), PROT_READ, MAP_PRIVATE, handle, 0 );
+		if ( mapped != MAP_FAILED )
+		{
+			view = mapped;
+			bytes = size_t( status.st_size );
+		}
+	}
+	::close( handle );
+}
+
+
+MappedFile::~MappedFile()
+{
+	if ( view )
+		munmap( const_cast< void* >( view ), bytes );
+}
+
+
+std::uint64_t MappedFile::modificationTime( char const* path )
+{
+	struct stat status;
+	if ( stat( path, &status ) != 0 )
+		return 0;
+
+	return std::uint64_t( status.st_mtim.tv_sec ) * 1000000000u + std::uint64_t( status.st_mtim.tv_nsec );
+}
+
+#endif
+
+
+//-------------------------------------------------------
+//	both
+//-------------------------------------------------------
+
+MappedFile::operator bool() const
+{
+	return view != nullptr;
+}
+
+
+void const* MappedFile::data() const
+{
+	return view;
+}
+
+
+size_t MappedFile::size() const
+{
+	return bytes;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+//-------------------------------------------------------
+//	read only memory mapped files
+//-------------------------------------------------------
+
+// The file stays mapped for the lifetime of the object, keep it short so tools
+// can replace the file on disk.
+class MappedFile
+{
+public:
+	explicit MappedFile( char const* path );
+	~MappedFile();
+
+	MappedFile( MappedFile const& ) = delete;
+	MappedFile& operator=( MappedFile const& ) = delete;
+
+	// false when the file is missing, empty or cannot be mapped
+	explicit operator bool() const;
+
+	void const* data() const;
+	size_t size() const;
+
+	// last write time of the file, 0 when it does not exist
+	static std::uint64_t modificationTime( char const* path );
+
+private:
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+	void const* view = nullptr;
+	size_t bytes = 0;
+};
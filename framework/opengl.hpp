@@ -0,0 +1,16 @@
+#pragma once
+
+
+//-------------------------------------------------------
+//	gl 1.1 header of the platform
+//-------------------------------------------------------
+
+// the windows one needs the windows types declared first
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#include <GL/gl.h>
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+#include "profiler.hpp"
+
+
+//-------------------------------------------------------
+//	zones
+//-------------------------------------------------------
+
+namespace Profiler
+{
+	char const* zoneName( Zone zone )
+	{
+		switch ( zone )
+		{
+			case Zone::update:
+				return "update";
+			case Zone::pockets:
+				return "pockets";
+			case Zone::borders:
+				return "borders";
+			case Zone::collisions:
+				return "collisions";
+			case Zone::integration:
+				return "integration";
+			case Zone::draw:
+				return "draw";
+			case Zone::swap:
+				return "swap";
+			case Zone::limiterWait:
+				return "limiter wait";
+			case Zone::count:
+				break;
+		}
+		return "unknown";
+	}
+}
+
+
+#ifdef PROFILER_ENABLED
+
+//-------------------------------------------------------
+//	sample ring
+//-------------------------------------------------------
+
+namespace Profiler
+{
+	namespace
+	{
+		constexpr std::uint64_t ringSize = 8192;
+
+		// every field is atomic so readers racing a writer see a torn slot, never undefined
+		// behaviour, the sequence tells them to skip it: odd while written, 2 * ticket + 2 after
+		struct Slot
+		{
+			std::atomic< std::uint64_t > sequence{ 0 };
+			std::atomic< std::uint64_t > begin{ 0 };
+			std::atomic< std::uint64_t > end{ 0 };
+			std::atomic< std::uint32_t > tag{ 0 };
+		};
+
+
+		struct Sample
+		{
+			std::uint64_t begin;
+			std::uint64_t end;
+			Zone zone;
+			std::uint32_t thread;
+		};
+
+
+		std::array< Slot, ringSize > ring;
+		std::atomic< std::uint64_t > nextTicket{ 0 };
+		std::atomic< std::uint32_t > nextThread{ 0 };
+
+		const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+		// scratch of the queries, which run inside frame ticks and must not allocate,
+		// so they are not safe to call from two threads at once
+		std::array< Sample, ringSize > copies;
+		std::array< float, ringSize > durations;
+
+
+		std::uint32_t threadIndex()
+		{
+			thread_local const std::uint32_t index = nextThread.fetch_add( 1, std::memory_order_relaxed );
+			return index;
+		}
+
+
+		// consistent copies of the slots into copies, oldest first, returns how many
+		size_t snapshot()
+		{
+			size_t count = 0;
+			const std::uint64_t last = nextTicket.load( std::memory_order_acquire );
+			const std::uint64_t first = last > ringSize ? last - ringSize : 0;
+			for ( std::uint64_t ticket = first; ticket < last; ticket++ )
+			{
+				Slot const& slot = ring[ ticket % ringSize ];
+				const std::uint64_t before = slot.sequence.load( std::memory_order_acquire );
+				Sample sample{ slot.begin.load( std::memory_order_relaxed ), slot.end.load( std::memory_order_relaxed ), Zone::count, 0 };
+				const std::uint32_t tag = slot.tag.load( std::memory_order_relaxed );
+				std::atomic_thread_fence( std::memory_order_acquire );
+
+				if ( before != 2 * ticket + 2 || slot.sequence.load( std::memory_order_relaxed ) != before )
+					continue;
+
+				sample.zone = Zone( tag & 0xff );
+				sample.thread = tag >> 8;
+				copies[ count++ ] = sample;
+			}
+			return count;
+		}
+	}
+
+
+	std::uint64_t now()
+	{
+		return std::uint64_t( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - startTime ).count() );
+	}
+
+
+	void record( Zone zone, std::uint64_t begin, std::uint64_t end )
+	{
+		const std::uint64_t ticket = nextTicket.fetch_add( 1, std::memory_order_relaxed );
+		Slot& slot = ring[ ticket % ringSize ];
+
+		slot.sequence.store( 2 * ticket + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+		slot.begin.store( begin, std::memory_order_relaxed );
+		slot.end.store( end, std::memory_order_relaxed );
+		slot.tag.store( std::uint32_t( zone ) | threadIndex() << 8, std::memory_order_relaxed );
+		slot.sequence.store( 2 * ticket + 2, std::memory_order_release );
+	}
+}
+
+
+//-------------------------------------------------------
+//	queries
+//-------------------------------------------------------
+
+namespace Profiler
+{
+	ZoneStats stats( Zone zone )
+	{
+		const size_t samples = snapshot();
+		size_t count = 0;
+		for ( size_t i = 0; i < samples; i++ )
+		{
+			if ( copies[ i ].zone == zone )
+				durations[ count++ ] = float( copies[ i ].end - copies[ i ].begin ) * 1e-6f;
+		}
+
+		ZoneStats result;
+		result.count = int( count );
+		if ( !count )
+			return result;
+
+		float* const first = durations.data();
+		float* const last = first + count;
+		auto percentile = [ first, last, count ]( float fraction )
+		{
+			float* it = first + size_t( fraction * float( count - 1 ) );
+			std::nth_element( first, it, last );
+			return *it;
+		};
+
+		result.p50Ms = percentile( 0.5f );
+		result.p99Ms = percentile( 0.99f );
+		result.maxMs = *std::max_element( first, last );
+		return result;
+	}
+
+
+	bool exportChromeTrace( char const* path )
+	{
+		std::FILE* file = std::fopen( path, "w" );
+		if ( !file )
+			return false;
+
+		std::fputs( "{\"traceEvents\":[", file );
+		bool first = true;
+		const size_t samples = snapshot();
+		for ( size_t i = 0; i < samples; i++ )
+		{
+			Sample const& sample = copies[ i ];
+			// complete events with microsecond timestamps
+			std::fprintf( file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				first ? "" : ",", zoneName( sample.zone ), sample.thread,
+				double( sample.begin ) * 1e-3, double( sample.end - sample.begin ) * 1e-3 );
+			first = false;
+		}
+		std::fputs( "\n]}\n", file );
+
+		return std::fclose( file ) == 0;
+	}
+}
+
+#else
+
+//-------------------------------------------------------
+//	compiled out
+//-------------------------------------------------------
+
+namespace Profiler
+{
+	ZoneStats stats( Zone )
+	{
+		return ZoneStats();
+	}
+
+
+	bool exportChromeTrace( char const* )
+	{
+		return false;
+	}
+
+
+	std::uint64_t now()
+	{
+		return 0;
+	}
+
+
+	void record( Zone, std::uint64_t, std::uint64_t )
+	{
+	}
+}
+
+#endif
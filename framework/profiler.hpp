@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+
+//-------------------------------------------------------
+//	frame profiling
+//-------------------------------------------------------
+
+// Scoped timers write into a lock free ring shared by all threads, statistics and
+// trace export read it back. The queries copy the ring into static scratch, so they
+// do not allocate inside a frame tick but are for one thread at a time. Without
+// PROFILER_ENABLED the scopes expand to nothing and the queries report empty zones.
+namespace Profiler
+{
+	enum class Zone : std::uint8_t
+	{
+		update,
+		pockets,
+		borders,
+		// ball pairs, or the whole event driven step in continuous mode
+		collisions,
+		integration,
+		draw,
+		swap,
+		limiterWait,
+		count
+	};
+
+	char const* zoneName( Zone zone );
+
+
+	// milliseconds over the samples still held by the ring
+	struct ZoneStats
+	{
+		int count = 0;
+		float p50Ms = 0.f;
+		float p99Ms = 0.f;
+		float maxMs = 0.f;
+	};
+
+	ZoneStats stats( Zone zone );
+
+	// chrome://tracing and perfetto json, false when nothing could be written
+	bool exportChromeTrace( char const* path );
+
+	// nanoseconds since the profiler started
+	std::uint64_t now();
+	void record( Zone zone, std::uint64_t begin, std::uint64_t end );
+
+
+	class Scope
+	{
+	public:
+		explicit Scope( Zone zone ) :
+			zone( zone ),
+			begin( now() )
+		{
+		}
+
+		Scope( Scope const& ) = delete;
+
+		~Scope()
+		{
+			record( zone, begin, now() );
+		}
+
+	private:
+		Zone const zone;
+		std::uint64_t const begin;
+	};
+}
+
+
+#define PROFILER_CONCAT_INNER( a, b ) a##b
+#define PROFILER_CONCAT( a, b ) PROFILER_CONCAT_INNER( a, b )
+
+#ifdef PROFILER_ENABLED
+#define PROFILE_SCOPE( zone ) Profiler::Scope PROFILER_CONCAT( profileScope, __LINE__ )( Profiler::Zone::zone )
+#else
+#define PROFILE_SCOPE( zone ) ( ( void )0 )
+#endif
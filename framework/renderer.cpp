@@ -0,0 +1,463 @@
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+#include "opengl.hpp"
+#include "renderer.hpp"
+#include "backend.hpp"
+
+
+//-------------------------------------------------------
+//	gl entry points beyond 1.1
+//-------------------------------------------------------
+
+namespace Renderer
+{
+	namespace
+	{
+		namespace GL
+		{
+			constexpr GLenum arrayBuffer = 0x8892;
+			constexpr GLenum staticDraw = 0x88E4;
+			constexpr GLenum dynamicDraw = 0x88E8;
+			constexpr GLenum vertexShader = 0x8B31;
+			constexpr GLenum fragmentShader = 0x8B30;
+			constexpr GLenum compileStatus = 0x8B81;
+			constexpr GLenum linkStatus = 0x8B82;
+			constexpr GLenum framebuffer = 0x8D40;
+			constexpr GLenum readFramebuffer = 0x8CA8;
+			constexpr GLenum drawFramebuffer = 0x8CA9;
+			constexpr GLenum renderbuffer = 0x8D41;
+			constexpr GLenum colorAttachment0 = 0x8CE0;
+			constexpr GLenum framebufferComplete = 0x8CD5;
+			constexpr GLenum rgba8 = 0x8058;
+
+			void ( APIENTRY *genBuffers )( GLsizei, GLuint* ) = nullptr;
+			void ( APIENTRY *deleteBuffers )( GLsizei, GLuint const* ) = nullptr;
+			void ( APIENTRY *bindBuffer )( GLenum, GLuint ) = nullptr;
+			void ( APIENTRY *bufferData )( GLenum, std::ptrdiff_t, void const*, GLenum ) = nullptr;
+			void ( APIENTRY *bufferSubData )( GLenum, std::ptrdiff_t, std::ptrdiff_t, void const* ) = nullptr;
+			void ( APIENTRY *vertexAttribPointer )( GLuint, GLint, GLenum, GLboolean, GLsizei, void const* ) = nullptr;
+			void ( APIENTRY *enableVertexAttribArray )( GLuint ) = nullptr;
+			void ( APIENTRY *disableVertexAttribArray )( GLuint ) = nullptr;
+			void ( APIENTRY *vertexAttribDivisor )( GLuint, GLuint ) = nullptr;
+			void ( APIENTRY *drawArraysInstanced )( GLenum, GLint, GLsizei, GLsizei ) = nullptr;
+			GLuint ( APIENTRY *createShader )( GLenum ) = nullptr;
+			void ( APIENTRY *shaderSource )( GLuint, GLsizei, char const* const*, GLint const* ) = nullptr;
+			void ( APIENTRY *compileShader )( GLuint ) = nullptr;
+			void ( APIENTRY *getShaderiv )( GLuint, GLenum, GLint* ) = nullptr;
+			GLuint ( APIENTRY *createProgram )() = nullptr;
+			void ( APIENTRY *attachShader )( GLuint, GLuint ) = nullptr;
+			void ( APIENTRY *bindAttribLocation )( GLuint, GLuint, char const* ) = nullptr;
+			void ( APIENTRY *linkProgram )( GLuint ) = nullptr;
+			void ( APIENTRY *getProgramiv )( GLuint, GLenum, GLint* ) = nullptr;
+			void ( APIENTRY *useProgram )( GLuint ) = nullptr;
+			GLint ( APIENTRY *getUniformLocation )( GLuint, char const* ) = nullptr;
+			void ( APIENTRY *uniform2f )( GLint, GLfloat, GLfloat ) = nullptr;
+
+			void ( APIENTRY *genFramebuffers )( GLsizei, GLuint* ) = nullptr;
+			void ( APIENTRY *deleteFramebuffers )( GLsizei, GLuint const* ) = nullptr;
+			void ( APIENTRY *bindFramebuffer )( GLenum, GLuint ) = nullptr;
+			void ( APIENTRY *framebufferRenderbuffer )( GLenum, GLenum, GLenum, GLuint ) = nullptr;
+			GLenum ( APIENTRY *checkFramebufferStatus )( GLenum ) = nullptr;
+			void ( APIENTRY *genRenderbuffers )( GLsizei, GLuint* ) = nullptr;
+			void ( APIENTRY *deleteRenderbuffers )( GLsizei, GLuint const* ) = nullptr;
+			void ( APIENTRY *bindRenderbuffer )( GLenum, GLuint ) = nullptr;
+			void ( APIENTRY *renderbufferStorage )( GLenum, GLenum, GLsizei, GLsizei ) = nullptr;
+			void ( APIENTRY *blitFramebuffer )( GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum ) = nullptr;
+
+
+			template< class Function >
+			bool load( Function& function, char const* name )
+			{
+				function = reinterpret_cast< Function >( Backend::glProcAddress( name ) );
+				return function != nullptr;
+			}
+
+
+			bool loadAll()
+			{
+				return load( genBuffers, "glGenBuffers" ) &&
+					load( deleteBuffers, "glDeleteBuffers" ) &&
+					load( bindBuffer, "glBindBuffer" ) &&
+					load( bufferData, "glBufferData" ) &&
+					load( bufferSubData, "glBufferSubData" ) &&
+					load( vertexAttribPointer, "glVertexAttribPointer" ) &&
+					load( enableVertexAttribArray, "glEnableVertexAttribArray" ) &&
+					load( disableVertexAttribArray, "glDisableVertexAttribArray" ) &&
+					load( vertexAttribDivisor, "glVertexAttribDivisor" ) &&
+					load( drawArraysInstanced, "glDrawArraysInstanced" ) &&
+					load( createShader, "glCreateShader" ) &&
+					load( shaderSource, "glShaderSource" ) &&
+					load( compileShader, "glCompileShader" ) &&
+					load( getShaderiv, "glGetShaderiv" ) &&
+					load( createProgram, "glCreateProgram" ) &&
+					load( attachShader, "glAttachShader" ) &&
+					load( bindAttribLocation, "glBindAttribLocation" ) &&
+					load( linkProgram, "glLinkProgram" ) &&
+					load( getProgramiv, "glGetProgramiv" ) &&
+					load( useProgram, "glUseProgram" ) &&
+					load( getUniformLocation, "glGetUniformLocation" ) &&
+					load( uniform2f, "glUniform2f" );
+			}
+
+
+			// separate from the rest, a context can have instancing without these or the other way round
+			bool loadFramebuffers()
+			{
+				return load( genFramebuffers, "glGenFramebuffers" ) &&
+					load( deleteFramebuffers, "glDeleteFramebuffers" ) &&
+					load( bindFramebuffer, "glBindFramebuffer" ) &&
+					load( framebufferRenderbuffer, "glFramebufferRenderbuffer" ) &&
+					load( checkFramebufferStatus, "glCheckFramebufferStatus" ) &&
+					load( genRenderbuffers, "glGenRenderbuffers" ) &&
+					load( deleteRenderbuffers, "glDeleteRenderbuffers" ) &&
+					load( bindRenderbuffer, "glBindRenderbuffer" ) &&
+					load( renderbufferStorage, "glRenderbufferStorage" ) &&
+					load( blitFramebuffer, "glBlitFramebuffer" );
+			}
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	shared gpu resources
+//-------------------------------------------------------
+
+namespace Renderer
+{
+	namespace
+	{
+		constexpr GLuint unitAttribute = 0;
+		constexpr GLuint instanceAttribute = 1;
+		constexpr GLuint colorAttribute = 2;
+
+		// triangle fan: center plus a closed ring
+		constexpr int circleSegments = 16;
+		constexpr int circleVertices = circleSegments + 2;
+
+		char const* const vertexSource =
+			"#version 120\n"
+			"attribute vec2 unitPosition;\n"
+			"attribute vec3 instance;\n"
+			"attribute vec3 instanceColor;\n"
+			"uniform vec2 viewScale;\n"
+			"varying vec3 color;\n"
+			"void main()\n"
+			"{\n"
+			"	color = instanceColor;\n"
+			"	gl_Position = vec4( ( instance.xy + unitPosition * instance.z ) * viewScale, 0.0, 1.0 );\n"
+			"}\n";
+
+		char const* const fragmentSource =
+			"#version 120\n"
+			"varying vec3 color;\n"
+			"void main()\n"
+			"{\n"
+			"	gl_FragColor = vec4( color, 1.0 );\n"
+			"}\n";
+
+		enum class State
+		{
+			untried,
+			available,
+			unavailable
+		};
+
+		State state = State::untried;
+		GLuint program = 0;
+		GLint viewScaleLocation = -1;
+		GLuint unitCircleBuffer = 0;
+
+
+		GLuint compile( GLenum type, char const* source )
+		{
+			GLuint shader = GL::createShader( type );
+			GL::shaderSource( shader, 1, &source, nullptr );
+			GL::compileShader( shader );
+
+			GLint status = 0;
+			GL::getShaderiv( shader, GL::compileStatus, &status );
+			return status ? shader : 0;
+		}
+
+
+		bool init()
+		{
+			if ( !GL::loadAll() )
+				return false;
+
+			GLuint vertex = compile( GL::vertexShader, vertexSource );
+			GLuint fragment = compile( GL::fragmentShader, fragmentSource );
+			if ( !vertex || !fragment )
+				return false;
+
+			program = GL::createProgram();
+			GL::attachShader( program, vertex );
+			GL::attachShader( program, fragment );
+			GL::bindAttribLocation( program, unitAttribute, "unitPosition" );
+			GL::bindAttribLocation( program, instanceAttribute, "instance" );
+			GL::bindAttribLocation( program, colorAttribute, "instanceColor" );
+			GL::linkProgram( program );
+
+			GLint status = 0;
+			GL::getProgramiv( program, GL::linkStatus, &status );
+			if ( !status )
+				return false;
+
+			viewScaleLocation = GL::getUniformLocation( program, "viewScale" );
+
+			// the only place the circle is evaluated, every instance reuses it
+			float vertices[ 2 * circleVertices ] = { 0.f, 0.f };
+			for ( int i = 0; i <= circleSegments; i++ )
+			{
+				float angle = float( i ) / float( circleSegments ) * 2.f * 3.14159265f;
+				vertices[ 2 + 2 * i ] = std::cos( angle );
+				vertices[ 3 + 2 * i ] = std::sin( angle );
+			}
+
+			GL::genBuffers( 1, &unitCircleBuffer );
+			GL::bindBuffer( GL::arrayBuffer, unitCircleBuffer );
+			GL::bufferData( GL::arrayBuffer, sizeof( vertices ), vertices, GL::staticDraw );
+			GL::bindBuffer( GL::arrayBuffer, 0 );
+			return true;
+		}
+	}
+
+
+	bool isInstancingAvailable()
+	{
+		if ( state == State::untried )
+			state = init() ? State::available : State::unavailable;
+		return state == State::available;
+	}
+}
+
+
+//-------------------------------------------------------
+//	circle batch
+//-------------------------------------------------------
+
+namespace Renderer
+{
+	CircleBatch::~CircleBatch()
+	{
+		// the default scene outlives the gl context
+		if ( buffer && Backend::isContextCurrent() )
+			GL::deleteBuffers( 1, &buffer );
+	}
+
+
+	void CircleBatch::draw( float viewScaleX, float viewScaleY )
+	{
+		if ( instances.empty() || !isInstancingAvailable() )
+			return;
+
+		if ( !buffer )
+			GL::genBuffers( 1, &buffer );
+
+		GL::bindBuffer( GL::arrayBuffer, buffer );
+		if ( dirty )
+		{
+			const size_t size = instances.size() * sizeof( CircleInstance );
+			if ( size > capacity )
+			{
+				capacity = 2 * size;
+				GL::bufferData( GL::arrayBuffer, std::ptrdiff_t( capacity ), nullptr, GL::dynamicDraw );
+			}
+			GL::bufferSubData( GL::arrayBuffer, 0, std::ptrdiff_t( size ), instances.data() );
+			dirty = false;
+		}
+
+		GL::vertexAttribPointer( instanceAttribute, 3, GL_FLOAT, GL_FALSE, sizeof( CircleInstance ), reinterpret_cast< void const* >( offsetof( CircleInstance, x ) ) );
+		GL::vertexAttribPointer( colorAttribute, 3, GL_FLOAT, GL_FALSE, sizeof( CircleInstance ), reinterpret_cast< void const* >( offsetof( CircleInstance, red ) ) );
+		GL::vertexAttribDivisor( instanceAttribute, 1 );
+		GL::vertexAttribDivisor( colorAttribute, 1 );
+		GL::enableVertexAttribArray( instanceAttribute );
+		GL::enableVertexAttribArray( colorAttribute );
+
+		GL::bindBuffer( GL::arrayBuffer, unitCircleBuffer );
+		GL::vertexAttribPointer( unitAttribute, 2, GL_FLOAT, GL_FALSE, 0, nullptr );
+		GL::enableVertexAttribArray( unitAttribute );
+
+		GL::useProgram( program );
+		GL::uniform2f( viewScaleLocation, viewScaleX, viewScaleY );
+		GL::drawArraysInstanced( GL_TRIANGLE_FAN, 0, circleVertices, GLsizei( instances.size() ) );
+		GL::useProgram( 0 );
+
+		// leave the fixed function state as it was for the background and progress bar
+		GL::disableVertexAttribArray( unitAttribute );
+		GL::disableVertexAttribArray( instanceAttribute );
+		GL::disableVertexAttribArray( colorAttribute );
+		GL::vertexAttribDivisor( instanceAttribute, 0 );
+		GL::vertexAttribDivisor( colorAttribute, 0 );
+		GL::bindBuffer( GL::arrayBuffer, 0 );
+	}
+}
+
+
+//-------------------------------------------------------
+//	cached frame
+//-------------------------------------------------------
+
+namespace Renderer
+{
+	namespace
+	{
+		State framebufferState = State::untried;
+		// where a frame ends up, the window unless a render target is bound
+		GLuint presented = 0;
+
+
+		bool isFramebufferAvailable()
+		{
+			if ( framebufferState == State::untried )
+				framebufferState = GL::loadFramebuffers() ? State::available : State::unavailable;
+			return framebufferState == State::available;
+		}
+	}
+
+
+	FrameCache::~FrameCache()
+	{
+		// like the circle batch, the default scene outlives the gl context
+		if ( framebuffer && Backend::isContextCurrent() )
+		{
+			GL::deleteFramebuffers( 1, &framebuffer );
+			GL::deleteRenderbuffers( 1, &colorBuffer );
+		}
+	}
+
+
+	bool FrameCache::begin( int frameWidth, int frameHeight, bool& lost )
+	{
+		lost = true;
+		if ( !isFramebufferAvailable() || frameWidth <= 0 || frameHeight <= 0 )
+			return false;
+
+		if ( !framebuffer )
+		{
+			GL::genFramebuffers( 1, &framebuffer );
+			GL::genRenderbuffers( 1, &colorBuffer );
+		}
+
+		GL::bindFramebuffer( GL::framebuffer, framebuffer );
+		if ( frameWidth == width && frameHeight == height )
+		{
+			lost = false;
+			return true;
+		}
+
+		GL::bindRenderbuffer( GL::renderbuffer, colorBuffer );
+		GL::renderbufferStorage( GL::renderbuffer, GL::rgba8, frameWidth, frameHeight );
+		GL::bindRenderbuffer( GL::renderbuffer, 0 );
+		GL::framebufferRenderbuffer( GL::framebuffer, GL::colorAttachment0, GL::renderbuffer, colorBuffer );
+
+		if ( GL::checkFramebufferStatus( GL::framebuffer ) != GL::framebufferComplete )
+		{
+			// drawing goes straight to the window from now on
+			GL::bindFramebuffer( GL::framebuffer, presented );
+			GL::deleteFramebuffers( 1, &framebuffer );
+			GL::deleteRenderbuffers( 1, &colorBuffer );
+			framebuffer = colorBuffer = 0;
+			framebufferState = State::unavailable;
+			return false;
+		}
+
+		width = frameWidth;
+		height = frameHeight;
+		return true;
+	}
+
+
+	void FrameCache::end()
+	{
+		GL::bindFramebuffer( GL::readFramebuffer, framebuffer );
+		GL::bindFramebuffer( GL::drawFramebuffer, presented );
+		GL::blitFramebuffer( 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+		GL::bindFramebuffer( GL::framebuffer, presented );
+	}
+}
+
+
+//-------------------------------------------------------
+//	offscreen render target
+//-------------------------------------------------------
+
+namespace Renderer
+{
+	RenderTarget::~RenderTarget()
+	{
+		if ( framebuffer && Backend::isContextCurrent() )
+		{
+			unbind();
+			GL::deleteFramebuffers( 1, &framebuffer );
+			GL::deleteRenderbuffers( 1, &colorBuffer );
+		}
+	}
+
+
+	bool RenderTarget::create( int targetWidth, int targetHeight )
+	{
+		if ( framebuffer || !isFramebufferAvailable() || targetWidth <= 0 || targetHeight <= 0 )
+			return false;
+
+		GL::genFramebuffers( 1, &framebuffer );
+		GL::genRenderbuffers( 1, &colorBuffer );
+		GL::bindRenderbuffer( GL::renderbuffer, colorBuffer );
+		GL::renderbufferStorage( GL::renderbuffer, GL::rgba8, targetWidth, targetHeight );
+		GL::bindRenderbuffer( GL::renderbuffer, 0 );
+		GL::bindFramebuffer( GL::framebuffer, framebuffer );
+		GL::framebufferRenderbuffer( GL::framebuffer, GL::colorAttachment0, GL::renderbuffer, colorBuffer );
+
+		const bool complete = GL::checkFramebufferStatus( GL::framebuffer ) == GL::framebufferComplete;
+		GL::bindFramebuffer( GL::framebuffer, presented );
+		if ( !complete )
+		{
+			GL::deleteFramebuffers( 1, &framebuffer );
+			GL::deleteRenderbuffers( 1, &colorBuffer );
+			framebuffer = colorBuffer = 0;
+			return false;
+		}
+
+		width = targetWidth;
+		height = targetHeight;
+		return true;
+	}
+
+
+	void RenderTarget::bind()
+	{
+		presented = framebuffer;
+		GL::bindFramebuffer( GL::framebuffer, framebuffer );
+		glViewport( 0, 0, width, height );
+	}
+
+
+	void RenderTarget::unbind()
+	{
+		if ( presented != framebuffer )
+			return;
+		presented = 0;
+		GL::bindFramebuffer( GL::framebuffer, 0 );
+	}
+
+
+	void RenderTarget::read( std::vector< unsigned char >& rgb ) const
+	{
+		const size_t row = size_t( 3 * width );
+		rgb.resize( row * size_t( height ) );
+		if ( rgb.empty() )
+			return;
+
+		GL::bindFramebuffer( GL::readFramebuffer, framebuffer );
+		glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+		glReadPixels( 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data() );
+		GL::bindFramebuffer( GL::readFramebuffer, presented );
+
+		// gl reads bottom up
+		for ( int top = 0, bottom = height - 1; top < bottom; top++, bottom-- )
+			std::swap_ranges( rgb.begin() + top * row, rgb.begin() + ( top + 1 ) * row, rgb.begin() + bottom * row );
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	engine only interface: instanced circle renderer
+//-------------------------------------------------------
+
+namespace Renderer
+{
+	struct CircleInstance
+	{
+		float x;
+		float y;
+		float radius;
+		float red;
+		float green;
+		float blue;
+	};
+
+
+	// all circles of a scene drawn by one instanced call, the instance buffer
+	// is sent to the gpu only when something was marked dirty
+	class CircleBatch
+	{
+	public:
+		CircleBatch() = default;
+		CircleBatch( CircleBatch const& ) = delete;
+		~CircleBatch();
+
+		void draw( float viewScaleX, float viewScaleY );
+
+		std::vector< CircleInstance > instances;
+		bool dirty = true;
+
+	private:
+		unsigned buffer = 0;
+		size_t capacity = 0;
+	};
+
+
+	// loads the gl entry points and the shader on first use, needs a current context,
+	// when it fails the scene keeps drawing with the fixed function pipeline
+	bool isInstancingAvailable();
+}
+
+
+//-------------------------------------------------------
+//	engine only interface: cached frame
+//-------------------------------------------------------
+
+namespace Renderer
+{
+	// offscreen copy of the last drawn frame, the back buffer is undefined after a swap,
+	// so only a frame drawn here can be patched in the changed parts and presented whole
+	class FrameCache
+	{
+	public:
+		FrameCache() = default;
+		FrameCache( FrameCache const& ) = delete;
+		~FrameCache();
+
+		// redirects drawing into the cache, false without framebuffer objects,
+		// lost is set when the contents are gone and everything has to be drawn
+		bool begin( int width, int height, bool& lost );
+		// copies the cache to the back buffer and draws there again
+		void end();
+
+	private:
+		unsigned framebuffer = 0;
+		unsigned colorBuffer = 0;
+		int width = 0;
+		int height = 0;
+	};
+}
+
+
+//-------------------------------------------------------
+//	engine only interface: offscreen render target
+//-------------------------------------------------------
+
+namespace Renderer
+{
+	// stands in for the window, while it is bound drawing and the frame cache
+	// copies end up here, for runs with nothing on screen
+	class RenderTarget
+	{
+	public:
+		RenderTarget() = default;
+		RenderTarget( RenderTarget const& ) = delete;
+		~RenderTarget();
+
+		// false without framebuffer objects or for a size the driver refuses
+		bool create( int width, int height );
+		// also sets the viewport to the whole target, unbinding goes back to the window
+		void bind();
+		void unbind();
+
+		// three bytes a pixel, top row first
+		void read( std::vector< unsigned char >& rgb ) const;
+
+	private:
+		unsigned framebuffer = 0;
+		unsigned colorBuffer = 0;
+		int width = 0;
+		int height = 0;
+	};
+}
@@ -1,311 +1,899 @@
-
-#define NOMINMAX
-#include <windows.h>
-#include <GL/gl.h>
-
-#include <cassert>
-#include <vector>
-#include <algorithm>
-#include <cmath>
-
-#include "scene.hpp"
-
-
-namespace Scene
-{
-	namespace
-	{
-		namespace View
-		{
-			constexpr float width = 16.f;
-			constexpr float height = 9.f;
-		}
-
-		constexpr float pi = 3.14159265f;
-
-
-		enum class Color
-		{
-			red,
-			green,
-			blue,
-			black,
-			white
-		};
-
-
-		void setupGLColor( Color color )
-		{
-			switch ( color )
-			{
-				case Color::red:
-					glColor3f( 1.f, 0.f, 0.f );
-					break;
-				case Color::green:
-					glColor3f( 0.f, 1.f, 0.f );
-					break;
-				case Color::blue:
-					glColor3f( 0.f, 0.f, 1.f );
-					break;
-				case Color::black:
-					glColor3f( 0.f, 0.f, 0.f );
-					break;
-				case Color::white:
-					glColor3f( 1.f, 1.f, 1.f );
-					break;
-			}
-		}
-	}
-}
-
-
-//-------------------------------------------------------
-//	user interface: common mesh support
-//-------------------------------------------------------
-
-namespace Scene
-{
-	class Mesh
-	{
-	public:
-		float positionX = 0.f;
-		float positionY = 0.f;
-		float angle = 0.f;
-
-		virtual ~Mesh();
-		virtual void draw();
-
-		static std::vector< Mesh* > meshes;
-	};
-
-
-	std::vector< Mesh* > Mesh::meshes;
-
-
-	Mesh::~Mesh()
-	{
-	}
-
-
-	void Mesh::draw()
-	{
-		glLoadIdentity();
-		glTranslatef( positionX, positionY, 0.f );
-		glRotatef( angle * 180.f / pi, 0.f, 0.f, 1.f );
-	}
-
-
-	template< class MeshClass, class... Args >
-	Mesh* createMesh( Args&&... args )
-	{
-		Mesh* mesh = new MeshClass( std::forward< Args >( args )... );
-		Mesh::meshes.push_back( mesh );
-		return mesh;
-	}
-
-
-	void destroyMesh( Mesh* mesh )
-	{
-		auto it = std::find( Mesh::meshes.begin(), Mesh::meshes.end(), mesh );
-		assert( it != Mesh::meshes.end() );
-		Mesh::meshes.erase( it );
-		delete mesh;
-	}
-
-
-	void placeMesh( Mesh* mesh, float x, float y, float angle )
-	{
-		mesh->positionX = x;
-		mesh->positionY = y;
-		mesh->angle = angle;
-	}
-}
-
-
-//-------------------------------------------------------
-//	user interface: ball mesh support
-//-------------------------------------------------------
-
-namespace Scene
-{
-	namespace
-	{
-		class CircleMesh : public Mesh
-		{
-		public:
-			CircleMesh( float radius, Color color );
-			void draw() override;
-
-		private:
-			float const radius;
-			Color const color;
-		};
-
-
-		CircleMesh::CircleMesh( float radius, Color color ) :
-			radius( radius ),
-			color( color )
-		{
-		}
-
-
-		void CircleMesh::draw()
-		{
-			Mesh::draw();
-
-			constexpr int numTriangles = 16;
-
-			glBegin( GL_TRIANGLES );
-			setupGLColor( color );
-			for ( int i = 0; i < numTriangles; i++ )
-			{
-				float angle1 = float( i ) / float( numTriangles ) * 2.f * pi;
-				float angle2 = float( i + 1 ) / float( numTriangles ) * 2.f * pi;
-				glVertex2f( radius * std::cos( angle1 ), radius * std::sin( angle1 ) );
-				glVertex2f( 0.f, 0.f );
-				glVertex2f( radius * std::cos( angle2 ), radius * std::sin( angle2 ) );
-			}
-			glEnd();
-		}
-	}
-
-
-	Mesh *createBallMesh( float radius )
-	{
-		return createMesh< CircleMesh >( radius, Color::white );
-	}
-
-
-	Mesh *createPocketMesh( float radius )
-	{
-		return createMesh< CircleMesh >( radius, Color::red );
-	}
-}
-
-
-//-------------------------------------------------------
-// user interface: frame support
-//-------------------------------------------------------
-
-namespace Scene
-{
-	namespace
-	{
-		namespace Background
-		{
-			float width = 0.f;
-			float height = 0.f;
-
-
-			void draw()
-			{
-				auto drawRectangle = []( float left, float top, float right, float bottom ) -> void
-				{
-					glColor3f( 0.05f, 0.05f, 0.05f );
-					glBegin( GL_TRIANGLE_STRIP );
-					glVertex2f( left, top );
-					glVertex2f( right, top );
-					glVertex2f( left, bottom );
-					glVertex2f( right, bottom );
-					glEnd();
-				};
-
-				constexpr float viewHalfWidth = 0.5f * View::width;
-				constexpr float viewHalfHeight = 0.5f * View::height;
-				const float backHalfWidth = 0.5f * Background::width;
-				const float backHalfHeight = 0.5f * Background::height;
-
-				glLoadIdentity();
-				drawRectangle( -viewHalfWidth, viewHalfHeight, -backHalfWidth, -viewHalfHeight );
-				drawRectangle( backHalfWidth, viewHalfHeight, viewHalfWidth, -viewHalfHeight );
-				drawRectangle( -backHalfWidth, viewHalfHeight,backHalfWidth, backHalfHeight );
-				drawRectangle( -backHalfWidth, -backHalfHeight,backHalfWidth, -viewHalfHeight );
-			}
-		}
-	}
-
-
-	void setupBackground( float width, float height )
-	{
-		Background::width = width;
-		Background::height = height;
-	}
-}
-
-
-//-------------------------------------------------------
-// user interface: progress bar support
-//-------------------------------------------------------
-
-namespace Scene
-{
-	namespace
-	{
-		namespace ProgressBar
-		{
-			float value = 0.f;
-
-			float left = -3.f;
-			float right = 3.f;
-			float top = -4.f;
-			float bottom = -4.5f;
-
-
-			void draw()
-			{
-				glLoadIdentity();
-				glColor3f( 1.f, 0.f, 1.f );
-				glBegin( GL_TRIANGLE_STRIP );
-				glVertex2f( left, top );
-				glVertex2f( left + value * ( right - left ), top );
-				glVertex2f( left, bottom );
-				glVertex2f( left + value * ( right - left ), bottom );
-				glEnd();
-			}
-		}
-	}
-
-
-	void updateProgressBar( float progress )
-	{
-		ProgressBar::value = std::max( std::min( progress, 1.f ), 0.f );
-	}
-}
-
-
-//-------------------------------------------------------
-//	engine only interface
-//-------------------------------------------------------
-
-namespace Scene
-{
-	void draw()
-	{
-		glMatrixMode( GL_PROJECTION );
-		glLoadIdentity();
-		glScalef( 2.f / View::width, 2.f / View::height, 0.f );
-
-		glDisable( GL_CULL_FACE );
-		glClearColor( 0.1f, 0.4f, 0.2f, 0.f );
-		glClear( GL_COLOR_BUFFER_BIT );
-		glMatrixMode( GL_MODELVIEW );
-
-		for ( Mesh *mesh : Mesh::meshes )
-			mesh->draw();
-
-		Background::draw();
-		ProgressBar::draw();
-	}
-
-
-	float screenToWorldX( float x )
-	{
-		return 0.5f * View::width * ( 2.f * x - 1.f );
-	}
-
-
-	float screenToWorldY( float y )
-	{
-		return 0.5f * View::height * ( 2.f * y - 1.f );
-	}
-}
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "opengl.hpp"
+#include "scene.hpp"
+#include "renderer.hpp"
+#include "profiler.hpp"
+#include "framearena.hpp"
+
+
+namespace Scene
+{
+	namespace
+	{
+		namespace View
+		{
+			constexpr float width = 16.f;
+			constexpr float height = 9.f;
+		}
+
+		constexpr float pi = 3.14159265f;
+
+
+		enum class Color
+		{
+			red,
+			green,
+			blue,
+			black,
+			white,
+			yellow
+		};
+
+
+		void colorComponents( Color color, float& red, float& green, float& blue )
+		{
+			red = green = blue = 0.f;
+			switch ( color )
+			{
+				case Color::red:
+					red = 1.f;
+					break;
+				case Color::green:
+					green = 1.f;
+					break;
+				case Color::blue:
+					blue = 1.f;
+					break;
+				case Color::black:
+					break;
+				case Color::white:
+					red = green = blue = 1.f;
+					break;
+				case Color::yellow:
+					red = green = 1.f;
+					break;
+			}
+		}
+
+
+		void setupGLColor( Color color )
+		{
+			float red, green, blue;
+			colorComponents( color, red, green, blue );
+			glColor3f( red, green, blue );
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	user interface: common mesh support
+//-------------------------------------------------------
+
+namespace Scene
+{
+	// part of the view changed since the last drawn frame, in world units
+	struct Damage
+	{
+		bool any = true;
+		bool full = true;
+		float left = 0.f;
+		float bottom = 0.f;
+		float right = 0.f;
+		float top = 0.f;
+
+		void add( float addLeft, float addBottom, float addRight, float addTop )
+		{
+			if ( !any )
+			{
+				any = true;
+				left = addLeft;
+				bottom = addBottom;
+				right = addRight;
+				top = addTop;
+				return;
+			}
+			left = std::min( left, addLeft );
+			bottom = std::min( bottom, addBottom );
+			right = std::max( right, addRight );
+			top = std::max( top, addTop );
+		}
+
+		void addAll()
+		{
+			any = full = true;
+		}
+
+		void clear()
+		{
+			any = full = false;
+		}
+	};
+
+
+	class Mesh
+	{
+	public:
+		float positionX = 0.f;
+		float positionY = 0.f;
+		float angle = 0.f;
+		World* world = nullptr;
+		// handle slot and position in the dense mesh list of the world
+		unsigned slot = 0;
+		int dense = -1;
+		// slot in the world circle batch, negative for meshes drawn one by one
+		int instance = -1;
+
+		virtual ~Mesh();
+		virtual void draw();
+		virtual bool fillInstance( Renderer::CircleInstance& instance ) const;
+		// radius of a circle around the position covering everything drawn, negative when unknown
+		virtual float extent() const;
+		// interleaved points of a path mesh, null for every other mesh
+		virtual std::vector< float >* pathPoints();
+	};
+
+
+	class World
+	{
+	public:
+		World() = default;
+		World( World const& ) = delete;
+		~World();
+
+		// dense, removal swaps the last mesh into the gap
+		std::vector< Mesh* > meshes;
+
+		float backgroundWidth = 0.f;
+		float backgroundHeight = 0.f;
+		float progress = 0.f;
+
+		Renderer::CircleBatch circles;
+		// owner of every circle instance, kept parallel to the batch
+		std::vector< Mesh* > circleMeshes;
+
+		// a new world has never been drawn
+		Damage damage;
+		Renderer::FrameCache frame;
+	};
+
+
+	namespace
+	{
+		// fixed size blocks cut from chunks that live as long as the process,
+		// recreating the table after a reset reuses them instead of going to the heap
+		class MeshPool
+		{
+		public:
+			// the largest mesh is the path with its point vector
+			static constexpr size_t blockSize = 96;
+			static constexpr size_t blocksPerChunk = 256;
+
+			void* allocate();
+			void release( void* block );
+
+		private:
+			union Block
+			{
+				Block* next;
+				alignas( std::max_align_t ) unsigned char storage[ blockSize ];
+			};
+
+			std::vector< std::unique_ptr< Block[] > > chunks;
+			Block* freeList = nullptr;
+		};
+
+
+		void* MeshPool::allocate()
+		{
+			if ( !freeList )
+			{
+				chunks.emplace_back( new Block[ blocksPerChunk ] );
+				Block* chunk = chunks.back().get();
+				for ( size_t i = 0; i < blocksPerChunk; i++ )
+					chunk[ i ].next = i + 1 < blocksPerChunk ? &chunk[ i + 1 ] : nullptr;
+				freeList = chunk;
+			}
+
+			Block* block = freeList;
+			freeList = block->next;
+			return block->storage;
+		}
+
+
+		void MeshPool::release( void* block )
+		{
+			Block* released = static_cast< Block* >( block );
+			released->next = freeList;
+			freeList = released;
+		}
+
+
+		struct MeshSlot
+		{
+			Mesh* mesh = nullptr;
+			// zero is reserved for the null handle
+			unsigned generation = 1;
+		};
+
+
+		// declared before the default world, which releases its meshes on exit
+		MeshPool meshPool;
+		std::vector< MeshSlot > meshSlots;
+		std::vector< unsigned > freeMeshSlots;
+
+		World defaultWorld;
+		World* activeWorld = &defaultWorld;
+
+
+		Mesh* resolve( MeshHandle handle )
+		{
+			if ( handle.slot >= meshSlots.size() )
+				return nullptr;
+
+			MeshSlot const& slot = meshSlots[ handle.slot ];
+			return slot.generation == handle.generation ? slot.mesh : nullptr;
+		}
+
+
+		void releaseMesh( Mesh* mesh )
+		{
+			MeshSlot& slot = meshSlots[ mesh->slot ];
+			slot.mesh = nullptr;
+			if ( !++slot.generation )
+				slot.generation = 1;
+			freeMeshSlots.push_back( mesh->slot );
+
+			mesh->~Mesh();
+			meshPool.release( mesh );
+		}
+
+
+		void damageMesh( Mesh const& mesh )
+		{
+			const float extent = mesh.extent();
+			if ( extent < 0.f )
+				mesh.world->damage.addAll();
+			else
+				mesh.world->damage.add( mesh.positionX - extent, mesh.positionY - extent, mesh.positionX + extent, mesh.positionY + extent );
+		}
+	}
+
+
+	World::~World()
+	{
+		for ( Mesh* mesh : meshes )
+			releaseMesh( mesh );
+	}
+
+
+	World* createWorld()
+	{
+		return new World();
+	}
+
+
+	void destroyWorld( World* world )
+	{
+		assert( world != &defaultWorld );
+		if ( activeWorld == world )
+			setCurrentWorld( nullptr );
+		delete world;
+	}
+
+
+	void setCurrentWorld( World* world )
+	{
+		World* selected = world ? world : &defaultWorld;
+		// the cache holds the picture of the world drawn last, which may be another one
+		if ( selected != activeWorld )
+			selected->damage.addAll();
+		activeWorld = selected;
+	}
+
+
+	World* currentWorld()
+	{
+		return activeWorld;
+	}
+
+
+	Mesh::~Mesh()
+	{
+	}
+
+
+	void Mesh::draw()
+	{
+		glLoadIdentity();
+		glTranslatef( positionX, positionY, 0.f );
+		glRotatef( angle * 180.f / pi, 0.f, 0.f, 1.f );
+	}
+
+
+	bool Mesh::fillInstance( Renderer::CircleInstance& ) const
+	{
+		return false;
+	}
+
+
+	float Mesh::extent() const
+	{
+		return -1.f;
+	}
+
+
+	std::vector< float >* Mesh::pathPoints()
+	{
+		return nullptr;
+	}
+
+
+	template< class MeshClass, class... Args >
+	MeshHandle createMesh( Args&&... args )
+	{
+		static_assert( sizeof( MeshClass ) <= MeshPool::blockSize, "mesh does not fit a pool block" );
+		static_assert( alignof( MeshClass ) <= alignof( std::max_align_t ), "mesh alignment exceeds pool blocks" );
+
+		Mesh* mesh = new ( meshPool.allocate() ) MeshClass( std::forward< Args >( args )... );
+
+		if ( freeMeshSlots.empty() )
+		{
+			freeMeshSlots.push_back( unsigned( meshSlots.size() ) );
+			meshSlots.emplace_back();
+		}
+		mesh->slot = freeMeshSlots.back();
+		freeMeshSlots.pop_back();
+		meshSlots[ mesh->slot ].mesh = mesh;
+
+		World& world = *activeWorld;
+		mesh->world = &world;
+		mesh->dense = int( world.meshes.size() );
+		world.meshes.push_back( mesh );
+
+		Renderer::CircleInstance instance;
+		if ( mesh->fillInstance( instance ) )
+		{
+			mesh->instance = int( world.circles.instances.size() );
+			world.circles.instances.push_back( instance );
+			world.circleMeshes.push_back( mesh );
+			world.circles.dirty = true;
+		}
+
+		damageMesh( *mesh );
+		return MeshHandle{ mesh->slot, meshSlots[ mesh->slot ].generation };
+	}
+
+
+	void destroyMesh( MeshHandle handle )
+	{
+		Mesh* mesh = resolve( handle );
+		assert( mesh );
+		if ( !mesh )
+			return;
+
+		World& world = *mesh->world;
+		damageMesh( *mesh );
+
+		Mesh* last = world.meshes.back();
+		world.meshes[ mesh->dense ] = last;
+		last->dense = mesh->dense;
+		world.meshes.pop_back();
+
+		if ( mesh->instance >= 0 )
+		{
+			Mesh* lastCircle = world.circleMeshes.back();
+			world.circles.instances[ mesh->instance ] = world.circles.instances.back();
+			world.circleMeshes[ mesh->instance ] = lastCircle;
+			lastCircle->instance = mesh->instance;
+			world.circles.instances.pop_back();
+			world.circleMeshes.pop_back();
+			world.circles.dirty = true;
+		}
+
+		releaseMesh( mesh );
+	}
+
+
+	bool isMeshAlive( MeshHandle handle )
+	{
+		return resolve( handle ) != nullptr;
+	}
+
+
+	void placeMesh( MeshHandle handle, float x, float y, float angle )
+	{
+		Mesh* mesh = resolve( handle );
+		assert( mesh );
+		if ( !mesh || ( mesh->positionX == x && mesh->positionY == y && mesh->angle == angle ) )
+			return;
+
+		if ( mesh->instance >= 0 )
+		{
+			Renderer::CircleInstance& instance = mesh->world->circles.instances[ mesh->instance ];
+			instance.x = x;
+			instance.y = y;
+			mesh->world->circles.dirty = true;
+		}
+
+		// where it was and where it is now
+		damageMesh( *mesh );
+		mesh->positionX = x;
+		mesh->positionY = y;
+		mesh->angle = angle;
+		damageMesh( *mesh );
+	}
+}
+
+
+//-------------------------------------------------------
+//	user interface: ball mesh support
+//-------------------------------------------------------
+
+namespace Scene
+{
+	namespace
+	{
+		class CircleMesh : public Mesh
+		{
+		public:
+			CircleMesh( float radius, Color color );
+			void draw() override;
+			bool fillInstance( Renderer::CircleInstance& instance ) const override;
+			float extent() const override;
+
+		private:
+			float const radius;
+			Color const color;
+		};
+
+
+		CircleMesh::CircleMesh( float radius, Color color ) :
+			radius( radius ),
+			color( color )
+		{
+		}
+
+
+		// fixed function fallback, the ring is evaluated once instead of per ball and frame
+		void CircleMesh::draw()
+		{
+			Mesh::draw();
+
+			constexpr int numTriangles = 16;
+
+			struct UnitCircle
+			{
+				float x[ numTriangles + 1 ];
+				float y[ numTriangles + 1 ];
+
+				UnitCircle()
+				{
+					for ( int i = 0; i <= numTriangles; i++ )
+					{
+						float angle = float( i ) / float( numTriangles ) * 2.f * pi;
+						x[ i ] = std::cos( angle );
+						y[ i ] = std::sin( angle );
+					}
+				}
+			};
+			static const UnitCircle unit;
+
+			glBegin( GL_TRIANGLE_FAN );
+			setupGLColor( color );
+			glVertex2f( 0.f, 0.f );
+			for ( int i = 0; i <= numTriangles; i++ )
+				glVertex2f( radius * unit.x[ i ], radius * unit.y[ i ] );
+			glEnd();
+		}
+
+
+		bool CircleMesh::fillInstance( Renderer::CircleInstance& instance ) const
+		{
+			instance.x = positionX;
+			instance.y = positionY;
+			instance.radius = radius;
+			colorComponents( color, instance.red, instance.green, instance.blue );
+			return true;
+		}
+
+
+		float CircleMesh::extent() const
+		{
+			return radius;
+		}
+	}
+
+
+	MeshHandle createBallMesh( float radius )
+	{
+		return createMesh< CircleMesh >( radius, Color::white );
+	}
+
+
+	MeshHandle createPocketMesh( float radius )
+	{
+		return createMesh< CircleMesh >( radius, Color::red );
+	}
+}
+
+
+//-------------------------------------------------------
+//	user interface: path mesh support
+//-------------------------------------------------------
+
+namespace Scene
+{
+	namespace
+	{
+		class PathMesh : public Mesh
+		{
+		public:
+			explicit PathMesh( Color color );
+			void draw() override;
+			float extent() const override;
+			std::vector< float >* pathPoints() override;
+
+		private:
+			std::vector< float > points;
+			Color const color;
+		};
+
+
+		PathMesh::PathMesh( Color color ) :
+			color( color )
+		{
+		}
+
+
+		void PathMesh::draw()
+		{
+			if ( points.size() < 4 )
+				return;
+
+			Mesh::draw();
+			glBegin( GL_LINE_STRIP );
+			setupGLColor( color );
+			for ( size_t i = 0; i < points.size(); i += 2 )
+				glVertex2f( points[ i ], points[ i + 1 ] );
+			glEnd();
+		}
+
+
+		float PathMesh::extent() const
+		{
+			float radius = 0.f;
+			for ( size_t i = 0; i < points.size(); i += 2 )
+				radius = std::max( radius, std::sqrt( points[ i ] * points[ i ] + points[ i + 1 ] * points[ i + 1 ] ) );
+			return radius;
+		}
+
+
+		std::vector< float >* PathMesh::pathPoints()
+		{
+			return &points;
+		}
+	}
+
+
+	MeshHandle createPathMesh()
+	{
+		return createMesh< PathMesh >( Color::yellow );
+	}
+
+
+	void setPathPoints( MeshHandle handle, float const* points, int count )
+	{
+		Mesh* mesh = resolve( handle );
+		assert( mesh && mesh->pathPoints() );
+		if ( !mesh || !mesh->pathPoints() )
+			return;
+
+		std::vector< float >& path = *mesh->pathPoints();
+		if ( path.size() == size_t( 2 * count ) && std::equal( path.begin(), path.end(), points ) )
+			return;
+		// a path longer than any before
+		if ( path.capacity() < size_t( 2 * count ) )
+			FrameArena::allowHeapAllocations();
+
+		// the old path has to go as well as the new one appear
+		damageMesh( *mesh );
+		path.assign( points, points + 2 * count );
+		damageMesh( *mesh );
+	}
+}
+
+
+//-------------------------------------------------------
+// user interface: frame support
+//-------------------------------------------------------
+
+namespace Scene
+{
+	namespace
+	{
+		namespace Background
+		{
+			void draw( World const& world )
+			{
+				auto drawRectangle = []( float left, float top, float right, float bottom ) -> void
+				{
+					glColor3f( 0.05f, 0.05f, 0.05f );
+					glBegin( GL_TRIANGLE_STRIP );
+					glVertex2f( left, top );
+					glVertex2f( right, top );
+					glVertex2f( left, bottom );
+					glVertex2f( right, bottom );
+					glEnd();
+				};
+
+				constexpr float viewHalfWidth = 0.5f * View::width;
+				constexpr float viewHalfHeight = 0.5f * View::height;
+				const float backHalfWidth = 0.5f * world.backgroundWidth;
+				const float backHalfHeight = 0.5f * world.backgroundHeight;
+
+				glLoadIdentity();
+				drawRectangle( -viewHalfWidth, viewHalfHeight, -backHalfWidth, -viewHalfHeight );
+				drawRectangle( backHalfWidth, viewHalfHeight, viewHalfWidth, -viewHalfHeight );
+				drawRectangle( -backHalfWidth, viewHalfHeight,backHalfWidth, backHalfHeight );
+				drawRectangle( -backHalfWidth, -backHalfHeight,backHalfWidth, -viewHalfHeight );
+			}
+		}
+	}
+
+
+	void setupBackground( float width, float height )
+	{
+		if ( activeWorld->backgroundWidth != width || activeWorld->backgroundHeight != height )
+			activeWorld->damage.addAll();
+		activeWorld->backgroundWidth = width;
+		activeWorld->backgroundHeight = height;
+	}
+}
+
+
+//-------------------------------------------------------
+// user interface: progress bar support
+//-------------------------------------------------------
+
+namespace Scene
+{
+	namespace
+	{
+		namespace ProgressBar
+		{
+			float left = -3.f;
+			float right = 3.f;
+			float top = -4.f;
+			float bottom = -4.5f;
+
+
+			void draw( World const& world )
+			{
+				const float value = world.progress;
+
+				glLoadIdentity();
+				glColor3f( 1.f, 0.f, 1.f );
+				glBegin( GL_TRIANGLE_STRIP );
+				glVertex2f( left, top );
+				glVertex2f( left + value * ( right - left ), top );
+				glVertex2f( left, bottom );
+				glVertex2f( left + value * ( right - left ), bottom );
+				glEnd();
+			}
+		}
+	}
+
+
+	void updateProgressBar( float progress )
+	{
+		const float value = std::max( std::min( progress, 1.f ), 0.f );
+		if ( activeWorld->progress == value )
+			return;
+
+		activeWorld->progress = value;
+		activeWorld->damage.add( ProgressBar::left, ProgressBar::bottom, ProgressBar::right, ProgressBar::top );
+	}
+}
+
+
+//-------------------------------------------------------
+// engine interface: profiler overlay support
+//-------------------------------------------------------
+
+namespace Scene
+{
+	namespace
+	{
+		namespace ProfilerOverlay
+		{
+			bool visible = false;
+
+#ifdef PROFILER_ENABLED
+			float left = -7.5f;
+			float top = 4.2f;
+			float rowHeight = 0.3f;
+			// a 60 fps frame budget spans five units
+			float unitsPerMs = 0.3f;
+
+			// percentiles sort the whole ring, so they are refreshed every few frames only
+			constexpr int refreshFrames = 30;
+			int framesUntilRefresh = 0;
+			std::array< Profiler::ZoneStats, size_t( Profiler::Zone::count ) > zones;
+
+
+			void drawBar( float from, float to, float barTop, float barBottom )
+			{
+				glBegin( GL_TRIANGLE_STRIP );
+				glVertex2f( from, barTop );
+				glVertex2f( to, barTop );
+				glVertex2f( from, barBottom );
+				glVertex2f( to, barBottom );
+				glEnd();
+			}
+
+
+			// one row per zone: p99 dim, p50 bright, max as a thin red tick
+			void draw()
+			{
+				if ( !visible )
+					return;
+
+				if ( framesUntilRefresh-- <= 0 )
+				{
+					for ( size_t i = 0; i < zones.size(); i++ )
+						zones[ i ] = Profiler::stats( Profiler::Zone( i ) );
+					framesUntilRefresh = refreshFrames;
+				}
+
+				glLoadIdentity();
+				for ( size_t i = 0; i < zones.size(); i++ )
+				{
+					const float rowTop = top - float( i ) * rowHeight;
+					const float rowBottom = rowTop - 0.8f * rowHeight;
+
+					glColor3f( 0.5f, 0.5f, 0.f );
+					drawBar( left, left + zones[ i ].p99Ms * unitsPerMs, rowTop, rowBottom );
+					glColor3f( 1.f, 1.f, 0.f );
+					drawBar( left, left + zones[ i ].p50Ms * unitsPerMs, rowTop, rowBottom );
+
+					const float maxX = left + zones[ i ].maxMs * unitsPerMs;
+					glColor3f( 1.f, 0.f, 0.f );
+					drawBar( maxX, maxX + 0.05f, rowTop, rowBottom );
+				}
+
+				const float budgetX = left + 1000.f / 60.f * unitsPerMs;
+				glColor3f( 1.f, 1.f, 1.f );
+				drawBar( budgetX, budgetX + 0.03f, top, top - float( zones.size() ) * rowHeight );
+			}
+#else
+			// no zones are measured, there is nothing to show
+			void draw()
+			{
+			}
+#endif
+		}
+	}
+
+
+	void toggleProfilerOverlay()
+	{
+		ProfilerOverlay::visible = !ProfilerOverlay::visible;
+		activeWorld->damage.addAll();
+	}
+}
+
+
+//-------------------------------------------------------
+//	engine only interface
+//-------------------------------------------------------
+
+namespace Scene
+{
+	namespace
+	{
+		// pixels of the viewport covering a world rectangle, with a pixel of margin for antialiasing and rounding
+		void scissorTo( Damage const& damage, GLint const viewport[ 4 ] )
+		{
+			const float scaleX = float( viewport[ 2 ] ) / View::width;
+			const float scaleY = float( viewport[ 3 ] ) / View::height;
+			const int left = int( std::floor( ( damage.left + 0.5f * View::width ) * scaleX ) ) - 1;
+			const int bottom = int( std::floor( ( damage.bottom + 0.5f * View::height ) * scaleY ) ) - 1;
+			const int right = int( std::ceil( ( damage.right + 0.5f * View::width ) * scaleX ) ) + 1;
+			const int top = int( std::ceil( ( damage.top + 0.5f * View::height ) * scaleY ) ) + 1;
+
+			glEnable( GL_SCISSOR_TEST );
+			glScissor( viewport[ 0 ] + left, viewport[ 1 ] + bottom, std::max( right - left, 0 ), std::max( top - bottom, 0 ) );
+		}
+	}
+
+
+	bool draw()
+	{
+		World& world = *activeWorld;
+#ifdef PROFILER_ENABLED
+		// the overlay changes with every frame
+		if ( ProfilerOverlay::visible )
+			world.damage.addAll();
+#endif
+		if ( !world.damage.any )
+			return false;
+
+		GLint viewport[ 4 ];
+		glGetIntegerv( GL_VIEWPORT, viewport );
+
+		// without a cache the back buffer is all there is, and it has to be drawn whole
+		bool lost = true;
+		const bool cached = world.frame.begin( viewport[ 2 ], viewport[ 3 ], lost );
+		if ( lost )
+			world.damage.addAll();
+
+		// everything still goes through the pipeline, the scissor keeps fragments to the changed part
+		const bool partial = !world.damage.full;
+		if ( partial )
+			scissorTo( world.damage, viewport );
+
+		glMatrixMode( GL_PROJECTION );
+		glLoadIdentity();
+		glScalef( 2.f / View::width, 2.f / View::height, 0.f );
+
+		glDisable( GL_CULL_FACE );
+		glClearColor( 0.1f, 0.4f, 0.2f, 0.f );
+		glClear( GL_COLOR_BUFFER_BIT );
+		glMatrixMode( GL_MODELVIEW );
+
+		if ( Renderer::isInstancingAvailable() )
+		{
+			// circles are rotation invariant, everything else still goes one by one
+			activeWorld->circles.draw( 2.f / View::width, 2.f / View::height );
+			for ( Mesh *mesh : activeWorld->meshes )
+			{
+				if ( mesh->instance < 0 )
+					mesh->draw();
+			}
+		}
+		else
+		{
+			for ( Mesh *mesh : activeWorld->meshes )
+				mesh->draw();
+		}
+
+		Background::draw( *activeWorld );
+		ProgressBar::draw( *activeWorld );
+		ProfilerOverlay::draw();
+
+		if ( partial )
+			glDisable( GL_SCISSOR_TEST );
+		if ( cached )
+			world.frame.end();
+		world.damage.clear();
+		return true;
+	}
+
+
+	void invalidate()
+	{
+		activeWorld->damage.addAll();
+	}
+
+
+	float screenToWorldX( float x )
+	{
+		return 0.5f * View::width * ( 2.f * x - 1.f );
+	}
+
+
+	float screenToWorldY( float y )
+	{
+		return 0.5f * View::height * ( 2.f * y - 1.f );
+	}
+}
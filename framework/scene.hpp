@@ -1,33 +1,65 @@
-
-#pragma once
-
-
-//-------------------------------------------------------
-//	user interface
-//-------------------------------------------------------
-
-namespace Scene
-{
-	class Mesh;
-
-	Mesh* createBallMesh( float radius );
-	Mesh* createPocketMesh( float radius );
-	void destroyMesh( Mesh* mesh );
-	void placeMesh( Mesh* mesh, float x, float y, float angle );
-
-	void setupBackground( float width, float height );
-
-	void updateProgressBar( float progress );
-}
-
-
-//-------------------------------------------------------
-//	engine only interface
-//-------------------------------------------------------
-
-namespace Scene
-{
-	void draw();
-	float screenToWorldX( float x );
-	float screenToWorldY( float x );
-}
+
+#pragma once
+
+
+//-------------------------------------------------------
+//	user interface
+//-------------------------------------------------------
+
+namespace Scene
+{
+	class Mesh;
+	class World;
+
+	// generation checked reference to a mesh, a default constructed handle refers to nothing
+	struct MeshHandle
+	{
+		unsigned slot = 0;
+		unsigned generation = 0;
+
+		explicit operator bool() const
+		{
+			return generation != 0;
+		}
+	};
+
+	// meshes, background and progress bar live in a world, calls below go to the current one,
+	// a default world is current until another one is selected
+	World* createWorld();
+	void destroyWorld( World* world );
+	void setCurrentWorld( World* world );
+	World* currentWorld();
+
+	MeshHandle createBallMesh( float radius );
+	MeshHandle createPocketMesh( float radius );
+	void destroyMesh( MeshHandle mesh );
+	// false once the mesh was destroyed, directly or with its world
+	bool isMeshAlive( MeshHandle mesh );
+	void placeMesh( MeshHandle mesh, float x, float y, float angle );
+
+	// open line through points relative to the mesh position, empty until points are set
+	MeshHandle createPathMesh();
+	// count points, x and y interleaved, the mesh keeps a copy
+	void setPathPoints( MeshHandle mesh, float const* points, int count );
+
+	void setupBackground( float width, float height );
+
+	void updateProgressBar( float progress );
+}
+
+
+//-------------------------------------------------------
+//	engine only interface
+//-------------------------------------------------------
+
+namespace Scene
+{
+	// false when nothing changed since the last drawn frame, there is nothing new to present then
+	bool draw();
+	// the next frame is drawn whole, for when the window contents were lost
+	void invalidate();
+	// per zone timing bars, needs a build with PROFILER_ENABLED
+	void toggleProfilerOverlay();
+	float screenToWorldX( float x );
+	float screenToWorldY( float x );
+}
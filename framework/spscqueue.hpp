@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+//-------------------------------------------------------
+//	lock free single producer single consumer queue
+//-------------------------------------------------------
+
+// fixed ring of Capacity slots, one of them is kept free to tell full from empty,
+// each index is written by one side only, so neither side ever waits
+template< class T, size_t Capacity >
+class SpscQueue
+{
+public:
+	static_assert( Capacity >= 2, "the ring needs a free slot" );
+
+	// producer side, false when full
+	bool push( T const& value )
+	{
+		const size_t tail = writeIndex.load( std::memory_order_relaxed );
+		const size_t next = tail + 1 == Capacity ? 0 : tail + 1;
+		if ( next == readIndex.load( std::memory_order_acquire ) )
+			return false;
+
+		slots[ tail ] = value;
+		writeIndex.store( next, std::memory_order_release );
+		return true;
+	}
+
+	// consumer side, false when empty
+	bool pop( T& value )
+	{
+		const size_t head = readIndex.load( std::memory_order_relaxed );
+		if ( head == writeIndex.load( std::memory_order_acquire ) )
+			return false;
+
+		value = slots[ head ];
+		readIndex.store( head + 1 == Capacity ? 0 : head + 1, std::memory_order_release );
+		return true;
+	}
+
+private:
+	std::array< T, Capacity > slots;
+	// apart, so the two sides do not share a cache line
+	alignas( 64 ) std::atomic< size_t > writeIndex{ 0 };
+	alignas( 64 ) std::atomic< size_t > readIndex{ 0 };
+};
@@ -0,0 +1,232 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "udpsocket.hpp"
+
+#ifdef _MSC_VER
+#pragma comment( lib, "ws2_32.lib" )
+#endif
+
+
+//-------------------------------------------------------
+//	platform
+//-------------------------------------------------------
+
+namespace
+{
+#ifdef _WIN32
+	using SocketLength = int;
+
+	// winsock is started with the first socket and stays up for the process
+	bool startNetwork()
+	{
+		static const bool started = []()
+		{
+			WSADATA data;
+			return WSAStartup( MAKEWORD( 2, 2 ), &data ) == 0;
+		}();
+		return started;
+	}
+
+
+	bool setNonBlocking( SOCKET s )
+	{
+		u_long nonBlocking = 1;
+		return ioctlsocket( s, FIONBIO, &nonBlocking ) == 0;
+	}
+
+
+	void closeSocket( SOCKET s )
+	{
+		closesocket( s );
+	}
+
+
+	// a datagram refused by the other end shows up as an error on windows, skip those
+	bool isSkippedError()
+	{
+		const int error = WSAGetLastError();
+		return error == WSAECONNRESET || error == WSAEMSGSIZE;
+	}
+#else
+	using SOCKET = int;
+	using SocketLength = socklen_t;
+	constexpr SOCKET INVALID_SOCKET = -1;
+
+	bool startNetwork()
+	{
+		return true;
+	}
+
+
+	bool setNonBlocking( SOCKET s )
+	{
+		const int flags = fcntl( s, F_GETFL, 0 );
+		return flags >= 0 && fcntl( s, F_SETFL, flags | O_NONBLOCK ) == 0;
+	}
+
+
+	void closeSocket( SOCKET s )
+	{
+		::close( s );
+	}
+
+
+	// a refused datagram of an earlier send and a signal during the call, skip those
+	bool isSkippedError()
+	{
+		return errno == ECONNREFUSED || errno == EINTR;
+	}
+#endif
+}
+
+
+namespace
+{
+	constexpr size_t maxDatagram = 65536;
+
+
+	sockaddr_in socketAddress( UdpAddress const& address )
+	{
+		sockaddr_in result = {};
+		result.sin_family = AF_INET;
+		result.sin_addr.s_addr = htonl( address.ip );
+		result.sin_port = htons( address.port );
+		return result;
+	}
+}
+
+
+//-------------------------------------------------------
+//	addresses
+//-------------------------------------------------------
+
+std::uint64_t UdpAddress::id() const
+{
+	return ( std::uint64_t( ip ) << 16 ) | port;
+}
+
+
+UdpAddress UdpAddress::fromId( std::uint64_t id )
+{
+	UdpAddress address;
+	address.ip = std::uint32_t( id >> 16 );
+	address.port = std::uint16_t( id );
+	return address;
+}
+
+
+bool UdpAddress::resolve( char const* host, std::uint16_t port, UdpAddress& address )
+{
+	if ( !startNetwork() )
+		return false;
+
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	addrinfo* found = nullptr;
+	if ( getaddrinfo( host, nullptr, &hints, &found ) != 0 || !found )
+		return false;
+
+	address.ip = ntohl( reinterpret_cast< sockaddr_in const* >( found->ai_addr )->sin_addr.s_addr );
+	address.port = port;
+	freeaddrinfo( found );
+	return true;
+}
+
+
+//-------------------------------------------------------
+//	socket
+//-------------------------------------------------------
+
+UdpSocket::~UdpSocket()
+{
+	close();
+}
+
+
+bool UdpSocket::open( std::uint16_t port )
+{
+	close();
+	if ( !startNetwork() )
+		return false;
+
+	SOCKET s = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if ( s == INVALID_SOCKET )
+		return false;
+
+	UdpAddress any;
+	any.port = port;
+	sockaddr_in local = socketAddress( any );
+	if ( !setNonBlocking( s ) || bind( s, reinterpret_cast< sockaddr const* >( &local ), sizeof( local ) ) != 0 )
+	{
+		closeSocket( s );
+		return false;
+	}
+
+	handle = std::uintptr_t( s );
+	buffer.resize( maxDatagram );
+	return true;
+}
+
+
+void UdpSocket::close()
+{
+	if ( isOpen() )
+		closeSocket( SOCKET( handle ) );
+	handle = ~std::uintptr_t( 0 );
+}
+
+
+bool UdpSocket::isOpen() const
+{
+	return handle != ~std::uintptr_t( 0 );
+}
+
+
+bool UdpSocket::send( UdpAddress const& to, void const* data, size_t size )
+{
+	if ( !isOpen() )
+		return false;
+
+	sockaddr_in remote = socketAddress( to );
+	return sendto( SOCKET( handle ), static_cast< char const* >( data ), int( size ), 0,
+		reinterpret_cast< sockaddr const* >( &remote ), sizeof( remote ) ) == int( size );
+}
+
+
+bool UdpSocket::receive( UdpAddress& from, std::uint8_t const*& data, size_t& size )
+{
+	if ( !isOpen() )
+		return false;
+
+	for ( ;; )
+	{
+		sockaddr_in remote = {};
+		SocketLength remoteSize = sizeof( remote );
+		int received = recvfrom( SOCKET( handle ), reinterpret_cast< char* >( buffer.data() ), int( buffer.size() ), 0,
+			reinterpret_cast< sockaddr* >( &remote ), &remoteSize );
+		if ( received >= 0 )
+		{
+			data = buffer.data();
+			size = size_t( received );
+			from.ip = ntohl( remote.sin_addr.s_addr );
+			from.port = ntohs( remote.sin_port );
+			return true;
+		}
+
+		if ( !isSkippedError() )
+			return false;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	non blocking udp sockets
+//-------------------------------------------------------
+
+struct UdpAddress
+{
+	// host byte order
+	std::uint32_t ip = 0;
+	std::uint16_t port = 0;
+
+	// packed into one number, used as the peer id of networked matches
+	std::uint64_t id() const;
+	static UdpAddress fromId( std::uint64_t id );
+
+	// ipv4 only, first address of the name
+	static bool resolve( char const* host, std::uint16_t port, UdpAddress& address );
+};
+
+
+class UdpSocket
+{
+public:
+	UdpSocket() = default;
+	UdpSocket( UdpSocket const& ) = delete;
+	~UdpSocket();
+
+	// binds to the port on every interface, port 0 picks a free one
+	bool open( std::uint16_t port = 0 );
+	void close();
+	bool isOpen() const;
+
+	bool send( UdpAddress const& to, void const* data, size_t size );
+	// false when no datagram is waiting, data points into the buffer of the socket
+	// and stays valid until the next receive
+	bool receive( UdpAddress& from, std::uint8_t const*& data, size_t& size );
+
+private:
+	std::uintptr_t handle = ~std::uintptr_t( 0 );
+	// sized once by open, every datagram is received into it
+	std::vector< std::uint8_t > buffer;
+};
@@ -0,0 +1,375 @@
+#ifdef _WIN32
+
+#define NOMINMAX
+#include <cstring>
+#include <windows.h>
+#include <windowsx.h>
+#include <mmsystem.h>
+
+#include "backend.hpp"
+
+#ifdef _MSC_VER
+#pragma comment( lib, "winmm.lib" )
+#pragma comment( lib, "opengl32.lib" )
+#endif
+
+
+//-------------------------------------------------------
+//	clock
+//-------------------------------------------------------
+
+namespace Backend
+{
+	namespace
+	{
+		LONGLONG clockFrequency()
+		{
+			static const LONGLONG frequency = []
+			{
+				LARGE_INTEGER value;
+				QueryPerformanceFrequency( &value );
+				return value.QuadPart;
+			}();
+			return frequency;
+		}
+	}
+
+
+	Ticks now()
+	{
+		LARGE_INTEGER clockTick;
+		QueryPerformanceCounter( &clockTick );
+		return clockTick.QuadPart;
+	}
+
+
+	double secondsBetween( Ticks from, Ticks to )
+	{
+		return double( to - from ) / double( clockFrequency() );
+	}
+}
+
+
+//-------------------------------------------------------
+//	window related stuff
+//-------------------------------------------------------
+
+namespace Backend
+{
+	namespace
+	{
+		HWND windowHandle = nullptr;
+		int windowWidth = 0;
+		int windowHeight = 0;
+		bool closed = false;
+		Handlers handlers;
+
+
+		//-------------------------------------------------------
+		void sendMouse( MouseEvent event, LPARAM lParam )
+		{
+			if ( handlers.mouse )
+				handlers.mouse( event, float( GET_X_LPARAM( lParam ) ) / windowWidth, 1.f - float( GET_Y_LPARAM( lParam ) ) / windowHeight, now() );
+		}
+
+
+		//-------------------------------------------------------
+		void sendKey( Key key )
+		{
+			if ( handlers.keyPressed )
+				handlers.keyPressed( key );
+		}
+
+
+		//-------------------------------------------------------
+		LRESULT CALLBACK windowProcedure( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
+		{
+			switch ( message )
+			{
+				case WM_DESTROY:
+					PostQuitMessage( 0 );
+					break;
+
+				// idle frames would not redraw the lost contents
+				case WM_PAINT:
+					if ( handlers.contentsLost )
+						handlers.contentsLost();
+					break;
+
+				case WM_LBUTTONDOWN:
+				case WM_RBUTTONDOWN:
+				case WM_LBUTTONDBLCLK:
+				case WM_RBUTTONDBLCLK:
+					sendMouse( MouseEvent::pressed, lParam );
+					break;
+
+				case WM_LBUTTONUP:
+				case WM_RBUTTONUP:
+					sendMouse( MouseEvent::released, lParam );
+					break;
+
+				case WM_MOUSEMOVE:
+					sendMouse( MouseEvent::moved, lParam );
+					break;
+
+				case WM_KEYDOWN:
+					if ( wParam == VK_ESCAPE )
+						sendKey( Key::escape );
+					if ( wParam == VK_F1 )
+						sendKey( Key::f1 );
+					if ( wParam == VK_F2 )
+						sendKey( Key::f2 );
+					if ( wParam == VK_SPACE )
+						sendKey( Key::space );
+					break;
+			}
+			return DefWindowProc( hwnd, message, wParam, lParam );
+		}
+
+
+		//-------------------------------------------------------
+		// an offscreen surface is a window never shown, wgl needs one for a context
+		bool initWindow( bool visible, char const* title )
+		{
+			WNDCLASSEXA windowClass;
+
+			windowClass.cbSize = sizeof( windowClass );
+			windowClass.hInstance = GetModuleHandle( nullptr );
+			windowClass.lpszClassName = "MiniBill_WndClass";
+			windowClass.lpfnWndProc = windowProcedure;
+			windowClass.style = CS_DBLCLKS;
+
+			windowClass.hIcon = nullptr;
+			windowClass.hIconSm = nullptr;
+			windowClass.hCursor = LoadCursor( nullptr, IDC_ARROW );
+			windowClass.lpszMenuName = nullptr;
+			windowClass.cbClsExtra = 0;
+			windowClass.cbWndExtra = 0;
+			windowClass.hbrBackground = nullptr;
+
+			RegisterClassExA( &windowClass );
+
+			RECT windowRect;
+			windowRect.left = windowRect.top = 0;
+			windowRect.bottom = windowHeight;
+			windowRect.right = windowWidth;
+			AdjustWindowRect( &windowRect, WS_CAPTION | WS_SYSMENU, FALSE );
+
+			int screenWidth = GetSystemMetrics( SM_CXFULLSCREEN );
+			int screenHeight = GetSystemMetrics( SM_CYFULLSCREEN );
+
+			windowHandle = CreateWindowExA( 0, "MiniBill_WndClass", title, WS_CAPTION | WS_SYSMENU,
+									screenWidth / 2 - windowWidth / 2, screenHeight / 2 - windowHeight / 2, windowRect.right - windowRect.left, windowRect.bottom - windowRect.top,
+									HWND_DESKTOP, nullptr, GetModuleHandle( nullptr ), nullptr );
+			if ( !windowHandle )
+				return false;
+
+			if ( visible )
+				ShowWindow( windowHandle, SW_SHOW );
+			return true;
+		}
+
+
+		//-------------------------------------------------------
+		void deinitWindow()
+		{
+			if ( windowHandle )
+				DestroyWindow( windowHandle );
+			windowHandle = nullptr;
+
+			// the quit message of the destroyed window is not for the next one
+			MSG msg;
+			while ( PeekMessage( &msg, nullptr, 0, 0, PM_REMOVE ) )
+				;
+		}
+	}
+
+
+	bool processEvents()
+	{
+		MSG msg;
+		while ( PeekMessage( &msg, nullptr, 0, 0, PM_REMOVE ) )
+		{
+			if ( msg.message == WM_QUIT )
+				closed = true;
+			TranslateMessage( &msg );
+			DispatchMessage( &msg );
+		}
+		return !closed;
+	}
+
+
+	// the window goes with the context in close
+	void requestClose()
+	{
+		closed = true;
+	}
+}
+
+
+//-------------------------------------------------------
+//	opengl related stuff
+//-------------------------------------------------------
+
+namespace Backend
+{
+	namespace
+	{
+		HDC windowDC = nullptr;
+		HGLRC openGLHandle = nullptr;
+
+		using PFNWGLSWAPINTERVALEXTPROC = BOOL (WINAPI *)( int );
+		PFNWGLSWAPINTERVALEXTPROC wglSwapInterval = nullptr;
+
+
+		//-------------------------------------------------------
+		bool initOGL()
+		{
+			windowDC = GetDC( windowHandle );
+
+			PIXELFORMATDESCRIPTOR pfd;
+			memset( &pfd, 0, sizeof( pfd ) );
+			pfd.nSize = sizeof( pfd );
+			pfd.nVersion = 1;
+			pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+			pfd.iPixelType = PFD_TYPE_RGBA;
+			pfd.iLayerType = PFD_MAIN_PLANE;
+			int npfd = ChoosePixelFormat( windowDC, &pfd );
+
+			memset( &pfd, 0, sizeof( pfd ) );
+			pfd.nSize = sizeof( pfd );
+			SetPixelFormat( windowDC, npfd, &pfd );
+
+			openGLHandle = wglCreateContext( windowDC );
+			if ( !openGLHandle || !wglMakeCurrent( windowDC, openGLHandle ) )
+				return false;
+
+			wglSwapInterval = ( PFNWGLSWAPINTERVALEXTPROC )wglGetProcAddress( "wglSwapIntervalEXT" );
+			return true;
+		}
+
+
+		//-------------------------------------------------------
+		void deinitOGL()
+		{
+			wglMakeCurrent( nullptr, nullptr );
+			if ( openGLHandle )
+				wglDeleteContext( openGLHandle );
+			if ( windowDC )
+				ReleaseDC( windowHandle, windowDC );
+			openGLHandle = nullptr;
+			windowDC = nullptr;
+			wglSwapInterval = nullptr;
+		}
+	}
+
+
+	bool open( Surface surface, int width, int height, char const* title, Handlers const& eventHandlers )
+	{
+		windowWidth = width;
+		windowHeight = height;
+		closed = false;
+		// an offscreen run has no input to report
+		handlers = surface == Surface::window ? eventHandlers : Handlers();
+
+		if ( initWindow( surface == Surface::window, title ) && initOGL() )
+			return true;
+
+		close();
+		return false;
+	}
+
+
+	void close()
+	{
+		deinitOGL();
+		deinitWindow();
+		handlers = Handlers();
+	}
+
+
+	void swapBuffers()
+	{
+		SwapBuffers( windowDC );
+	}
+
+
+	bool setSwapInterval( int interval )
+	{
+		return wglSwapInterval && wglSwapInterval( interval );
+	}
+
+
+	void* glProcAddress( char const* name )
+	{
+		return reinterpret_cast< void* >( wglGetProcAddress( name ) );
+	}
+
+
+	bool isContextCurrent()
+	{
+		return wglGetCurrentContext() != nullptr;
+	}
+}
+
+
+//-------------------------------------------------------
+//	sleeping
+//-------------------------------------------------------
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+
+namespace Backend
+{
+	// the high resolution timer wakes within a fraction of a millisecond, the legacy one
+	// follows the raised system timer resolution and needs a wider spin margin
+	Sleeper::Sleeper()
+	{
+		timer = CreateWaitableTimerExW( nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS );
+		highResolution = timer != nullptr;
+		if ( !highResolution )
+		{
+			timeBeginPeriod( 1 );
+			timer = CreateWaitableTimerExW( nullptr, nullptr, 0, TIMER_ALL_ACCESS );
+		}
+	}
+
+
+	Sleeper::~Sleeper()
+	{
+		if ( timer )
+			CloseHandle( timer );
+		if ( !highResolution )
+			timeEndPeriod( 1 );
+	}
+
+
+	void Sleeper::sleep( double seconds )
+	{
+		if ( !timer || seconds <= 0.0 )
+			return;
+
+		// relative due time in 100 ns units
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -LONGLONG( seconds * 1e7 );
+		if ( SetWaitableTimer( timer, &dueTime, 0, nullptr, nullptr, FALSE ) )
+			WaitForSingleObject( timer, INFINITE );
+	}
+
+
+	double Sleeper::margin() const
+	{
+		return highResolution ? 0.0005 : 0.002;
+	}
+
+
+	void spinPause()
+	{
+		YieldProcessor();
+	}
+}
+
+#endif
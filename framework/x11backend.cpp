@@ -0,0 +1,413 @@
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "backend.hpp"
+
+// link with -lX11 -lEGL, the gl entry points of 1.1 come from -lGL or -lOpenGL
+
+
+//-------------------------------------------------------
+//	clock
+//-------------------------------------------------------
+
+namespace Backend
+{
+	// nanoseconds of the monotonic clock
+	Ticks now()
+	{
+		timespec time;
+		clock_gettime( CLOCK_MONOTONIC, &time );
+		return Ticks( time.tv_sec ) * 1000000000 + time.tv_nsec;
+	}
+
+
+	double secondsBetween( Ticks from, Ticks to )
+	{
+		return double( to - from ) * 1e-9;
+	}
+}
+
+
+//-------------------------------------------------------
+//	window related stuff
+//-------------------------------------------------------
+
+namespace Backend
+{
+	namespace
+	{
+		Display* display = nullptr;
+		Window window = 0;
+		Atom deleteWindow = 0;
+		int windowWidth = 0;
+		int windowHeight = 0;
+		bool closed = false;
+		Handlers handlers;
+
+
+		//-------------------------------------------------------
+		void sendMouse( MouseEvent event, int x, int y )
+		{
+			if ( handlers.mouse )
+				handlers.mouse( event, float( x ) / windowWidth, 1.f - float( y ) / windowHeight, now() );
+		}
+
+
+		//-------------------------------------------------------
+		void sendKey( Key key )
+		{
+			if ( handlers.keyPressed )
+				handlers.keyPressed( key );
+		}
+
+
+		//-------------------------------------------------------
+		void dispatch( XEvent& event )
+		{
+			switch ( event.type )
+			{
+				case ClientMessage:
+					if ( Atom( event.xclient.data.l[ 0 ] ) == deleteWindow )
+						closed = true;
+					break;
+
+				// idle frames would not redraw the lost contents
+				case Expose:
+					if ( handlers.contentsLost )
+						handlers.contentsLost();
+					break;
+
+				// left and right button like on windows, the wheel is buttons 4 and 5
+				case ButtonPress:
+					if ( event.xbutton.button == Button1 || event.xbutton.button == Button3 )
+						sendMouse( MouseEvent::pressed, event.xbutton.x, event.xbutton.y );
+					break;
+
+				case ButtonRelease:
+					if ( event.xbutton.button == Button1 || event.xbutton.button == Button3 )
+						sendMouse( MouseEvent::released, event.xbutton.x, event.xbutton.y );
+					break;
+
+				case MotionNotify:
+					sendMouse( MouseEvent::moved, event.xmotion.x, event.xmotion.y );
+					break;
+
+				case KeyPress:
+				{
+					const KeySym symbol = XLookupKeysym( &event.xkey, 0 );
+					if ( symbol == XK_Escape )
+						sendKey( Key::escape );
+					if ( symbol == XK_F1 )
+						sendKey( Key::f1 );
+					if ( symbol == XK_F2 )
+						sendKey( Key::f2 );
+					if ( symbol == XK_space )
+						sendKey( Key::space );
+					break;
+				}
+			}
+		}
+
+
+		//-------------------------------------------------------
+		// fixed size like the windows one, the visual is the one the egl config asks for
+		bool initWindow( VisualID visualId, char const* title )
+		{
+			XVisualInfo pattern;
+			pattern.visualid = visualId;
+			int count = 0;
+			XVisualInfo* visual = XGetVisualInfo( display, VisualIDMask, &pattern, &count );
+			if ( !visual )
+				return false;
+
+			const Window root = RootWindow( display, visual->screen );
+			XSetWindowAttributes attributes;
+			attributes.colormap = XCreateColormap( display, root, visual->visual, AllocNone );
+			attributes.background_pixmap = None;
+			attributes.border_pixel = 0;
+			attributes.event_mask = ExposureMask | KeyPressMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask;
+
+			window = XCreateWindow( display, root, 0, 0, windowWidth, windowHeight, 0, visual->depth, InputOutput, visual->visual,
+				CWColormap | CWBackPixmap | CWBorderPixel | CWEventMask, &attributes );
+			XFree( visual );
+			if ( !window )
+				return false;
+
+			XSizeHints hints;
+			hints.flags = PMinSize | PMaxSize;
+			hints.min_width = hints.max_width = windowWidth;
+			hints.min_height = hints.max_height = windowHeight;
+			XSetWMNormalHints( display, window, &hints );
+			XStoreName( display, window, title );
+
+			// closing through the window manager is a message instead of a killed connection
+			deleteWindow = XInternAtom( display, "WM_DELETE_WINDOW", False );
+			XSetWMProtocols( display, window, &deleteWindow, 1 );
+
+			XMapWindow( display, window );
+			XFlush( display );
+			return true;
+		}
+
+
+		//-------------------------------------------------------
+		void deinitWindow()
+		{
+			if ( window )
+				XDestroyWindow( display, window );
+			if ( display )
+				XCloseDisplay( display );
+			window = 0;
+			display = nullptr;
+		}
+	}
+
+
+	bool processEvents()
+	{
+		while ( display && XPending( display ) )
+		{
+			XEvent event;
+			XNextEvent( display, &event );
+			dispatch( event );
+		}
+		return !closed;
+	}
+
+
+	void requestClose()
+	{
+		closed = true;
+	}
+}
+
+
+//-------------------------------------------------------
+//	opengl related stuff
+//-------------------------------------------------------
+
+namespace Backend
+{
+	namespace
+	{
+		EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+		EGLSurface eglSurface = EGL_NO_SURFACE;
+		EGLContext eglContext = EGL_NO_CONTEXT;
+
+
+		//-------------------------------------------------------
+		// without an x server, the surfaceless platform of mesa needs no display at all
+		EGLDisplay offscreenDisplay()
+		{
+			auto getPlatformDisplay = reinterpret_cast< PFNEGLGETPLATFORMDISPLAYEXTPROC >( eglGetProcAddress( "eglGetPlatformDisplayEXT" ) );
+			if ( getPlatformDisplay )
+			{
+				EGLDisplay surfaceless = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr );
+				if ( surfaceless != EGL_NO_DISPLAY && eglInitialize( surfaceless, nullptr, nullptr ) )
+					return surfaceless;
+			}
+
+			EGLDisplay fallback = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+			if ( fallback != EGL_NO_DISPLAY && eglInitialize( fallback, nullptr, nullptr ) )
+				return fallback;
+			return EGL_NO_DISPLAY;
+		}
+
+
+		//-------------------------------------------------------
+		bool chooseConfig( EGLint surfaceType, EGLConfig& config )
+		{
+			const EGLint attributes[] =
+			{
+				EGL_SURFACE_TYPE, surfaceType,
+				EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+				EGL_RED_SIZE, 8,
+				EGL_GREEN_SIZE, 8,
+				EGL_BLUE_SIZE, 8,
+				EGL_NONE
+			};
+
+			EGLint count = 0;
+			return eglChooseConfig( eglDisplay, attributes, &config, 1, &count ) && count > 0;
+		}
+
+
+		//-------------------------------------------------------
+		// a compatibility context, the scene draws with the fixed function pipeline
+		bool initContext( EGLConfig config )
+		{
+			eglContext = eglCreateContext( eglDisplay, config, EGL_NO_CONTEXT, nullptr );
+			return eglContext != EGL_NO_CONTEXT && eglMakeCurrent( eglDisplay, eglSurface, eglSurface, eglContext );
+		}
+
+
+		//-------------------------------------------------------
+		bool initWindowed( char const* title )
+		{
+			display = XOpenDisplay( nullptr );
+			if ( !display )
+				return false;
+
+			eglDisplay = eglGetDisplay( reinterpret_cast< EGLNativeDisplayType >( display ) );
+			if ( eglDisplay == EGL_NO_DISPLAY || !eglInitialize( eglDisplay, nullptr, nullptr ) || !eglBindAPI( EGL_OPENGL_API ) )
+				return false;
+
+			EGLConfig config;
+			EGLint visualId = 0;
+			if ( !chooseConfig( EGL_WINDOW_BIT, config ) || !eglGetConfigAttrib( eglDisplay, config, EGL_NATIVE_VISUAL_ID, &visualId ) )
+				return false;
+			if ( !initWindow( VisualID( visualId ), title ) )
+				return false;
+
+			eglSurface = eglCreateWindowSurface( eglDisplay, config, static_cast< EGLNativeWindowType >( window ), nullptr );
+			return eglSurface != EGL_NO_SURFACE && initContext( config );
+		}
+
+
+		//-------------------------------------------------------
+		// the engine draws into a framebuffer object, the surface only has to make the context current,
+		// where pbuffers are missing the context goes current without one
+		bool initOffscreen()
+		{
+			eglDisplay = offscreenDisplay();
+			if ( eglDisplay == EGL_NO_DISPLAY || !eglBindAPI( EGL_OPENGL_API ) )
+				return false;
+
+			EGLConfig config;
+			if ( chooseConfig( EGL_PBUFFER_BIT, config ) )
+			{
+				const EGLint attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+				eglSurface = eglCreatePbufferSurface( eglDisplay, config, attributes );
+				if ( eglSurface != EGL_NO_SURFACE )
+					return initContext( config );
+			}
+
+			return chooseConfig( 0, config ) && initContext( config );
+		}
+
+
+		//-------------------------------------------------------
+		void deinitOGL()
+		{
+			if ( eglDisplay != EGL_NO_DISPLAY )
+			{
+				eglMakeCurrent( eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+				if ( eglContext != EGL_NO_CONTEXT )
+					eglDestroyContext( eglDisplay, eglContext );
+				if ( eglSurface != EGL_NO_SURFACE )
+					eglDestroySurface( eglDisplay, eglSurface );
+				eglTerminate( eglDisplay );
+			}
+			eglDisplay = EGL_NO_DISPLAY;
+			eglSurface = EGL_NO_SURFACE;
+			eglContext = EGL_NO_CONTEXT;
+		}
+	}
+
+
+	bool open( Surface surface, int width, int height, char const* title, Handlers const& eventHandlers )
+	{
+		windowWidth = width;
+		windowHeight = height;
+		closed = false;
+		// an offscreen run has no input to report
+		handlers = surface == Surface::window ? eventHandlers : Handlers();
+
+		if ( surface == Surface::window ? initWindowed( title ) : initOffscreen() )
+			return true;
+
+		close();
+		return false;
+	}
+
+
+	void close()
+	{
+		deinitOGL();
+		deinitWindow();
+		handlers = Handlers();
+	}
+
+
+	void swapBuffers()
+	{
+		if ( eglSurface != EGL_NO_SURFACE )
+			eglSwapBuffers( eglDisplay, eglSurface );
+	}
+
+
+	bool setSwapInterval( int interval )
+	{
+		return window && eglSwapInterval( eglDisplay, interval );
+	}
+
+
+	void* glProcAddress( char const* name )
+	{
+		return reinterpret_cast< void* >( eglGetProcAddress( name ) );
+	}
+
+
+	bool isContextCurrent()
+	{
+		return eglGetCurrentContext() != EGL_NO_CONTEXT;
+	}
+}
+
+
+//-------------------------------------------------------
+//	sleeping
+//-------------------------------------------------------
+
+namespace Backend
+{
+	// nanosleep needs no timer object, the kernel wakes it within tens of microseconds
+	Sleeper::Sleeper()
+	{
+		highResolution = true;
+	}
+
+
+	Sleeper::~Sleeper()
+	{
+	}
+
+
+	void Sleeper::sleep( double seconds )
+	{
+		if ( seconds <= 0.0 )
+			return;
+
+		timespec time;
+		time.tv_sec = time_t( seconds );
+		time.tv_nsec = long( ( seconds - double( time.tv_sec ) ) * 1e9 );
+		while ( clock_nanosleep( CLOCK_MONOTONIC, 0, &time, &time ) == EINTR )
+			;
+	}
+
+
+	double Sleeper::margin() const
+	{
+		return 0.0005;
+	}
+
+
+	void spinPause()
+	{
+#if defined( __x86_64__ ) || defined( __i386__ )
+		__builtin_ia32_pause();
+#elif defined( __aarch64__ )
+		asm volatile( "yield" );
+#endif
+	}
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include <algorithm>
+
+#include "activeset.hpp"
+
+
+namespace Physics
+{
+	void ActiveSet::reset( int balls )
+	{
+		awake.assign( balls, 0 );
+		awakeCount = 0;
+		list.clear();
+		list.reserve( balls );
+		dirty = false;
+	}
+
+
+	void ActiveSet::wake( int ball )
+	{
+		if ( awake[ ball ] )
+			return;
+
+		awake[ ball ] = 1;
+		awakeCount++;
+		list.push_back( ball );
+		dirty = true;
+	}
+
+
+	void ActiveSet::sleep( int ball )
+	{
+		if ( !awake[ ball ] )
+			return;
+
+		// the stale list entry goes on the next compaction
+		awake[ ball ] = 0;
+		awakeCount--;
+		dirty = true;
+	}
+
+
+	bool ActiveSet::isAwake( int ball ) const
+	{
+		return awake[ ball ] != 0;
+	}
+
+
+	int ActiveSet::count() const
+	{
+		return awakeCount;
+	}
+
+
+	std::vector< int > const& ActiveSet::balls() const
+	{
+		if ( dirty )
+		{
+			// a ball put to sleep and woken again sits in the list twice
+			list.erase( std::remove_if( list.begin(), list.end(), [ this ]( int ball ) { return !awake[ ball ]; } ), list.end() );
+			std::sort( list.begin(), list.end() );
+			list.erase( std::unique( list.begin(), list.end() ), list.end() );
+			dirty = false;
+		}
+		return list;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+
+//-------------------------------------------------------
+//	awake balls of a table
+//-------------------------------------------------------
+
+namespace Physics
+{
+	// awake flags plus a list of the awake balls in index order, waking and sleeping are O(1),
+	// the list is compacted and sorted lazily so the iteration order never depends on history
+	class ActiveSet
+	{
+	public:
+		// every ball asleep, the list is sized for all of them
+		void reset( int balls );
+
+		void wake( int ball );
+		void sleep( int ball );
+		bool isAwake( int ball ) const;
+
+		int count() const;
+		std::vector< int > const& balls() const;
+
+	private:
+		std::vector< std::uint8_t > awake;
+		int awakeCount = 0;
+
+		mutable std::vector< int > list;
+		mutable bool dirty = false;
+	};
+}
@@ -0,0 +1,101 @@
+#include <cmath>
+
+#include "aimpreview.hpp"
+#include "shot.hpp"
+#include "params.hpp"
+
+
+AimPreview::AimPreview()
+{
+	cue.reserve( Params::Shot::previewEvents + 1 );
+	object.reserve( 2 );
+}
+
+
+void AimPreview::reserve( int balls )
+{
+	// resized and cleared, which keeps the storage for the copies of the table
+	table.resize( balls );
+	scratch.resize( balls );
+	resolver.reserve( balls );
+	outcome.pocketed.reserve( balls );
+	clear();
+}
+
+
+bool AimPreview::update( Physics::BallStore const& balls, Vector2 target, float charge )
+{
+	if ( charge == shotCharge && target.x == aim.x && target.y == aim.y &&
+		balls.x == table.x && balls.y == table.y && balls.alive == table.alive )
+		return false;
+
+	table = balls;
+	aim = target;
+	shotCharge = charge;
+	trace();
+	return true;
+}
+
+
+void AimPreview::clear()
+{
+	table.resize( 0 );
+	shotCharge = -1.f;
+	cue.clear();
+	object.clear();
+}
+
+
+void AimPreview::trace()
+{
+	cue.clear();
+	object.clear();
+	if ( !table.size() || !table.alive[ 0 ] )
+		return;
+
+	scratch = table;
+	Physics::applyShot< Rules::Pool >( scratch, Physics::aimAt( scratch, aim, shotCharge ) );
+	if ( !scratch.vx[ 0 ] && !scratch.vy[ 0 ] )
+		return;
+
+	outcome.pocketed.clear();
+	outcome.cueBallPocketed = false;
+	outcome.duration = 0.f;
+	outcome.events = 0;
+
+	// every other ball rests until the first contact, so each impact before it is one
+	// of the player ball and adds a corner to its path
+	cue.push_back( { scratch.x[ 0 ], scratch.y[ 0 ] } );
+	resolver.begin( scratch );
+	for ( int events = 0; events < Params::Shot::previewEvents; events++ )
+	{
+		const Physics::Ccd::Event event = resolver.step( scratch, outcome );
+		cue.push_back( { scratch.x[ 0 ], scratch.y[ 0 ] } );
+
+		if ( event.type == Physics::Ccd::EventType::ball )
+		{
+			// the hit ball rolls out straight along its new direction as far as its speed carries it,
+			// the background covers whatever sticks out past the cushions
+			const int hit = event.ball ? event.ball : event.other;
+			const float reach = std::sqrt( scratch.vx[ hit ] * scratch.vx[ hit ] + scratch.vy[ hit ] * scratch.vy[ hit ] ) * 0.5f / Params::Physics::deceleration;
+			object.push_back( { scratch.x[ hit ], scratch.y[ hit ] } );
+			object.push_back( { scratch.x[ hit ] + scratch.vx[ hit ] * reach, scratch.y[ hit ] + scratch.vy[ hit ] * reach } );
+			return;
+		}
+
+		if ( event.type == Physics::Ccd::EventType::none || !scratch.alive[ 0 ] )
+			return;
+	}
+}
+
+
+std::vector< Vector2 > const& AimPreview::cuePath() const
+{
+	return cue;
+}
+
+
+std::vector< Vector2 > const& AimPreview::objectPath() const
+{
+	return object;
+}
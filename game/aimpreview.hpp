@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include "vector2.hpp"
+#include "ballstore.hpp"
+#include "resolver.hpp"
+
+
+//-------------------------------------------------------
+//	aim assist, predicted path of a shot being charged
+//-------------------------------------------------------
+
+// the player ball path up to its first contact with another ball, and the direction
+// the hit ball leaves in, traced by the analytic resolver on a copy of the table,
+// the trace stops at that contact, so it costs a handful of impacts only
+class AimPreview
+{
+public:
+	AimPreview();
+
+	// sizes the copies of a table of that many balls, so tracing does not allocate
+	void reserve( int balls );
+
+	// recomputes only when the table, the target or the charge changed since the
+	// previous call, returns false when the previous result still holds
+	bool update( Physics::BallStore const& balls, Vector2 target, float charge );
+	void clear();
+
+	std::vector< Vector2 > const& cuePath() const;
+	// empty when the player ball reaches no other ball
+	std::vector< Vector2 > const& objectPath() const;
+
+private:
+	void trace();
+
+	// inputs of the current result
+	Physics::BallStore table;
+	Vector2 aim;
+	float shotCharge = -1.f;
+
+	// reused between traces
+	Physics::Resolver resolver;
+	Physics::BallStore scratch;
+	Physics::ShotOutcome outcome;
+
+	std::vector< Vector2 > cue;
+	std::vector< Vector2 > object;
+};
@@ -0,0 +1,46 @@
+#include "ballstore.hpp"
+
+
+//-------------------------------------------------------
+//	ball store
+//-------------------------------------------------------
+
+namespace Physics
+{
+	int BallStore::size() const
+	{
+		return int( x.size() );
+	}
+
+
+	void BallStore::resize( int count )
+	{
+		x.assign( count, 0.f );
+		y.assign( count, 0.f );
+		vx.assign( count, 0.f );
+		vy.assign( count, 0.f );
+		alive.assign( count, 1 );
+	}
+
+
+	void BallStore::assign( std::vector< Vector2 > const& positions )
+	{
+		resize( int( positions.size() ) );
+		for ( int i = 0, n = size(); i < n; i++ )
+		{
+			x[ i ] = positions[ i ].x;
+			y[ i ] = positions[ i ].y;
+		}
+	}
+
+
+	bool BallStore::isMoving() const
+	{
+		for ( int i = 0, n = size(); i < n; i++ )
+		{
+			if ( vx[ i ] != 0.f || vy[ i ] != 0.f )
+				return true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vector2.hpp"
+
+
+//-------------------------------------------------------
+//	ball state storage
+//-------------------------------------------------------
+
+namespace Physics
+{
+	// structure of arrays ball storage, ball 0 is the player ball
+	struct BallStore
+	{
+		std::vector< float > x;
+		std::vector< float > y;
+		std::vector< float > vx;
+		std::vector< float > vy;
+		std::vector< std::uint8_t > alive;
+
+		int size() const;
+		void resize( int count );
+		void assign( std::vector< Vector2 > const& positions );
+
+		bool isMoving() const;
+	};
+}
@@ -0,0 +1,61 @@
+#include "batch.hpp"
+
+
+namespace Physics
+{
+	namespace
+	{
+		// shots per stolen chunk, small enough to balance uneven shot lengths
+		constexpr int shotsPerChunk = 4;
+	}
+
+
+	BatchEvaluator::BatchEvaluator( ThreadPool& pool ) :
+		pool( pool ),
+		resolvers( pool.size() )
+	{
+	}
+
+
+	void BatchEvaluator::reserve( int balls, int count, std::vector< ShotResult >& results )
+	{
+		for ( Resolver& resolver : resolvers )
+			resolver.reserve( balls );
+		pool.reserve( ( count + shotsPerChunk - 1 ) / shotsPerChunk );
+
+		if ( results.size() < size_t( count ) )
+			results.resize( count );
+		for ( ShotResult& result : results )
+		{
+			// sized and not shrunk, the copy of a table onto it then reuses the storage
+			if ( result.balls.size() < balls )
+				result.balls.resize( balls );
+			result.outcome.pocketed.reserve( balls );
+		}
+	}
+
+
+	void BatchEvaluator::evaluate( BallStore const& start, std::vector< Shot > const& shots, std::vector< ShotResult >& results )
+	{
+		results.resize( shots.size() );
+		evaluate( start, shots.data(), int( shots.size() ), results );
+	}
+
+
+	void BatchEvaluator::evaluate( BallStore const& start, Shot const* shots, int count, std::vector< ShotResult >& results )
+	{
+		// never shrunk, the ball storage of every result is kept for the next call
+		if ( results.size() < size_t( count ) )
+			results.resize( count );
+
+		pool.parallelFor( count, shotsPerChunk, [ & ]( int begin, int end, int worker )
+		{
+			Resolver& resolver = resolvers[ worker ];
+			for ( int i = begin; i < end; i++ )
+			{
+				results[ i ].balls = start;
+				resolver.resolve( results[ i ].balls, shots[ i ], results[ i ].outcome );
+			}
+		} );
+	}
+}
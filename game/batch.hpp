@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "ballstore.hpp"
+#include "resolver.hpp"
+#include "shot.hpp"
+#include "threadpool.hpp"
+
+
+//-------------------------------------------------------
+//	parallel evaluation of many shots from one table state
+//-------------------------------------------------------
+
+namespace Physics
+{
+	class BatchEvaluator
+	{
+	public:
+		explicit BatchEvaluator( ThreadPool& pool );
+
+		// sizes every worker and the first count results for a table of that many balls
+		void reserve( int balls, int count, std::vector< ShotResult >& results );
+
+		// results[ i ] is the resting state of shots[ i ], storage of results is reused between calls
+		void evaluate( BallStore const& start, std::vector< Shot > const& shots, std::vector< ShotResult >& results );
+		// the same for shots in any storage, results only grows and its first count entries are the outcomes
+		void evaluate( BallStore const& start, Shot const* shots, int count, std::vector< ShotResult >& results );
+
+	private:
+		ThreadPool& pool;
+		// one resolver per worker, nothing is shared between the workers
+		std::vector< Resolver > resolvers;
+	};
+}
@@ -0,0 +1,146 @@
+#include <cmath>
+#include <algorithm>
+
+#include "broadphase.hpp"
+#include "determinism.hpp"
+#include "params.hpp"
+
+
+namespace Physics
+{
+	BroadPhase::BroadPhase() :
+		BroadPhase( Params::Ball::radius, Params::Table::width, Params::Table::height )
+	{
+	}
+
+
+	BroadPhase::BroadPhase( float ballRadius, float width, float height )
+	{
+		// cells of one diameter guarantee that touching balls are in adjacent cells
+		cellSize = 2.f * ballRadius;
+		columns = int( std::ceil( width / cellSize ) ) + 2;
+		rows = int( std::ceil( height / cellSize ) ) + 2;
+		originX = -0.5f * width - cellSize;
+		originY = -0.5f * height - cellSize;
+	}
+
+
+	void BroadPhase::reserve( int balls )
+	{
+		cellStart.reserve( columns * rows + 1 );
+		cellCursor.reserve( columns * rows + 1 );
+		ballCells.reserve( balls );
+		cellBalls.reserve( balls );
+		candidates.reserve( 4 * balls );
+	}
+
+
+	int BroadPhase::cellOf( float x, float y ) const
+	{
+		int column = std::min( std::max( int( ( x - originX ) / cellSize ), 0 ), columns - 1 );
+		int row = std::min( std::max( int( ( y - originY ) / cellSize ), 0 ), rows - 1 );
+		return row * columns + column;
+	}
+
+
+	void BroadPhase::sortBalls( BallStore const& balls )
+	{
+		const int n = balls.size();
+
+		cellStart.assign( columns * rows + 1, 0 );
+		ballCells.resize( n );
+		cellBalls.resize( n );
+		candidates.clear();
+
+		// counting sort of the alive balls by cell
+		for ( int i = 0; i < n; i++ )
+		{
+			ballCells[ i ] = balls.alive[ i ] ? cellOf( balls.x[ i ], balls.y[ i ] ) : -1;
+			if ( ballCells[ i ] >= 0 )
+				cellStart[ ballCells[ i ] + 1 ]++;
+		}
+
+		for ( int c = 0; c < columns * rows; c++ )
+			cellStart[ c + 1 ] += cellStart[ c ];
+
+		cellCursor.assign( cellStart.begin(), cellStart.end() - 1 );
+		for ( int i = 0; i < n; i++ )
+		{
+			if ( ballCells[ i ] >= 0 )
+				cellBalls[ cellCursor[ ballCells[ i ] ]++ ] = i;
+		}
+	}
+
+
+	void BroadPhase::build( BallStore const& balls )
+	{
+		sortBalls( balls );
+
+		// each ball looks into its own cell and the forward half of the neighbours
+		constexpr int offsets[ 4 ][ 2 ] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+
+		for ( int row = 0; row < rows; row++ )
+		{
+			for ( int column = 0; column < columns; column++ )
+			{
+				const int cell = row * columns + column;
+				for ( int k = cellStart[ cell ]; k < cellStart[ cell + 1 ]; k++ )
+				{
+					const int a = cellBalls[ k ];
+
+					for ( int l = k + 1; l < cellStart[ cell + 1 ]; l++ )
+						candidates.push_back( { a, cellBalls[ l ] } );
+
+					for ( auto const& offset : offsets )
+					{
+						const int nc = column + offset[ 0 ];
+						const int nr = row + offset[ 1 ];
+						if ( nc < 0 || nc >= columns || nr >= rows )
+							continue;
+
+						const int neighbour = nr * columns + nc;
+						for ( int l = cellStart[ neighbour ]; l < cellStart[ neighbour + 1 ]; l++ )
+							candidates.push_back( { a, cellBalls[ l ] } );
+					}
+				}
+			}
+		}
+	}
+
+
+	void BroadPhase::build( BallStore const& balls, ActiveSet const& active )
+	{
+		sortBalls( balls );
+
+		// only awake balls look around, into all nine cells, a pair of two awake balls
+		// is kept from the lower index so it still comes out once
+		for ( int a : active.balls() )
+		{
+			const int cell = ballCells[ a ];
+			if ( cell < 0 )
+				continue;
+
+			const int column = cell % columns;
+			const int row = cell / columns;
+			for ( int nr = std::max( row - 1, 0 ); nr <= std::min( row + 1, rows - 1 ); nr++ )
+			{
+				for ( int nc = std::max( column - 1, 0 ); nc <= std::min( column + 1, columns - 1 ); nc++ )
+				{
+					const int neighbour = nr * columns + nc;
+					for ( int l = cellStart[ neighbour ]; l < cellStart[ neighbour + 1 ]; l++ )
+					{
+						const int b = cellBalls[ l ];
+						if ( b != a && ( !active.isAwake( b ) || a < b ) )
+							candidates.push_back( { a, b } );
+					}
+				}
+			}
+		}
+	}
+
+
+	std::vector< BallPair > const& BroadPhase::pairs() const
+	{
+		return candidates;
+	}
+}
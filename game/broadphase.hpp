@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include "ballstore.hpp"
+#include "activeset.hpp"
+
+
+//-------------------------------------------------------
+//	uniform grid broad phase for ball-ball contacts
+//-------------------------------------------------------
+
+namespace Physics
+{
+	struct BallPair
+	{
+		int a;
+		int b;
+	};
+
+
+	class BroadPhase
+	{
+	public:
+		BroadPhase();
+		BroadPhase( float ballRadius, float width, float height );
+
+		// rebuilds the grid and collects every candidate pair exactly once
+		void build( BallStore const& balls );
+		// same, but only pairs with at least one awake ball, sleeping pairs cannot collide
+		void build( BallStore const& balls, ActiveSet const& active );
+
+		std::vector< BallPair > const& pairs() const;
+
+		// sizes the storage for a table of that many balls, so building does not allocate,
+		// a packed ball has about four forward neighbours
+		void reserve( int balls );
+
+	private:
+		int cellOf( float x, float y ) const;
+		void sortBalls( BallStore const& balls );
+
+		int columns = 0;
+		int rows = 0;
+		float cellSize = 0.f;
+		float originX = 0.f;
+		float originY = 0.f;
+
+		// balls sorted by cell, cellStart[ c ] .. cellStart[ c + 1 ] is cell c
+		std::vector< int > cellStart;
+		std::vector< int > cellBalls;
+		std::vector< int > cellCursor;
+		std::vector< int > ballCells;
+		std::vector< BallPair > candidates;
+	};
+}
@@ -0,0 +1,172 @@
+#include <cstring>
+
+#include "bytestream.hpp"
+
+
+//-------------------------------------------------------
+//	writer
+//-------------------------------------------------------
+
+ByteWriter::ByteWriter( std::vector< std::uint8_t >& buffer ) :
+	buffer( buffer )
+{
+}
+
+
+void ByteWriter::u8( std::uint8_t value )
+{
+	buffer.push_back( value );
+}
+
+
+void ByteWriter::u16( std::uint16_t value )
+{
+	buffer.push_back( std::uint8_t( value ) );
+	buffer.push_back( std::uint8_t( value >> 8 ) );
+}
+
+
+void ByteWriter::u32( std::uint32_t value )
+{
+	for ( int i = 0; i < 4; i++ )
+		buffer.push_back( std::uint8_t( value >> ( 8 * i ) ) );
+}
+
+
+void ByteWriter::f32( float value )
+{
+	std::uint32_t bits;
+	std::memcpy( &bits, &value, sizeof( bits ) );
+	u32( bits );
+}
+
+
+void ByteWriter::varint( std::uint64_t value )
+{
+	while ( value >= 0x80 )
+	{
+		buffer.push_back( std::uint8_t( value | 0x80 ) );
+		value >>= 7;
+	}
+	buffer.push_back( std::uint8_t( value ) );
+}
+
+
+void ByteWriter::zigzag( std::int64_t value )
+{
+	varint( ( std::uint64_t( value ) << 1 ) ^ std::uint64_t( value >> 63 ) );
+}
+
+
+void ByteWriter::bytes( void const* data, size_t size )
+{
+	auto begin = static_cast< std::uint8_t const* >( data );
+	buffer.insert( buffer.end(), begin, begin + size );
+}
+
+
+size_t ByteWriter::size() const
+{
+	return buffer.size();
+}
+
+
+//-------------------------------------------------------
+//	reader
+//-------------------------------------------------------
+
+ByteReader::ByteReader( std::uint8_t const* data, size_t size ) :
+	data( data ),
+	size( size )
+{
+}
+
+
+std::uint8_t ByteReader::u8()
+{
+	if ( offset >= size )
+	{
+		overrun = true;
+		return 0;
+	}
+	return data[ offset++ ];
+}
+
+
+std::uint16_t ByteReader::u16()
+{
+	std::uint16_t value = u8();
+	return std::uint16_t( value | u8() << 8 );
+}
+
+
+std::uint32_t ByteReader::u32()
+{
+	std::uint32_t value = 0;
+	for ( int i = 0; i < 4; i++ )
+		value |= std::uint32_t( u8() ) << ( 8 * i );
+	return value;
+}
+
+
+float ByteReader::f32()
+{
+	std::uint32_t bits = u32();
+	float value;
+	std::memcpy( &value, &bits, sizeof( value ) );
+	return value;
+}
+
+
+std::uint64_t ByteReader::varint()
+{
+	std::uint64_t value = 0;
+	for ( int shift = 0; shift < 64; shift += 7 )
+	{
+		std::uint8_t byte = u8();
+		value |= std::uint64_t( byte & 0x7f ) << shift;
+		if ( !( byte & 0x80 ) )
+			return value;
+	}
+	overrun = true;
+	return value;
+}
+
+
+std::int64_t ByteReader::zigzag()
+{
+	std::uint64_t value = varint();
+	return std::int64_t( value >> 1 ) ^ -std::int64_t( value & 1 );
+}
+
+
+void ByteReader::bytes( void* out, size_t count )
+{
+	if ( count > size - offset )
+	{
+		overrun = true;
+		std::memset( out, 0, count );
+		offset = size;
+		return;
+	}
+	std::memcpy( out, data + offset, count );
+	offset += count;
+}
+
+
+bool ByteReader::failed() const
+{
+	return overrun;
+}
+
+
+bool ByteReader::atEnd() const
+{
+	return offset >= size;
+}
+
+
+size_t ByteReader::position() const
+{
+	return offset;
+}
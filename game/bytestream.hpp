@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	little endian byte streams with varint support
+//-------------------------------------------------------
+
+class ByteWriter
+{
+public:
+	explicit ByteWriter( std::vector< std::uint8_t >& buffer );
+
+	void u8( std::uint8_t value );
+	void u16( std::uint16_t value );
+	void u32( std::uint32_t value );
+	void f32( float value );
+	// 7 bits per byte, small values take one byte
+	void varint( std::uint64_t value );
+	// signed values mapped so small magnitudes stay small
+	void zigzag( std::int64_t value );
+	void bytes( void const* data, size_t size );
+
+	size_t size() const;
+
+private:
+	std::vector< std::uint8_t >& buffer;
+};
+
+
+class ByteReader
+{
+public:
+	ByteReader( std::uint8_t const* data, size_t size );
+
+	std::uint8_t u8();
+	std::uint16_t u16();
+	std::uint32_t u32();
+	float f32();
+	std::uint64_t varint();
+	std::int64_t zigzag();
+	void bytes( void* data, size_t size );
+
+	// reads past the end return zeros and set the failure flag
+	bool failed() const;
+	bool atEnd() const;
+	size_t position() const;
+
+private:
+	std::uint8_t const* data;
+	size_t size;
+	size_t offset = 0;
+	bool overrun = false;
+};
@@ -0,0 +1,423 @@
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+
+#include "ccd.hpp"
+#include "determinism.hpp"
+#include "contacts.hpp"
+#include "kernels.hpp"
+#include "params.hpp"
+
+
+//-------------------------------------------------------
+//	time of impact solvers
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace Ccd
+	{
+		namespace
+		{
+			// earliest non negative root of a t^2 + b t + c = 0, negative when there is none
+			float earliestRoot( float a, float b, float c )
+			{
+				if ( a <= 0.f )
+					return -1.f;
+
+				float discriminant = b * b - 4.f * a * c;
+				if ( discriminant < 0.f )
+					return -1.f;
+
+				return ( -b - std::sqrt( discriminant ) ) / ( 2.f * a );
+			}
+		}
+
+
+		float ballBallTime( BallStore const& balls, int a, int b, float diameter )
+		{
+			float dx = balls.x[ b ] - balls.x[ a ];
+			float dy = balls.y[ b ] - balls.y[ a ];
+			float wx = balls.vx[ b ] - balls.vx[ a ];
+			float wy = balls.vy[ b ] - balls.vy[ a ];
+
+			float approach = dx * wx + dy * wy;
+			if ( approach >= 0.f )
+				return -1.f;
+
+			float c = dx * dx + dy * dy - diameter * diameter;
+			if ( c <= 0.f )
+				return 0.f;
+
+			return earliestRoot( wx * wx + wy * wy, 2.f * approach, c );
+		}
+
+
+		float cushionTime( float position, float velocity, float minPosition, float maxPosition )
+		{
+			if ( velocity < 0.f )
+				return position <= minPosition ? 0.f : ( minPosition - position ) / velocity;
+			if ( velocity > 0.f )
+				return position >= maxPosition ? 0.f : ( maxPosition - position ) / velocity;
+			return -1.f;
+		}
+
+
+		float pocketTime( BallStore const& balls, int ball, float pocketX, float pocketY, float radius )
+		{
+			float dx = balls.x[ ball ] - pocketX;
+			float dy = balls.y[ ball ] - pocketY;
+			float c = dx * dx + dy * dy - radius * radius;
+			if ( c <= 0.f )
+				return 0.f;
+
+			float vx = balls.vx[ ball ];
+			float vy = balls.vy[ ball ];
+			float b = dx * vx + dy * vy;
+			if ( b >= 0.f )
+				return -1.f;
+
+			return earliestRoot( vx * vx + vy * vy, 2.f * b, c );
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	event driven stepper
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace Ccd
+	{
+		// direction agnostic bounds stay valid after cushion bounces within the step
+		template< class R >
+		void BasicStepper< R >::sweep( BallStore const& balls, int i, float horizon )
+		{
+			const float reach = R::ballRadius + std::sqrt( balls.vx[ i ] * balls.vx[ i ] + balls.vy[ i ] * balls.vy[ i ] ) * horizon;
+			sweptMinX[ i ] = balls.x[ i ] - reach;
+			sweptMaxX[ i ] = balls.x[ i ] + reach;
+		}
+
+
+		// overlap across the sweep axis, the y of a ball stays within its reach for the rest of the step
+		template< class R >
+		bool BasicStepper< R >::mayCollide( BallStore const& balls, int a, int b ) const
+		{
+			constexpr float radius = R::ballRadius;
+
+			const float reachA = 0.5f * ( sweptMaxX[ a ] - sweptMinX[ a ] );
+			const float reachB = 0.5f * ( sweptMaxX[ b ] - sweptMinX[ b ] );
+			// at least one of the two has to move for an impact
+			if ( reachA == radius && reachB == radius )
+				return false;
+			return std::abs( balls.y[ a ] - balls.y[ b ] ) <= reachA + reachB;
+		}
+
+
+		// in sweep order, ties broken by index so the pair order is the same with every standard library
+		template< class R >
+		void BasicStepper< R >::addPair( BallStore const& balls, int a, int b )
+		{
+			if ( sweptMinX[ b ] < sweptMinX[ a ] || ( sweptMinX[ b ] == sweptMinX[ a ] && b < a ) )
+				std::swap( a, b );
+			pairA.push_back( a );
+			pairB.push_back( b );
+			pairTimes.push_back( pairTime( balls, a, b ) );
+		}
+
+
+		// time since the start of the step, negative when there is no impact
+		template< class R >
+		float BasicStepper< R >::pairTime( BallStore const& balls, int a, int b ) const
+		{
+			if ( !balls.alive[ a ] || !balls.alive[ b ] )
+				return -1.f;
+
+			const float time = ballBallTime( balls, a, b, Contacts::Table< R >::diameter );
+			return time < 0.f ? time : elapsed + time;
+		}
+
+
+		template< class R >
+		void BasicStepper< R >::updateBall( BallStore const& balls, int i )
+		{
+			constexpr Kernels::Cushions cushions = Contacts::Table< R >::cushions;
+
+			Event& earliest = ballEvents[ i ];
+			earliest = Event();
+			if ( !balls.alive[ i ] || ( balls.vx[ i ] == 0.f && balls.vy[ i ] == 0.f ) )
+				return;
+
+			auto consider = [ &earliest ]( float time, EventType type, int ball, int other )
+			{
+				if ( time >= 0.f && ( time < earliest.time || earliest.type == EventType::none ) )
+				{
+					earliest.time = time;
+					earliest.type = type;
+					earliest.ball = ball;
+					earliest.other = other;
+				}
+			};
+
+			consider( cushionTime( balls.x[ i ], balls.vx[ i ], cushions.minX, cushions.maxX ), EventType::cushionX, i, -1 );
+			consider( cushionTime( balls.y[ i ], balls.vy[ i ], cushions.minY, cushions.maxY ), EventType::cushionY, i, -1 );
+
+			// fixed pocket count, unrolled
+			if constexpr ( Contacts::Table< R >::hasPockets )
+			{
+				for ( int p = 0; p < int( R::pockets.size() ); p++ )
+					consider( pocketTime( balls, i, R::pockets[ p ].x, R::pockets[ p ].y, R::pocketRadius ), EventType::pocket, i, p );
+			}
+
+			if ( earliest.type != EventType::none )
+				earliest.time += elapsed;
+		}
+
+
+		template< class R >
+		void BasicStepper< R >::updatePairsOf( BallStore const& balls, int i )
+		{
+			for ( size_t k = 0; k < pairA.size(); k++ )
+			{
+				if ( pairA[ k ] == i || pairB[ k ] == i )
+					pairTimes[ k ] = pairTime( balls, pairA[ k ], pairB[ k ] );
+			}
+		}
+
+
+		template< class R >
+		void BasicStepper< R >::buildSweptPairs( BallStore const& balls, float horizon )
+		{
+			const int n = balls.size();
+			sweptMinX.resize( n );
+			sweptMaxX.resize( n );
+			ballEvents.resize( n );
+			order.clear();
+			pairA.clear();
+			pairB.clear();
+			pairTimes.clear();
+
+			for ( int i = 0; i < n; i++ )
+			{
+				updateBall( balls, i );
+				if ( !balls.alive[ i ] )
+					continue;
+
+				sweep( balls, i, horizon );
+				order.push_back( i );
+			}
+
+			std::sort( order.begin(), order.end(), [ this ]( int a, int b )
+			{
+				return sweptMinX[ a ] < sweptMinX[ b ] || ( sweptMinX[ a ] == sweptMinX[ b ] && a < b );
+			} );
+
+			for ( size_t k = 0; k < order.size(); k++ )
+			{
+				const int a = order[ k ];
+				for ( size_t l = k + 1; l < order.size() && sweptMinX[ order[ l ] ] <= sweptMaxX[ a ]; l++ )
+				{
+					const int b = order[ l ];
+					if ( mayCollide( balls, a, b ) )
+					{
+						pairA.push_back( a );
+						pairB.push_back( b );
+						pairTimes.push_back( pairTime( balls, a, b ) );
+					}
+				}
+			}
+		}
+
+
+		template< class R >
+		void BasicStepper< R >::resweep( BallStore const& balls, int i, int j, float horizon )
+		{
+			sweep( balls, i, horizon );
+			sweep( balls, j, horizon );
+
+			// compacted in place, the other pairs keep their order and times
+			size_t kept = 0;
+			for ( size_t k = 0; k < pairA.size(); k++ )
+			{
+				const int a = pairA[ k ];
+				const int b = pairB[ k ];
+				if ( a == i || a == j || b == i || b == j )
+					continue;
+				pairA[ kept ] = a;
+				pairB[ kept ] = b;
+				pairTimes[ kept ] = pairTimes[ k ];
+				kept++;
+			}
+			pairA.resize( kept );
+			pairB.resize( kept );
+			pairTimes.resize( kept );
+
+			// order holds every ball alive at the start of the step, no longer sorted for the new bounds
+			auto overlaps = [ this, &balls ]( int a, int b )
+			{
+				return sweptMinX[ b ] <= sweptMaxX[ a ] && sweptMinX[ a ] <= sweptMaxX[ b ] && mayCollide( balls, a, b );
+			};
+			for ( int other : order )
+			{
+				if ( other == i || other == j || !balls.alive[ other ] )
+					continue;
+				if ( overlaps( i, other ) )
+					addPair( balls, i, other );
+				if ( overlaps( j, other ) )
+					addPair( balls, j, other );
+			}
+			if ( overlaps( i, j ) )
+				addPair( balls, i, j );
+		}
+
+
+		// the ball events in ball order before the pairs, the first of equal times wins
+		template< class R >
+		Event BasicStepper< R >::findEarliest( float horizon ) const
+		{
+			Event earliest;
+			earliest.time = horizon;
+
+			for ( Event const& event : ballEvents )
+			{
+				if ( event.type != EventType::none && ( event.time < earliest.time || ( event.time == earliest.time && earliest.type == EventType::none ) ) )
+					earliest = event;
+			}
+
+			for ( size_t k = 0; k < pairTimes.size(); k++ )
+			{
+				const float time = pairTimes[ k ];
+				if ( time >= 0.f && ( time < earliest.time || ( time == earliest.time && earliest.type == EventType::none ) ) )
+				{
+					earliest.time = time;
+					earliest.type = EventType::ball;
+					earliest.ball = pairA[ k ];
+					earliest.other = pairB[ k ];
+				}
+			}
+
+			return earliest;
+		}
+
+
+		template< class R >
+		bool BasicStepper< R >::step( BallStore& balls, float dt )
+		{
+			events = 0;
+			unresolved = 0.f;
+			elapsed = 0.f;
+
+			constexpr float diameter = Contacts::Table< R >::diameter;
+			constexpr Kernels::Cushions cushions = Contacts::Table< R >::cushions;
+
+			buildSweptPairs( balls, dt );
+
+			while ( elapsed < dt )
+			{
+				// a cluster too dense for the budget leaves the rest to the overlap tests of the owner
+				if ( events == Params::Physics::maxEventsPerStep )
+				{
+					unresolved = dt - elapsed;
+					break;
+				}
+
+				Event event = findEarliest( dt );
+				if ( event.type == EventType::none )
+				{
+					Kernels::integrate( balls, dt - elapsed );
+					break;
+				}
+
+				Kernels::integrate( balls, event.time - elapsed );
+				elapsed = event.time;
+				events++;
+
+				const int i = event.ball;
+				switch ( event.type )
+				{
+					case EventType::ball:
+					{
+						const int j = event.other;
+						float dx = balls.x[ j ] - balls.x[ i ];
+						float dy = balls.y[ j ] - balls.y[ i ];
+						float len = std::sqrt( dx * dx + dy * dy );
+						// without a normal there is no approach, solving the pair again drops it
+						if ( len == 0.f )
+						{
+							updatePairsOf( balls, i );
+							break;
+						}
+
+						float nx = dx / len;
+						float ny = dy / len;
+						// only balls that started the step overlapping need to be pushed apart
+						if ( len < diameter )
+						{
+							balls.x[ i ] -= nx * ( diameter - len );
+							balls.y[ i ] -= ny * ( diameter - len );
+						}
+						Contacts::exchange< R >( balls, i, j, nx, ny );
+
+						// the exchange can speed the two up beyond their swept bounds
+						resweep( balls, i, j, dt - elapsed );
+						updateBall( balls, i );
+						updateBall( balls, j );
+						break;
+					}
+
+					case EventType::cushionX:
+						balls.x[ i ] = std::min( std::max( balls.x[ i ], cushions.minX ), cushions.maxX );
+						Contacts::bounce( balls.vx[ i ], balls.vy[ i ], cushions.loss );
+						updateBall( balls, i );
+						updatePairsOf( balls, i );
+						break;
+
+					case EventType::cushionY:
+						balls.y[ i ] = std::min( std::max( balls.y[ i ], cushions.minY ), cushions.maxY );
+						Contacts::bounce( balls.vy[ i ], balls.vx[ i ], cushions.loss );
+						updateBall( balls, i );
+						updatePairsOf( balls, i );
+						break;
+
+					case EventType::pocket:
+						balls.alive[ i ] = 0;
+						balls.vx[ i ] = 0.f;
+						balls.vy[ i ] = 0.f;
+						if ( !i )
+							return false;
+						updateBall( balls, i );
+						updatePairsOf( balls, i );
+						break;
+
+					case EventType::none:
+						break;
+				}
+			}
+
+			Kernels::applyFriction( balls, R::deceleration, dt - unresolved );
+			return true;
+		}
+
+
+		template< class R >
+		int BasicStepper< R >::eventCount() const
+		{
+			return events;
+		}
+
+
+		template< class R >
+		float BasicStepper< R >::unresolvedTime() const
+		{
+			return unresolved;
+		}
+
+
+		template class BasicStepper< Rules::Pool >;
+		template class BasicStepper< Rules::Snooker >;
+		template class BasicStepper< Rules::Carom >;
+		template class BasicStepper< Rules::Elastic >;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+
+#include "ballstore.hpp"
+#include "rules.hpp"
+
+
+//-------------------------------------------------------
+//	continuous collision detection, event driven stepping
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace Ccd
+	{
+		enum class EventType
+		{
+			none,
+			ball,
+			cushionX,
+			cushionY,
+			pocket
+		};
+
+
+		struct Event
+		{
+			float time = 0.f;
+			EventType type = EventType::none;
+			int ball = -1;
+			// other ball or pocket index
+			int other = -1;
+		};
+
+
+		// time of impact assuming constant velocities, negative when there is no impact
+		float ballBallTime( BallStore const& balls, int a, int b, float diameter );
+		float cushionTime( float position, float velocity, float minPosition, float maxPosition );
+		float pocketTime( BallStore const& balls, int ball, float pocketX, float pocketY, float radius );
+
+
+		// instantiated in ccd.cpp for every rule set
+		template< class R >
+		class BasicStepper
+		{
+		public:
+			// advances straight from impact to impact, returns false when the player ball drops into a pocket
+			bool step( BallStore& balls, float dt );
+
+			// number of impacts resolved by the last step
+			int eventCount() const;
+			// end of the last step left to the discrete phases once the impacts ran out, 0 when none
+			float unresolvedTime() const;
+
+		private:
+			// event times are cached from the start of the step, the balls move in straight
+			// lines in between, so only the balls of an impact need their times solved again
+			Event findEarliest( float horizon ) const;
+			void buildSweptPairs( BallStore const& balls, float horizon );
+			// only the two balls of an impact change speed, the bounds and pairs of the rest still hold
+			void resweep( BallStore const& balls, int i, int j, float horizon );
+			void sweep( BallStore const& balls, int i, float horizon );
+			bool mayCollide( BallStore const& balls, int a, int b ) const;
+			void addPair( BallStore const& balls, int a, int b );
+			// earliest cushion or pocket impact of a ball, and the impacts of the pairs it is in
+			void updateBall( BallStore const& balls, int i );
+			void updatePairsOf( BallStore const& balls, int i );
+			float pairTime( BallStore const& balls, int a, int b ) const;
+
+			std::vector< int > order;
+			std::vector< float > sweptMinX;
+			std::vector< float > sweptMaxX;
+			std::vector< int > pairA;
+			std::vector< int > pairB;
+			std::vector< float > pairTimes;
+			std::vector< Event > ballEvents;
+			float elapsed = 0.f;
+			int events = 0;
+			float unresolved = 0.f;
+		};
+
+
+		using Stepper = BasicStepper< Rules::Pool >;
+	}
+}
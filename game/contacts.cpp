@@ -0,0 +1,19 @@
+#include <cmath>
+
+#include "contacts.hpp"
+#include "determinism.hpp"
+
+
+namespace Physics
+{
+	namespace Contacts
+	{
+		void bounce( float& vNormal, float& vTangent, float loss )
+		{
+			float speed = std::sqrt( vNormal * vNormal + vTangent * vTangent );
+			float scale = speed > 0.f ? 1.f - loss * ( 1.f + std::abs( vNormal ) / speed ) : 0.f;
+			vNormal *= -scale;
+			vTangent *= scale;
+		}
+	}
+}
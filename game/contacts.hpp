@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ballstore.hpp"
+#include "determinism.hpp"
+#include "kernels.hpp"
+#include "rules.hpp"
+
+
+//-------------------------------------------------------
+//	collision responses shared by the discrete and continuous steppers
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace Contacts
+	{
+		// derived constants of a rule set
+		template< class R >
+		struct Table
+		{
+			static constexpr float diameter = 2.f * R::ballRadius;
+			// share of the normal approach speed two balls part with, the same exchange gives
+			static constexpr float restitution = R::ballRestitution * ( 2.f * R::ballTransfer - 1.f );
+			// a carom table has nothing to capture a ball, the pocket phases compile away
+			static constexpr bool hasPockets = R::pockets.size() > 0 && R::pocketRadius > 0.f;
+
+			static constexpr Kernels::Cushions cushions =
+			{
+				-0.5f * R::width + R::ballRadius,
+				0.5f * R::width - R::ballRadius,
+				-0.5f * R::height + R::ballRadius,
+				0.5f * R::height - R::ballRadius,
+				R::cushionLoss
+			};
+		};
+
+		// velocity exchange of two touching balls, n is the unit normal from a to b
+		template< class R >
+		void exchange( BallStore& balls, int a, int b, float nx, float ny );
+
+		// the part of exchange a normal impulse with Table< R >::restitution leaves out,
+		// the common speed of the pair lost to restitution and the tangent transfer
+		template< class R >
+		void dampImpact( BallStore& balls, int a, int b, float nx, float ny );
+
+		// reflection off a cushion, the loss grows with the normal part of the velocity
+		void bounce( float& vNormal, float& vTangent, float loss );
+	}
+}
+
+
+// defined here for the rule set instantiations, after the fp contraction pragmas
+namespace Physics
+{
+	namespace Contacts
+	{
+		template< class R >
+		inline void exchange( BallStore& balls, int a, int b, float nx, float ny )
+		{
+			constexpr float transfer = R::ballTransfer;
+			constexpr float restitution = R::ballRestitution;
+
+			// split velocities into normal and tangent parts relative to the contact
+			float vn1 = balls.vx[ a ] * nx + balls.vy[ a ] * ny;
+			float vn2 = balls.vx[ b ] * nx + balls.vy[ b ] * ny;
+			float vt1 = -balls.vx[ a ] * ny + balls.vy[ a ] * nx;
+			float vt2 = -balls.vx[ b ] * ny + balls.vy[ b ] * nx;
+
+			// most of the normal part is exchanged, the tangent part mostly stays
+			float n1 = restitution * ( transfer * vn2 + ( 1.f - transfer ) * vn1 );
+			float t1 = restitution * ( transfer * vt1 + ( 1.f - transfer ) * vt2 );
+			float n2 = restitution * ( transfer * vn1 + ( 1.f - transfer ) * vn2 );
+			float t2 = restitution * ( transfer * vt2 + ( 1.f - transfer ) * vt1 );
+
+			balls.vx[ a ] = n1 * nx - t1 * ny;
+			balls.vy[ a ] = n1 * ny + t1 * nx;
+			balls.vx[ b ] = n2 * nx - t2 * ny;
+			balls.vy[ b ] = n2 * ny + t2 * nx;
+		}
+
+
+		template< class R >
+		inline void dampImpact( BallStore& balls, int a, int b, float nx, float ny )
+		{
+			constexpr float transfer = R::ballTransfer;
+			constexpr float restitution = R::ballRestitution;
+
+			float vn1 = balls.vx[ a ] * nx + balls.vy[ a ] * ny;
+			float vn2 = balls.vx[ b ] * nx + balls.vy[ b ] * ny;
+			float vt1 = -balls.vx[ a ] * ny + balls.vy[ a ] * nx;
+			float vt2 = -balls.vx[ b ] * ny + balls.vy[ b ] * nx;
+
+			// the normal difference is the impulse's business, only the mean is scaled
+			float dn = ( restitution - 1.f ) * 0.5f * ( vn1 + vn2 );
+			float t1 = restitution * ( transfer * vt1 + ( 1.f - transfer ) * vt2 );
+			float t2 = restitution * ( transfer * vt2 + ( 1.f - transfer ) * vt1 );
+
+			balls.vx[ a ] = ( vn1 + dn ) * nx - t1 * ny;
+			balls.vy[ a ] = ( vn1 + dn ) * ny + t1 * nx;
+			balls.vx[ b ] = ( vn2 + dn ) * nx - t2 * ny;
+			balls.vy[ b ] = ( vn2 + dn ) * ny + t2 * nx;
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#include <cstring>
+
+#include "determinism.hpp"
+
+
+namespace Physics
+{
+	namespace Determinism
+	{
+		namespace
+		{
+			constexpr std::uint64_t fnvOffset = 14695981039346656037ull;
+			constexpr std::uint64_t fnvPrime = 1099511628211ull;
+
+			void mix( std::uint64_t& hash, void const* data, size_t size )
+			{
+				auto bytes = static_cast< unsigned char const* >( data );
+				for ( size_t i = 0; i < size; i++ )
+				{
+					hash ^= bytes[ i ];
+					hash *= fnvPrime;
+				}
+			}
+		}
+
+
+		std::uint64_t hash( BallStore const& balls )
+		{
+			// fixed width count, size_t would hash differently on 32 and 64 bit builds
+			const std::uint32_t n = std::uint32_t( balls.size() );
+
+			std::uint64_t result = fnvOffset;
+			mix( result, &n, sizeof( n ) );
+			mix( result, balls.x.data(), n * sizeof( float ) );
+			mix( result, balls.y.data(), n * sizeof( float ) );
+			mix( result, balls.vx.data(), n * sizeof( float ) );
+			mix( result, balls.vy.data(), n * sizeof( float ) );
+			mix( result, balls.alive.data(), n );
+			return result;
+		}
+
+
+		void sinCos( float angle, float& sine, float& cosine )
+		{
+			// pi / 2 split in three parts so the reduction stays exact for moderate angles
+			constexpr float halfPi1 = 1.5703125f;
+			constexpr float halfPi2 = 4.837512969970703125e-4f;
+			constexpr float halfPi3 = 7.54978995489188216e-8f;
+			constexpr float twoOverPi = 0.636619772367581343f;
+
+			const float scaled = angle * twoOverPi;
+			const int quadrant = int( scaled >= 0.f ? scaled + 0.5f : scaled - 0.5f );
+			const float k = float( quadrant );
+			const float r = ( ( angle - k * halfPi1 ) - k * halfPi2 ) - k * halfPi3;
+			const float z = r * r;
+
+			// minimax polynomials on [ -pi / 4, pi / 4 ]
+			const float s = r + r * z * ( -1.6666654611e-1f + z * ( 8.3321608736e-3f + z * -1.9515295891e-4f ) );
+			const float c = 1.f - 0.5f * z + z * z * ( 4.166664568298827e-2f + z * ( -1.388731625493765e-3f + z * 2.443315711809948e-5f ) );
+
+			switch ( quadrant & 3 )
+			{
+				case 0: sine = s; cosine = c; break;
+				case 1: sine = c; cosine = -s; break;
+				case 2: sine = -s; cosine = -c; break;
+				default: sine = -c; cosine = s; break;
+			}
+		}
+	}
+}
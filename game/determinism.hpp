@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ballstore.hpp"
+
+
+//-------------------------------------------------------
+//	bit reproducible simulation support
+//-------------------------------------------------------
+
+// The step only uses + - * / and sqrt on floats, all correctly rounded by IEEE 754,
+// so results match across machines as long as the compiler keeps the written order:
+// no fused multiply-add contraction, no fast-math, no x87 excess precision.
+// The pragmas below turn contraction off for every function defined after this
+// header on msvc and clang. Gcc fuses by default on fma targets such as -mfma and
+// has no pragma fit for release builds, so there the physics sources and whatever
+// steps them are required to be compiled with -ffp-contract=off.
+#if defined( _MSC_VER )
+	#pragma fp_contract( off )
+#elif defined( __clang__ )
+	#pragma STDC FP_CONTRACT OFF
+#endif
+
+
+namespace Physics
+{
+	namespace Determinism
+	{
+		// 64 bit FNV-1a over the exact bit patterns of the ball state
+		std::uint64_t hash( BallStore const& balls );
+
+		// polynomial sine and cosine, no libm calls so every platform gets the same bits
+		void sinCos( float angle, float& sine, float& cosine );
+	}
+}
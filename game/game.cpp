@@ -1,390 +1,429 @@
-
-#include <cassert>
-#include <cmath>
-#include <array>
-
-#include "../framework/scene.hpp"
-#include "../framework/game.hpp"
-#include "../framework/engine.hpp"
-
-//-------------------------------------------------------
-//	Basic Vector2 class
-//-------------------------------------------------------
-
-class Vector2
-{
-public:
-	float x = 0.f;
-	float y = 0.f;
-
-	constexpr Vector2() = default;
-	constexpr Vector2( float vx, float vy );
-	constexpr Vector2( Vector2 const &other ) = default;
-
-	float length() const;
-	void normalize();
-	void invertY();
-	void invertX();
-};
-
-
-constexpr Vector2::Vector2( float vx, float vy ) :
-	x( vx ),
-	y( vy )
-{
-}
-
-float Vector2::length() const
-{
-	return pow(x * x + y * y, 0.5);
-}
-
-void Vector2::normalize() 
-{
-	float len = this->length();
-	x /= len;
-	y /= len;
-}
-
-void Vector2::invertY()
-{
-	y *= -1;
-}
-
-void Vector2::invertX()
-{
-	x *= -1;
-}
-
-//-------------------------------------------------------
-//	game parameters
-//-------------------------------------------------------
-
-namespace Params
-{
-	namespace System
-	{
-		constexpr int targetFPS = 60;
-	}
-
-	namespace Table
-	{
-		constexpr float width = 15.f;
-		constexpr float height = 8.f;
-		constexpr float pocketRadius = 0.5f;
-
-		static constexpr std::array< Vector2, 6 > pocketsPositions =
-		{
-			Vector2{ -0.5f * width, -0.5f * height },
-			Vector2{ 0.f, -0.5f * height },
-			Vector2{ 0.5f * width, -0.5f * height },
-			Vector2{ -0.5f * width, 0.5f * height },
-			Vector2{ 0.f, 0.5f * height },
-			Vector2{ 0.5f * width, 0.5f * height }
-		};
-
-		static constexpr std::array< Vector2, 7 > ballsPositions =
-		{
-			// player ball
-			Vector2( -0.3f * width, 0.f ),
-			// other balls
-			Vector2( 0.2f * width, 0.f ),
-			Vector2( 0.25f * width, 0.05f * height ),
-			Vector2( 0.25f * width, -0.05f * height ),
-			Vector2( 0.3f * width, 0.1f * height ),
-			Vector2( 0.3f * width, 0.f ),
-			Vector2( 0.3f * width, -0.1f * height )
-		};
-	}
-
-	namespace Ball
-	{
-		constexpr float radius = 0.3f;
-	}
-
-	namespace Shot
-	{
-		constexpr float chargeTime = 1.f;
-	}
-}
-
-//-------------------------------------------------------
-//	Table logic
-//-------------------------------------------------------
-
-class Table
-{
-public:
-	Table() = default;
-	Table(Table const&) = delete;
-
-	void init();
-	void deinit();
-
-	float speedSum() const;
-
-	std::array< Vector2, 7 > ballsCurrentPositions = {};
-	std::array< Vector2, 7 > speedDirection = {};
-	std::array < float, 7 > speedModulus = {};
-	std::array< bool, 7 > isPocketed = {};
-	std::array< Scene::Mesh*, 7 > balls = {};
-private:
-	std::array< Scene::Mesh*, 6 > pockets = {};
-};
-
-
-void Table::init()
-{
-	ballsCurrentPositions = Params::Table::ballsPositions;
-	isPocketed.fill( 0 );
-
-	for ( int i = 0; i < 6; i++ )
-	{
-		assert( !pockets[ i ] );
-		pockets[ i ] = Scene::createPocketMesh( Params::Table::pocketRadius );
-		Scene::placeMesh( pockets[ i ], Params::Table::pocketsPositions[ i ].x, Params::Table::pocketsPositions[ i ].y, 0.f );
-	}
-
-	for ( int i = 0; i < 7; i++ )
-	{
-		assert( !balls[ i ] );
-		balls[ i ] = Scene::createBallMesh( Params::Ball::radius );
-		Scene::placeMesh( balls[ i ], Params::Table::ballsPositions[ i ].x, Params::Table::ballsPositions[ i ].y, 0.f );
-
-		speedDirection[ i ] = { 0, 0 };
-		speedModulus[ i ] = 0.f;
-	}
-}
-
-
-void Table::deinit()
-{
-	for ( Scene::Mesh* mesh : pockets )
-		Scene::destroyMesh( mesh );
-
-	for ( Scene::Mesh* mesh : balls )
-	{
-		if ( mesh )
-			Scene::destroyMesh( mesh );
-	}
-
-	ballsCurrentPositions = {};
-	speedDirection = {};
-	speedModulus = {};
-	isPocketed = {};
-	pockets = {};
-	balls = {};
-}
-
-float Table::speedSum() const
-{	
-	float sum = 0;
-	for ( auto v : speedModulus )
-	{
-		sum += v;
-	}
-	return sum;
-}
-
-//-------------------------------------------------------
-//	game public interface
-//-------------------------------------------------------
-
-namespace Game
-{
-	Table table;
-
-	bool isChargingShot = false;
-	float shotChargeProgress = 0.f;
-
-	bool isBallsMoving = false;
-
-	void init()
-	{
-		Engine::setTargetFPS( Params::System::targetFPS );
-		Scene::setupBackground( Params::Table::width, Params::Table::height );
-		table.init();
-	}
-
-
-	void deinit()
-	{
-		table.deinit();
-	}
-
-	bool isInPocket( int ballIdx, Scene::Mesh* ball )
-	{
-		float x = table.ballsCurrentPositions[ ballIdx ].x;
-		float y = table.ballsCurrentPositions[ ballIdx ].y;
-
-		for ( int i = 0; i < 6; i++ )
-		{
-			Vector2 distance = { Params::Table::pocketsPositions[ i ].x - x,
-								 Params::Table::pocketsPositions[ i ].y - y };
-			if ( distance.length() <= Params::Table::pocketRadius ) 
-			{
-				return true;
-			}
-		}
-		return false;
-	}
-
-	void checkBorders( int ballIdx )
-	{
-		float& x = table.ballsCurrentPositions[ ballIdx ].x;
-		float& y = table.ballsCurrentPositions[ ballIdx ].y;
-		Vector2& speedDirection = table.speedDirection[ ballIdx ];
-		float& speedModulus = table.speedModulus[ ballIdx ];
-
-		if ( y < -0.5f * Params::Table::height + Params::Ball::radius )
-		{
-			y = -0.5f * Params::Table::height + Params::Ball::radius;
-			speedModulus -= 0.15f * speedModulus * ( 1.f + abs( speedDirection.y ) );
-			speedDirection.invertY();
-		}
-
-		if ( y > 0.5f * Params::Table::height - Params::Ball::radius )
-		{
-			y = 0.5f * Params::Table::height - Params::Ball::radius;
-			speedModulus -= 0.15f * speedModulus * ( 1.f + speedDirection.y );
-			speedDirection.invertY();
-		}
-
-		if ( x < -0.5f * Params::Table::width + Params::Ball::radius )
-		{
-			x = -0.5f * Params::Table::width + Params::Ball::radius;
-			speedModulus -= 0.15f * speedModulus * ( 1.f + abs( speedDirection.x ) );
-			speedDirection.invertX();
-		}
-
-		if ( x > 0.5f * Params::Table::width - Params::Ball::radius )
-		{
-			x = 0.5f * Params::Table::width - Params::Ball::radius;
-			speedModulus -= 0.15f * speedModulus * ( 1.f + speedDirection.x );
-			speedDirection.invertX();
-		}
-	}
-
-	void checkBallCollision( int ballIdx )
-	{
-		float& x = table.ballsCurrentPositions[ ballIdx ].x;
-		float& y = table.ballsCurrentPositions[ ballIdx ].y;
-		Vector2& speedDirection = table.speedDirection[ ballIdx ];
-		float& speedModulus = table.speedModulus[ ballIdx ];
-
-		for ( int i = 0; i < 7; i++ )
-		{
-			if ( i == ballIdx )
-				continue;
-			Vector2 distance = { table.ballsCurrentPositions[ i ].x - x,
-								 table.ballsCurrentPositions[ i ].y - y };
-			float len = distance.length();
-			if ( len < 2 * Params::Ball::radius )
-			{
-				float s = distance.x / len; //sin
-				float c = distance.y / len; //cos
-
-				distance.normalize();
-				x -= distance.x * ( 2 * Params::Ball::radius - len );
-				y -= distance.y * ( 2 * Params::Ball::radius - len );
-
-				float vn1 = speedDirection.x * speedModulus * s
-					+ speedDirection.y * speedModulus * c;
-				float vn2 = table.speedDirection[ i ].x * table.speedModulus[ i ] * s
-					+ table.speedDirection[ i ].y * table.speedModulus[ i ] * c;
-				float vt1 = -table.speedDirection[ i ].x * table.speedModulus[ i ] * c
-					+ table.speedDirection[ i ].y * table.speedModulus[ i ] * s;
-				float vt2 = -speedDirection.x * speedModulus * c
-					+ speedDirection.y * speedModulus * s;
-
-				speedDirection.x = 0.85f * ( vn2 * s - vt2 * c ) + 0.15f * ( vn1 * s - vt1 * c );
-				speedDirection.y = 0.85f * ( vn2 * c + vt2 * s ) + 0.15f * ( vn1 * c + vt1 * s );
-				table.speedDirection[ i ].x = 0.85 * ( vn1 * s - vt1 * c ) + 0.15f * ( vn2 * s - vt2 * c );
-				table.speedDirection[ i ].y = 0.85 * ( vn1 * c + vt1 * s ) + 0.15f * ( vn2 * c + vt2 * s );
-				
-				speedModulus = 0.95f * speedDirection.length();
-				speedDirection.normalize();
-
-				table.speedModulus[ i ] = 0.95f * table.speedDirection[ i ].length();
-				table.speedDirection[ i ].normalize();
-			}
-		}
-	}
-
-	void moveBall( int ballIdx, float dt )
-	{
-		float& x = table.ballsCurrentPositions[ ballIdx ].x;
-		float& y = table.ballsCurrentPositions[ ballIdx ].y;
-		Vector2& speedDirection = table.speedDirection[ ballIdx ];
-		float& speedModulus = table.speedModulus[ ballIdx ];
-		Scene::Mesh* ball = table.balls[ ballIdx ];
-
-		if ( isInPocket( ballIdx, ball ) )
-		{	
-			if ( !ballIdx )
-			{
-				deinit();
-				init();
-				return;
-			}
-			Scene::destroyMesh( ball );
-			table.balls[ ballIdx ] = nullptr;
-			x = 2 * Params::Table::width;
-			y = x;
-			speedModulus = 0;
-			table.isPocketed[ ballIdx ] = true;
-			return;
-		}
-
-		checkBorders( ballIdx );
-		checkBallCollision( ballIdx );
-
-		float newX = x + speedDirection.x * speedModulus * dt;
-		float newY = y + speedDirection.y * speedModulus * dt;
-		x = newX;
-		y = newY;
-
-		Scene::placeMesh( ball, x, y, 0.f );
-		speedModulus = std::max( speedModulus - 0.05f * Params::Table::width * dt, 0.f );
-	}
-
-	void update( float dt )
-	{
-		if ( isChargingShot )
-			shotChargeProgress = std::min( shotChargeProgress + dt / Params::Shot::chargeTime, 1.f );
-		Scene::updateProgressBar( shotChargeProgress );
-
-		if ( isBallsMoving ) 
-		{		
-			for ( int i = 0; i < 7; i++ )
-			{
-				if ( !table.isPocketed[ i ] )
-					moveBall( i, dt );
-			}
-			if ( !table.speedSum() )
-				isBallsMoving = false;
-		}
-	}
-
-	void mouseButtonPressed( float x, float y )
-	{
-		if ( !isBallsMoving )
-			isChargingShot = true;
-	}
-
-	void mouseButtonReleased( float x, float y )
-	{
-		if ( !isBallsMoving )
-		{
-			table.speedDirection[ 0 ] = { x - table.ballsCurrentPositions[ 0 ].x,
-										  y - table.ballsCurrentPositions[ 0 ].y };
-			table.speedDirection[ 0 ].normalize();
-			table.speedModulus[ 0 ] = shotChargeProgress * Params::Table::width;
-
-			isBallsMoving = true;
-                                                                               
-			isChargingShot = false;
-			shotChargeProgress = 0.f;
-		}
-	}
-}
+#include <cassert>
+#include <cstdio>
+#include <cmath>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+#include "../framework/scene.hpp"
+#include "../framework/game.hpp"
+#include "../framework/engine.hpp"
+#include "../framework/mappedfile.hpp"
+#include "../framework/udpsocket.hpp"
+#include "../framework/framearena.hpp"
+
+#include "params.hpp"
+#include "rules.hpp"
+#include "tablefile.hpp"
+#include "match.hpp"
+#include "aimpreview.hpp"
+#include "shotsearch.hpp"
+#include "threadpool.hpp"
+#include "netmatch.hpp"
+#include "snapshot.hpp"
+#include "triplebuffer.hpp"
+
+//-------------------------------------------------------
+//	Table view
+//-------------------------------------------------------
+
+// scene meshes mirroring one match, driven by snapshots on the render thread
+class TableView
+{
+public:
+	TableView() = default;
+	TableView(TableView const&) = delete;
+
+	void init( unsigned generation, Physics::BallStore const& balls );
+	void deinit();
+
+	// copies ball positions into the meshes, called once per drawn frame
+	void sync( unsigned generation, Physics::BallStore const& balls );
+	// after sync, empty paths hide the preview
+	void showPreview( std::vector< Vector2 > const& cuePath, std::vector< Vector2 > const& objectPath );
+
+private:
+	void setPath( Scene::MeshHandle mesh, std::vector< Vector2 > const& path );
+
+	std::vector< Scene::MeshHandle > balls;
+	std::array< Scene::MeshHandle, 6 > pockets = {};
+	Scene::MeshHandle cuePath;
+	Scene::MeshHandle objectPath;
+	unsigned generation = 0;
+	bool built = false;
+};
+
+
+void TableView::init( unsigned newGeneration, Physics::BallStore const& state )
+{
+	for ( int i = 0; i < 6; i++ )
+	{
+		assert( !pockets[ i ] );
+		pockets[ i ] = Scene::createPocketMesh( Params::Table::pocketRadius );
+		Scene::placeMesh( pockets[ i ], Params::Table::pocketsPositions[ i ].x, Params::Table::pocketsPositions[ i ].y, 0.f );
+	}
+
+	assert( balls.empty() );
+	for ( int i = 0, n = state.size(); i < n; i++ )
+	{
+		balls.push_back( Scene::createBallMesh( Params::Ball::radius ) );
+		Scene::placeMesh( balls.back(), state.x[ i ], state.y[ i ], 0.f );
+	}
+
+	// created last, so they are drawn over the balls
+	cuePath = Scene::createPathMesh();
+	objectPath = Scene::createPathMesh();
+
+	generation = newGeneration;
+	built = true;
+}
+
+
+void TableView::deinit()
+{
+	for ( Scene::MeshHandle mesh : pockets )
+	{
+		if ( mesh )
+			Scene::destroyMesh( mesh );
+	}
+
+	for ( Scene::MeshHandle mesh : balls )
+	{
+		if ( mesh )
+			Scene::destroyMesh( mesh );
+	}
+
+	for ( Scene::MeshHandle mesh : { cuePath, objectPath } )
+	{
+		if ( mesh )
+			Scene::destroyMesh( mesh );
+	}
+
+	pockets = {};
+	balls.clear();
+	cuePath = objectPath = {};
+	built = false;
+}
+
+
+void TableView::sync( unsigned newGeneration, Physics::BallStore const& state )
+{
+	if ( !built || generation != newGeneration )
+	{
+		// new meshes, the frame of a reset may allocate
+		FrameArena::allowHeapAllocations();
+		if ( built )
+			deinit();
+		init( newGeneration, state );
+	}
+
+	for ( int i = 0, n = state.size(); i < n; i++ )
+	{
+		if ( !balls[ i ] )
+			continue;
+
+		if ( !state.alive[ i ] )
+		{
+			Scene::destroyMesh( balls[ i ] );
+			balls[ i ] = {};
+			continue;
+		}
+
+		Scene::placeMesh( balls[ i ], state.x[ i ], state.y[ i ], 0.f );
+	}
+}
+
+
+void TableView::showPreview( std::vector< Vector2 > const& cue, std::vector< Vector2 > const& object )
+{
+	setPath( cuePath, cue );
+	setPath( objectPath, object );
+}
+
+
+void TableView::setPath( Scene::MeshHandle mesh, std::vector< Vector2 > const& path )
+{
+	FrameArena::Vector< float > points = FrameArena::vector< float >();
+	points.reserve( 2 * path.size() );
+	for ( Vector2 const& point : path )
+	{
+		points.push_back( point.x );
+		points.push_back( point.y );
+	}
+	Scene::setPathPoints( mesh, points.data(), int( path.size() ) );
+}
+
+//-------------------------------------------------------
+//	game public interface
+//-------------------------------------------------------
+
+// facade over the default match of the process, the match lives on the update thread
+// and reaches the render thread only through published snapshots
+namespace Game
+{
+	namespace
+	{
+		Match match;
+		TableView view;
+
+		// follows the cursor while a shot is charged, update thread only
+		AimPreview preview;
+		Vector2 cursor;
+
+		TripleBuffer< TableSnapshot > snapshots;
+		// render thread copies of the two most recent snapshots
+		TableSnapshot previous;
+		TableSnapshot latest;
+		Physics::BallStore interpolated;
+
+
+		double now()
+		{
+			return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+		}
+
+
+		// with Params::Ai::opponent the computer answers every local shot once the balls stopped,
+		// the search runs on the update thread and its pool, so the table shows the rest state meanwhile
+		std::unique_ptr< ThreadPool > opponentPool;
+		std::unique_ptr< Ai::ShotSearch > opponent;
+		bool opponentTurn = false;
+
+
+		// after a reset or restore the ball storage may be sized anew, so does everything
+		// sized by the ball count, the ticks in between do not allocate
+		unsigned publishedGeneration = 0;
+
+		void publish()
+		{
+			if ( match.generation() != publishedGeneration )
+			{
+				FrameArena::allowHeapAllocations();
+				publishedGeneration = match.generation();
+
+				const int balls = match.simulation().state().size();
+				preview.reserve( balls );
+				if ( Params::Ai::opponent && !opponent )
+				{
+					opponentPool = std::make_unique< ThreadPool >();
+					opponent = std::make_unique< Ai::ShotSearch >( *opponentPool );
+				}
+				if ( opponent )
+					opponent->reserve( balls );
+			}
+
+			TableSnapshot& slot = snapshots.writeSlot();
+			slot.capture( match, now() );
+			slot.cuePath = preview.cuePath();
+			slot.objectPath = preview.objectPath();
+			snapshots.publish();
+		}
+
+
+		void updatePreview()
+		{
+			if ( match.isChargingShot() )
+				preview.update( match.simulation().state(), cursor, match.shotChargeProgress() );
+			else
+				preview.clear();
+		}
+
+
+		// write time of the loaded table file and the time since it was last checked
+		std::uint64_t layoutTime = 0;
+		float reloadTimer = 0.f;
+
+		// maps the table file only for as long as it takes to copy the balls out, so the
+		// tools can replace it at any time, a file made for other rules is ignored with the reason
+		bool loadLayout()
+		{
+			FrameArena::allowHeapAllocations();
+			MappedFile file( Params::Layout::file );
+			if ( !file )
+				return false;
+
+			TableFile::View table = TableFile::parse( file.data(), file.size() );
+			if ( !table )
+			{
+				std::fprintf( stderr, "%s is not a table file, keeping the current layout\n", Params::Layout::file );
+				return false;
+			}
+			if ( char const* constant = TableFile::mismatch< Rules::Pool >( table ) )
+			{
+				std::fprintf( stderr, "%s is not made for the pool rules, its %s differs, keeping the current layout\n", Params::Layout::file, constant );
+				return false;
+			}
+
+			match.setLayout( table.layout() );
+			return true;
+		}
+
+
+		void checkLayoutReload( float dt )
+		{
+			reloadTimer += dt;
+			if ( reloadTimer < Params::Layout::reloadInterval )
+				return;
+			reloadTimer = 0.f;
+
+			// a file that fails to load keeps the current layout until the next change
+			const std::uint64_t time = MappedFile::modificationTime( Params::Layout::file );
+			if ( time && time != layoutTime )
+			{
+				layoutTime = time;
+				loadLayout();
+			}
+		}
+
+
+		void playOpponent()
+		{
+			if ( !opponentTurn || match.isBallsMoving() )
+				return;
+
+			Physics::BallStore const& table = match.simulation().state();
+			const Ai::Decision decision = opponent->decide( table, match.elapsedTicks() );
+			match.shoot( { table.x[ 0 ] + std::cos( decision.shot.angle ), table.y[ 0 ] + std::sin( decision.shot.angle ) }, decision.shot.charge );
+			opponentTurn = false;
+		}
+
+
+		// networked play when Params::Network::server names a host, the server owns the
+		// table and the layout, the local match predicts
+		UdpSocket socket;
+		UdpAddress server;
+		std::unique_ptr< Net::ClientMatch > client;
+		Net::DatagramQueue outgoing;
+		// decoded into the same message, a state keeps the ball storage for the next one
+		Net::Message incoming;
+
+		void connect()
+		{
+			if ( !*Params::Network::server )
+				return;
+			if ( !UdpAddress::resolve( Params::Network::server, Params::Network::port, server ) || !socket.open() )
+				return;
+
+			client = std::make_unique< Net::ClientMatch >( match, Params::Network::match );
+			client->join( outgoing );
+		}
+
+
+		void flush()
+		{
+			for ( std::vector< std::uint8_t > const& datagram : outgoing )
+				socket.send( server, datagram.data(), datagram.size() );
+			outgoing.clear();
+		}
+
+
+		void receive()
+		{
+			UdpAddress from;
+			std::uint8_t const* datagram;
+			size_t size;
+			while ( socket.receive( from, datagram, size ) )
+			{
+				if ( from.id() == server.id() && Net::decode( datagram, size, incoming ) )
+					client->receive( incoming, outgoing );
+			}
+		}
+	}
+
+
+	void init()
+	{
+		Engine::setTargetFPS( Params::System::targetFPS );
+		Engine::setVSync( Params::System::vsync );
+		Scene::setupBackground( Params::Table::width, Params::Table::height );
+
+		if ( client )
+		{
+			// a restart is an input of the networked match like a shot
+			client->reset( outgoing );
+			flush();
+		}
+		else
+		{
+			opponentTurn = false;
+			layoutTime = MappedFile::modificationTime( Params::Layout::file );
+			if ( !loadLayout() )
+				match.reset();
+			connect();
+			flush();
+		}
+		publish();
+	}
+
+
+	void deinit()
+	{
+		view.deinit();
+	}
+
+	void update( float dt )
+	{
+		if ( client )
+		{
+			receive();
+			client->update( dt, now(), outgoing );
+			flush();
+		}
+		else
+		{
+			checkLayoutReload( dt );
+			match.update( dt );
+			if ( Params::Ai::opponent )
+				playOpponent();
+		}
+		updatePreview();
+		publish();
+	}
+
+	void prepareDraw()
+	{
+		if ( snapshots.acquire() )
+		{
+			std::swap( previous, latest );
+			latest = snapshots.readSlot();
+		}
+
+		// drawn one update behind, so the newest state is reached as the next one arrives
+		const double interval = latest.time - previous.time;
+		const float alpha = interval > 0.0 ? float( std::min( std::max( ( now() - latest.time ) / interval, 0.0 ), 1.0 ) ) : 1.f;
+
+		TableSnapshot::interpolate( previous, latest, alpha, interpolated );
+		Scene::updateProgressBar( latest.chargeProgress );
+		view.sync( latest.generation, interpolated );
+		view.showPreview( latest.cuePath, latest.objectPath );
+	}
+
+	void mouseButtonPressed( float x, float y, float offset )
+	{
+		cursor = { x, y };
+		if ( !opponentTurn )
+			match.buttonPressed( offset );
+	}
+
+	void mouseButtonReleased( float x, float y, float offset )
+	{
+		if ( client )
+		{
+			client->buttonReleased( { x, y }, offset, outgoing );
+			flush();
+		}
+		else if ( !opponentTurn )
+		{
+			match.buttonReleased( { x, y }, offset );
+			opponentTurn = Params::Ai::opponent && match.isBallsMoving();
+		}
+	}
+
+	void mouseMoved( float x, float y )
+	{
+		cursor = { x, y };
+	}
+}
@@ -0,0 +1,373 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "kernels.hpp"
+#include "determinism.hpp"
+#include "contacts.hpp"
+
+#if !defined( PHYSICS_SCALAR_KERNELS )
+	#if defined( __AVX2__ )
+		#define PHYSICS_KERNELS_AVX2
+		#include <immintrin.h>
+	#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+		#define PHYSICS_KERNELS_SSE2
+		#include <emmintrin.h>
+	#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+		#define PHYSICS_KERNELS_NEON
+		#include <arm_neon.h>
+	#endif
+#endif
+
+
+//-------------------------------------------------------
+//	scalar reference kernels
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace Kernels
+	{
+		namespace
+		{
+			inline void integrateBall( BallStore& balls, int i, float dt )
+			{
+				balls.x[ i ] += balls.vx[ i ] * dt;
+				balls.y[ i ] += balls.vy[ i ] * dt;
+			}
+
+
+			inline void applyBallFriction( BallStore& balls, int i, float dv )
+			{
+				float& vx = balls.vx[ i ];
+				float& vy = balls.vy[ i ];
+
+				float speed = std::sqrt( vx * vx + vy * vy );
+				float scale = speed > dv ? 1.f - dv / speed : 0.f;
+				vx *= scale;
+				vy *= scale;
+			}
+
+
+			inline void checkBallBorders( BallStore& balls, int i, Cushions const& cushions )
+			{
+				if ( !balls.alive[ i ] )
+					return;
+
+				float& x = balls.x[ i ];
+				float& y = balls.y[ i ];
+
+				if ( y < cushions.minY )
+				{
+					y = cushions.minY;
+					Contacts::bounce( balls.vy[ i ], balls.vx[ i ], cushions.loss );
+				}
+
+				if ( y > cushions.maxY )
+				{
+					y = cushions.maxY;
+					Contacts::bounce( balls.vy[ i ], balls.vx[ i ], cushions.loss );
+				}
+
+				if ( x < cushions.minX )
+				{
+					x = cushions.minX;
+					Contacts::bounce( balls.vx[ i ], balls.vy[ i ], cushions.loss );
+				}
+
+				if ( x > cushions.maxX )
+				{
+					x = cushions.maxX;
+					Contacts::bounce( balls.vx[ i ], balls.vy[ i ], cushions.loss );
+				}
+			}
+		}
+
+
+		namespace Scalar
+		{
+			void integrate( BallStore& balls, int begin, int end, float dt )
+			{
+				for ( int i = begin; i < end; i++ )
+					integrateBall( balls, i, dt );
+			}
+
+
+			void applyFriction( BallStore& balls, int begin, int end, float deceleration, float dt )
+			{
+				const float dv = deceleration * dt;
+				for ( int i = begin; i < end; i++ )
+					applyBallFriction( balls, i, dv );
+			}
+
+
+			void checkBorders( BallStore& balls, int begin, int end, Cushions const& cushions )
+			{
+				for ( int i = begin; i < end; i++ )
+					checkBallBorders( balls, i, cushions );
+			}
+		}
+
+
+		void integrate( BallStore& balls, std::vector< int > const& indices, float dt )
+		{
+			for ( int i : indices )
+				integrateBall( balls, i, dt );
+		}
+
+
+		void applyFriction( BallStore& balls, std::vector< int > const& indices, float deceleration, float dt )
+		{
+			const float dv = deceleration * dt;
+			for ( int i : indices )
+				applyBallFriction( balls, i, dv );
+		}
+
+
+		void checkBorders( BallStore& balls, std::vector< int > const& indices, Cushions const& cushions )
+		{
+			for ( int i : indices )
+				checkBallBorders( balls, i, cushions );
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	thin per instruction set lane wrappers
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace Kernels
+	{
+		namespace
+		{
+#if defined( PHYSICS_KERNELS_AVX2 )
+			namespace Lanes
+			{
+				constexpr int width = 8;
+				constexpr char const* name = "avx2";
+
+				using Float = __m256;
+				using Mask = __m256;
+
+				inline Float load( float const* p ) { return _mm256_loadu_ps( p ); }
+				inline void store( float* p, Float v ) { _mm256_storeu_ps( p, v ); }
+				inline Float set( float v ) { return _mm256_set1_ps( v ); }
+				inline Float add( Float a, Float b ) { return _mm256_add_ps( a, b ); }
+				inline Float sub( Float a, Float b ) { return _mm256_sub_ps( a, b ); }
+				inline Float mul( Float a, Float b ) { return _mm256_mul_ps( a, b ); }
+				inline Float div( Float a, Float b ) { return _mm256_div_ps( a, b ); }
+				inline Float sqrt( Float a ) { return _mm256_sqrt_ps( a ); }
+				inline Float min( Float a, Float b ) { return _mm256_min_ps( a, b ); }
+				inline Float max( Float a, Float b ) { return _mm256_max_ps( a, b ); }
+				inline Float abs( Float a ) { return _mm256_andnot_ps( _mm256_set1_ps( -0.f ), a ); }
+				inline Mask less( Float a, Float b ) { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+				inline Mask greater( Float a, Float b ) { return _mm256_cmp_ps( a, b, _CMP_GT_OQ ); }
+				inline Mask maskOr( Mask a, Mask b ) { return _mm256_or_ps( a, b ); }
+				inline Mask maskAnd( Mask a, Mask b ) { return _mm256_and_ps( a, b ); }
+				inline Float select( Mask m, Float a, Float b ) { return _mm256_blendv_ps( b, a, m ); }
+
+				inline Mask loadAlive( std::uint8_t const* p )
+				{
+					__m128i bytes = _mm_loadl_epi64( reinterpret_cast< __m128i const* >( p ) );
+					__m256i words = _mm256_cvtepu8_epi32( bytes );
+					return _mm256_castsi256_ps( _mm256_cmpgt_epi32( words, _mm256_setzero_si256() ) );
+				}
+			}
+#elif defined( PHYSICS_KERNELS_SSE2 )
+			namespace Lanes
+			{
+				constexpr int width = 4;
+				constexpr char const* name = "sse2";
+
+				using Float = __m128;
+				using Mask = __m128;
+
+				inline Float load( float const* p ) { return _mm_loadu_ps( p ); }
+				inline void store( float* p, Float v ) { _mm_storeu_ps( p, v ); }
+				inline Float set( float v ) { return _mm_set1_ps( v ); }
+				inline Float add( Float a, Float b ) { return _mm_add_ps( a, b ); }
+				inline Float sub( Float a, Float b ) { return _mm_sub_ps( a, b ); }
+				inline Float mul( Float a, Float b ) { return _mm_mul_ps( a, b ); }
+				inline Float div( Float a, Float b ) { return _mm_div_ps( a, b ); }
+				inline Float sqrt( Float a ) { return _mm_sqrt_ps( a ); }
+				inline Float min( Float a, Float b ) { return _mm_min_ps( a, b ); }
+				inline Float max( Float a, Float b ) { return _mm_max_ps( a, b ); }
+				inline Float abs( Float a ) { return _mm_andnot_ps( _mm_set1_ps( -0.f ), a ); }
+				inline Mask less( Float a, Float b ) { return _mm_cmplt_ps( a, b ); }
+				inline Mask greater( Float a, Float b ) { return _mm_cmpgt_ps( a, b ); }
+				inline Mask maskOr( Mask a, Mask b ) { return _mm_or_ps( a, b ); }
+				inline Mask maskAnd( Mask a, Mask b ) { return _mm_and_ps( a, b ); }
+				inline Float select( Mask m, Float a, Float b ) { return _mm_or_ps( _mm_and_ps( m, a ), _mm_andnot_ps( m, b ) ); }
+
+				inline Mask loadAlive( std::uint8_t const* p )
+				{
+					int packed;
+					std::memcpy( &packed, p, sizeof( packed ) );
+					__m128i zero = _mm_setzero_si128();
+					__m128i words = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( packed ), zero ), zero );
+					return _mm_castsi128_ps( _mm_cmpgt_epi32( words, zero ) );
+				}
+			}
+#elif defined( PHYSICS_KERNELS_NEON )
+			namespace Lanes
+			{
+				constexpr int width = 4;
+				constexpr char const* name = "neon";
+
+				using Float = float32x4_t;
+				using Mask = uint32x4_t;
+
+				inline Float load( float const* p ) { return vld1q_f32( p ); }
+				inline void store( float* p, Float v ) { vst1q_f32( p, v ); }
+				inline Float set( float v ) { return vdupq_n_f32( v ); }
+				inline Float add( Float a, Float b ) { return vaddq_f32( a, b ); }
+				inline Float sub( Float a, Float b ) { return vsubq_f32( a, b ); }
+				inline Float mul( Float a, Float b ) { return vmulq_f32( a, b ); }
+				inline Float div( Float a, Float b ) { return vdivq_f32( a, b ); }
+				inline Float sqrt( Float a ) { return vsqrtq_f32( a ); }
+				inline Float min( Float a, Float b ) { return vminq_f32( a, b ); }
+				inline Float max( Float a, Float b ) { return vmaxq_f32( a, b ); }
+				inline Float abs( Float a ) { return vabsq_f32( a ); }
+				inline Mask less( Float a, Float b ) { return vcltq_f32( a, b ); }
+				inline Mask greater( Float a, Float b ) { return vcgtq_f32( a, b ); }
+				inline Mask maskOr( Mask a, Mask b ) { return vorrq_u32( a, b ); }
+				inline Mask maskAnd( Mask a, Mask b ) { return vandq_u32( a, b ); }
+				inline Float select( Mask m, Float a, Float b ) { return vbslq_f32( m, a, b ); }
+
+				inline Mask loadAlive( std::uint8_t const* p )
+				{
+					std::uint32_t packed;
+					std::memcpy( &packed, p, sizeof( packed ) );
+					uint16x8_t halves = vmovl_u8( vreinterpret_u8_u32( vdup_n_u32( packed ) ) );
+					return vcgtq_u32( vmovl_u16( vget_low_u16( halves ) ), vdupq_n_u32( 0 ) );
+				}
+			}
+#endif
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	simd kernels, branch free with masked updates
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace Kernels
+	{
+#if defined( PHYSICS_KERNELS_AVX2 ) || defined( PHYSICS_KERNELS_SSE2 ) || defined( PHYSICS_KERNELS_NEON )
+		namespace
+		{
+			using namespace Lanes;
+
+			// one cushion pair along the normal axis, same math as Contacts::bounce
+			inline void bounceLanes( Float& position, Float& vNormal, Float& vTangent, Mask alive,
+									 Float minPosition, Float maxPosition, Float loss )
+			{
+				Mask hit = maskAnd( alive, maskOr( less( position, minPosition ), greater( position, maxPosition ) ) );
+
+				Float speed = sqrt( add( mul( vNormal, vNormal ), mul( vTangent, vTangent ) ) );
+				Float scale = sub( set( 1.f ), mul( loss, add( set( 1.f ), div( abs( vNormal ), speed ) ) ) );
+				scale = select( greater( speed, set( 0.f ) ), scale, set( 0.f ) );
+
+				position = select( hit, min( max( position, minPosition ), maxPosition ), position );
+				vNormal = select( hit, mul( vNormal, sub( set( 0.f ), scale ) ), vNormal );
+				vTangent = select( hit, mul( vTangent, scale ), vTangent );
+			}
+		}
+
+
+		void integrate( BallStore& balls, float dt )
+		{
+			const int n = balls.size();
+			const int simdEnd = n - n % width;
+			const Float step = set( dt );
+
+			for ( int i = 0; i < simdEnd; i += width )
+			{
+				store( &balls.x[ i ], add( load( &balls.x[ i ] ), mul( load( &balls.vx[ i ] ), step ) ) );
+				store( &balls.y[ i ], add( load( &balls.y[ i ] ), mul( load( &balls.vy[ i ] ), step ) ) );
+			}
+			Scalar::integrate( balls, simdEnd, n, dt );
+		}
+
+
+		void applyFriction( BallStore& balls, float deceleration, float dt )
+		{
+			const int n = balls.size();
+			const int simdEnd = n - n % width;
+			const Float dv = set( deceleration * dt );
+
+			for ( int i = 0; i < simdEnd; i += width )
+			{
+				Float vx = load( &balls.vx[ i ] );
+				Float vy = load( &balls.vy[ i ] );
+				Float speed = sqrt( add( mul( vx, vx ), mul( vy, vy ) ) );
+				Float scale = select( greater( speed, dv ), sub( set( 1.f ), div( dv, speed ) ), set( 0.f ) );
+				store( &balls.vx[ i ], mul( vx, scale ) );
+				store( &balls.vy[ i ], mul( vy, scale ) );
+			}
+			Scalar::applyFriction( balls, simdEnd, n, deceleration, dt );
+		}
+
+
+		void checkBorders( BallStore& balls, Cushions const& cushions )
+		{
+			const int n = balls.size();
+			const int simdEnd = n - n % width;
+			const Float loss = set( cushions.loss );
+
+			for ( int i = 0; i < simdEnd; i += width )
+			{
+				Mask alive = loadAlive( &balls.alive[ i ] );
+				Float x = load( &balls.x[ i ] );
+				Float y = load( &balls.y[ i ] );
+				Float vx = load( &balls.vx[ i ] );
+				Float vy = load( &balls.vy[ i ] );
+
+				bounceLanes( y, vy, vx, alive, set( cushions.minY ), set( cushions.maxY ), loss );
+				bounceLanes( x, vx, vy, alive, set( cushions.minX ), set( cushions.maxX ), loss );
+
+				store( &balls.x[ i ], x );
+				store( &balls.y[ i ], y );
+				store( &balls.vx[ i ], vx );
+				store( &balls.vy[ i ], vy );
+			}
+			Scalar::checkBorders( balls, simdEnd, n, cushions );
+		}
+
+
+		char const* instructionSet()
+		{
+			return name;
+		}
+#else
+		void integrate( BallStore& balls, float dt )
+		{
+			Scalar::integrate( balls, 0, balls.size(), dt );
+		}
+
+
+		void applyFriction( BallStore& balls, float deceleration, float dt )
+		{
+			Scalar::applyFriction( balls, 0, balls.size(), deceleration, dt );
+		}
+
+
+		void checkBorders( BallStore& balls, Cushions const& cushions )
+		{
+			Scalar::checkBorders( balls, 0, balls.size(), cushions );
+		}
+
+
+		char const* instructionSet()
+		{
+			return "scalar";
+		}
+#endif
+	}
+}
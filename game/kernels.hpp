@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "ballstore.hpp"
+
+
+//-------------------------------------------------------
+//	data parallel step kernels over the ball store
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace Kernels
+	{
+		struct Cushions
+		{
+			// limits for the ball center
+			float minX;
+			float maxX;
+			float minY;
+			float maxY;
+			// share of the speed lost on a glancing hit, a head-on hit loses twice as much
+			float loss;
+		};
+
+		// simd paths, selected at compile time, define PHYSICS_SCALAR_KERNELS to disable
+		void integrate( BallStore& balls, float dt );
+		void applyFriction( BallStore& balls, float deceleration, float dt );
+		void checkBorders( BallStore& balls, Cushions const& cushions );
+
+		// name of the instruction set the kernels above were built for
+		char const* instructionSet();
+
+		// scalar gathers over the listed balls, for sparse active sets
+		void integrate( BallStore& balls, std::vector< int > const& indices, float dt );
+		void applyFriction( BallStore& balls, std::vector< int > const& indices, float deceleration, float dt );
+		void checkBorders( BallStore& balls, std::vector< int > const& indices, Cushions const& cushions );
+
+		// reference implementation, also used for the tails of the simd loops
+		namespace Scalar
+		{
+			void integrate( BallStore& balls, int begin, int end, float dt );
+			void applyFriction( BallStore& balls, int begin, int end, float deceleration, float dt );
+			void checkBorders( BallStore& balls, int begin, int end, Cushions const& cushions );
+		}
+	}
+}
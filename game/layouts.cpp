@@ -0,0 +1,88 @@
+#include <cmath>
+#include <algorithm>
+
+#include "layouts.hpp"
+#include "params.hpp"
+
+
+namespace Layouts
+{
+	namespace
+	{
+		constexpr float diameter = 2.f * Params::Ball::radius;
+
+		Vector2 playerBall()
+		{
+			return Params::Table::ballsPositions[ 0 ];
+		}
+
+		void addRack( std::vector< Vector2 >& layout, Vector2 apex, int count )
+		{
+			// small gap keeps the rack from starting in contact
+			constexpr float spacing = 1.01f * diameter;
+			const float rowStep = spacing * std::sqrt( 3.f ) * 0.5f;
+
+			for ( int row = 0; count > 0; row++ )
+			{
+				for ( int i = 0; i <= row && count > 0; i++, count-- )
+					layout.push_back( { apex.x + row * rowStep, apex.y + ( i - 0.5f * row ) * spacing } );
+			}
+		}
+	}
+
+
+	std::vector< Vector2 > standard()
+	{
+		return { Params::Table::ballsPositions.begin(), Params::Table::ballsPositions.end() };
+	}
+
+
+	std::vector< Vector2 > rack( int objectBalls )
+	{
+		std::vector< Vector2 > layout = { playerBall() };
+		addRack( layout, { 0.2f * Params::Table::width, 0.f }, objectBalls );
+		return layout;
+	}
+
+
+	std::vector< Vector2 > snooker()
+	{
+		constexpr float width = Params::Table::width;
+		constexpr float height = Params::Table::height;
+
+		std::vector< Vector2 > layout = { playerBall() };
+		// blue, pink and black on the center line
+		layout.push_back( { 0.f, 0.f } );
+		layout.push_back( { 0.15f * width, 0.f } );
+		layout.push_back( { 0.4f * width, 0.f } );
+		// yellow, brown and green on the baulk line
+		layout.push_back( { -0.3f * width, -0.15f * height } );
+		layout.push_back( { -0.3f * width, 0.15f * height } );
+		layout.push_back( { -0.3f * width, 0.3f * height } );
+		addRack( layout, { 0.15f * width + 1.1f * diameter, 0.f }, 15 );
+		return layout;
+	}
+
+
+	std::vector< Vector2 > stress( int objectBalls )
+	{
+		constexpr float spacing = 1.05f * diameter;
+		constexpr float left = -0.2f * Params::Table::width;
+		constexpr float right = 0.5f * Params::Table::width - Params::Ball::radius;
+		constexpr float bottom = -0.5f * Params::Table::height + Params::Ball::radius;
+
+		const int columns = std::max( int( ( right - left ) / spacing ), 1 );
+		const int rows = std::max( int( ( Params::Table::height - diameter ) / spacing ), 1 );
+
+		// balls beyond the table capacity go into shifted overlapping layers
+		std::vector< Vector2 > layout = { playerBall() };
+		for ( int i = 0; i < objectBalls; i++ )
+		{
+			int cell = i % ( columns * rows );
+			int layer = i / ( columns * rows );
+			float shift = std::fmod( layer * 0.618034f, 1.f ) * spacing;
+			layout.push_back( { left + ( cell % columns ) * spacing + shift, bottom + ( cell / columns ) * spacing + shift } );
+		}
+		return layout;
+	}
+}
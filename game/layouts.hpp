@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include "vector2.hpp"
+
+
+//-------------------------------------------------------
+//	initial ball layouts, the player ball always goes first
+//-------------------------------------------------------
+
+namespace Layouts
+{
+	// the default layout from Params::Table::ballsPositions
+	std::vector< Vector2 > standard();
+
+	// player ball plus a triangle rack of the given number of balls
+	std::vector< Vector2 > rack( int objectBalls );
+
+	// player ball plus 21 balls: 15 reds in a rack and 6 colours
+	std::vector< Vector2 > snooker();
+
+	// player ball plus a dense grid of balls for stress testing
+	std::vector< Vector2 > stress( int objectBalls );
+}
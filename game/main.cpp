@@ -1,10 +1,35 @@
-
-
-#include "../framework/engine.hpp"
-
-
-int main()
-{
-	Engine::run();
-	return 0;
-}
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../framework/engine.hpp"
+
+
+// usage: minibill [--offscreen frames image.ppm [width height]]
+// Without arguments the game opens its window. Offscreen it plays that many
+// frames as fast as they draw and writes the last one, for thumbnails.
+int main( int argc, char** argv )
+{
+	if ( argc == 1 )
+	{
+		Engine::run();
+		return 0;
+	}
+
+	if ( ( argc == 4 || argc == 6 ) && !std::strcmp( argv[ 1 ], "--offscreen" ) )
+	{
+		const int frames = std::atoi( argv[ 2 ] );
+		const int width = argc == 6 ? std::atoi( argv[ 4 ] ) : 320;
+		const int height = argc == 6 ? std::atoi( argv[ 5 ] ) : 180;
+		if ( frames > 0 && width > 0 && height > 0 )
+		{
+			if ( Engine::runOffscreen( width, height, frames, argv[ 3 ] ) )
+				return 0;
+			std::fprintf( stderr, "could not draw offscreen or write %s\n", argv[ 3 ] );
+			return 1;
+		}
+	}
+
+	std::fprintf( stderr, "usage: %s [--offscreen frames image.ppm [width height]]\n", argv[ 0 ] );
+	return 2;
+}
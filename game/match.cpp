@@ -0,0 +1,170 @@
+#include <utility>
+#include <algorithm>
+
+#include "match.hpp"
+#include "layouts.hpp"
+#include "params.hpp"
+#include "replay.hpp"
+
+
+Match::Match() :
+	Match( Layouts::standard() )
+{
+}
+
+
+Match::Match( std::vector< Vector2 > layout ) :
+	initialLayout( std::move( layout ) )
+{
+	table.reset( initialLayout );
+}
+
+
+void Match::reset()
+{
+	table.reset( initialLayout );
+	chargingShot = false;
+	chargeProgress = 0.f;
+	chargeDelay = 0.f;
+	resets++;
+
+	if ( recorder )
+		recorder->recordReset( ticks );
+}
+
+
+void Match::setLayout( std::vector< Vector2 > layout )
+{
+	initialLayout = std::move( layout );
+	reset();
+
+	if ( recorder )
+		setRecorder( recorder );
+}
+
+
+void Match::update( float dt )
+{
+	if ( chargingShot )
+		chargeProgress = shotChargeAt( dt );
+	chargeDelay = 0.f;
+
+	int steps = table.advance( dt );
+	ticks += steps;
+
+	if ( steps && table.isCueBallPocketed() )
+		reset();
+
+	if ( recorder )
+		recorder->recordState( ticks, table );
+}
+
+
+void Match::buttonPressed( float offset )
+{
+	if ( !table.isBallsMoving() && !chargingShot )
+	{
+		chargingShot = true;
+		chargeDelay = offset;
+	}
+}
+
+
+void Match::buttonReleased( Vector2 target, float offset )
+{
+	shoot( target, shotChargeAt( offset ) );
+}
+
+
+void Match::shoot( Vector2 target, float charge )
+{
+	if ( !table.isBallsMoving() )
+	{
+		if ( recorder )
+			recorder->recordShot( ticks, target, charge );
+		table.shoot( target, charge );
+
+		chargingShot = false;
+		chargeProgress = 0.f;
+		chargeDelay = 0.f;
+	}
+}
+
+
+void Match::restore( Physics::BallStore const& balls, bool moving, unsigned elapsedTicks )
+{
+	table.restore( balls, moving );
+	ticks = elapsedTicks;
+	chargingShot = false;
+	chargeProgress = 0.f;
+	chargeDelay = 0.f;
+	resets++;
+}
+
+
+void Match::setDeterministic( bool enabled )
+{
+	table.setDeterministic( enabled );
+}
+
+
+bool Match::isChargingShot() const
+{
+	return chargingShot;
+}
+
+
+float Match::shotChargeProgress() const
+{
+	return chargeProgress;
+}
+
+
+float Match::shotChargeAt( float offset ) const
+{
+	if ( !chargingShot )
+		return chargeProgress;
+	return std::min( chargeProgress + std::max( offset - chargeDelay, 0.f ) / Params::Shot::chargeTime, 1.f );
+}
+
+
+bool Match::isBallsMoving() const
+{
+	return table.isBallsMoving();
+}
+
+
+unsigned Match::generation() const
+{
+	return resets;
+}
+
+
+unsigned Match::elapsedTicks() const
+{
+	return ticks;
+}
+
+
+void Match::setRecorder( Replay::Recorder* newRecorder )
+{
+	recorder = newRecorder;
+	if ( !recorder )
+		return;
+
+	table.setDeterministic( true );
+	recorder->begin( initialLayout );
+	recorder->recordState( ticks, table );
+}
+
+
+std::vector< Vector2 > const& Match::layout() const
+{
+	return initialLayout;
+}
+
+
+Physics::Simulation const& Match::simulation() const
+{
+	return table;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+
+#include "vector2.hpp"
+#include "physics.hpp"
+
+namespace Replay
+{
+	class Recorder;
+}
+
+
+//-------------------------------------------------------
+//	one match: table simulation plus shot input state
+//-------------------------------------------------------
+
+// owns everything a match needs and has no scene or engine dependency,
+// so any number of matches can run side by side
+class Match
+{
+public:
+	Match();
+	explicit Match( std::vector< Vector2 > layout );
+
+	void reset();
+	// replaces the initial layout and resets to it, a running recording starts over
+	void setLayout( std::vector< Vector2 > layout );
+	void update( float dt );
+
+	// offset is the time into the next update the button went down or up, so the charge
+	// follows the real hold time instead of whole update steps
+	void buttonPressed( float offset = 0.f );
+	void buttonReleased( Vector2 target, float offset = 0.f );
+	// a shot with a given charge, ignored while the balls move, used for remote inputs
+	void shoot( Vector2 target, float charge );
+
+	// continues from a state received from elsewhere, views rebuild as after a reset
+	void restore( Physics::BallStore const& balls, bool moving, unsigned elapsedTicks );
+	// state hash after every tick, needed to compare tables across machines
+	void setDeterministic( bool enabled );
+
+	bool isChargingShot() const;
+	float shotChargeProgress() const;
+	// charge of a shot released offset into the next update
+	float shotChargeAt( float offset ) const;
+	bool isBallsMoving() const;
+
+	// incremented on every reset, views rebuild when it changes
+	unsigned generation() const;
+	// simulation ticks since the match started, resets included
+	unsigned elapsedTicks() const;
+
+	// records inputs and keyframes from now on, the simulation switches to deterministic mode
+	void setRecorder( Replay::Recorder* recorder );
+
+	std::vector< Vector2 > const& layout() const;
+	Physics::Simulation const& simulation() const;
+
+private:
+	std::vector< Vector2 > initialLayout;
+	Physics::Simulation table;
+
+	bool chargingShot = false;
+	float chargeProgress = 0.f;
+	// part of the next update before the button went down
+	float chargeDelay = 0.f;
+	unsigned resets = 0;
+	unsigned ticks = 0;
+
+	Replay::Recorder* recorder = nullptr;
+};
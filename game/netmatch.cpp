@@ -0,0 +1,527 @@
+#include <algorithm>
+
+#include "netmatch.hpp"
+#include "params.hpp"
+
+
+//-------------------------------------------------------
+//	server
+//-------------------------------------------------------
+
+namespace Net
+{
+	ServerMatch::ServerMatch( std::uint32_t id ) :
+		id( id ),
+		stream( id )
+	{
+		match.setDeterministic( true );
+	}
+
+
+	Message ServerMatch::header( MessageType type ) const
+	{
+		Message message;
+		message.type = type;
+		message.match = id;
+		message.sequence = inputs;
+		message.tick = match.elapsedTicks();
+		return message;
+	}
+
+
+	Message ServerMatch::stateMessage() const
+	{
+		Message message = header( MessageType::state );
+		message.moving = match.isBallsMoving();
+		message.balls = match.simulation().state();
+		return message;
+	}
+
+
+	void ServerMatch::send( PeerId peer, Message const& message, std::vector< Outgoing >& out )
+	{
+		std::vector< std::uint8_t > datagram;
+		if ( encode( message, datagram ) )
+			out.push_back( { peer, std::make_shared< std::vector< std::uint8_t > const >( std::move( datagram ) ) } );
+	}
+
+
+	void ServerMatch::broadcast( Message const& message, std::vector< Outgoing >& out )
+	{
+		std::vector< std::uint8_t > datagram;
+		if ( !encode( message, datagram ) )
+			return;
+
+		const Datagram shared = std::make_shared< std::vector< std::uint8_t > const >( std::move( datagram ) );
+		for ( Peer const& peer : peers )
+			out.push_back( { peer.id, shared } );
+	}
+
+
+	void ServerMatch::sendChecksum( double now, std::vector< Outgoing >& out )
+	{
+		Message message = header( MessageType::checksum );
+		message.hash = checksum( match.simulation().stateHash() );
+		broadcast( message, out );
+		lastChecksum = now;
+	}
+
+
+	void ServerMatch::watch( PeerId peer, std::uint32_t frame, double now, std::vector< Outgoing >& out )
+	{
+		auto known = std::find_if( spectators.begin(), spectators.end(), [ peer ]( Spectator const& s ) { return s.id == peer; } );
+		if ( known != spectators.end() )
+		{
+			// acks can come out of order, one from the future is not trusted and gets a keyframe
+			known->lastHeard = now;
+			known->acked = frame <= stream.latest() ? std::max( known->acked, frame ) : 0;
+			return;
+		}
+
+		// a new spectator starts from a keyframe of the table as it is
+		spectators.push_back( { peer, now, 0 } );
+		captureSnapshot();
+		if ( Datagram datagram = stream.datagramFrom( 0 ) )
+			out.push_back( { peer, std::move( datagram ) } );
+	}
+
+
+	bool ServerMatch::captureSnapshot()
+	{
+		return stream.capture( match.simulation().state(), inputs, match.elapsedTicks(), match.isBallsMoving() );
+	}
+
+
+	void ServerMatch::sendSnapshots( double now, std::vector< Outgoing >& out )
+	{
+		spectators.erase( std::remove_if( spectators.begin(), spectators.end(), [ now ]( Spectator const& spectator )
+		{
+			return now - spectator.lastHeard > Params::Network::peerTimeout;
+		} ), spectators.end() );
+		if ( spectators.empty() )
+			return;
+
+		// one frame per tick, each spectator is sent a reference to the encoding for its ack
+		if ( !captureSnapshot() && now - lastSnapshot < Params::Network::heartbeatInterval )
+			return;
+
+		for ( Spectator const& spectator : spectators )
+		{
+			if ( Datagram datagram = stream.datagramFrom( spectator.acked ) )
+				out.push_back( { spectator.id, std::move( datagram ) } );
+		}
+		lastSnapshot = now;
+	}
+
+
+	void ServerMatch::receive( PeerId peer, Message const& message, double now, std::vector< Outgoing >& out )
+	{
+		if ( message.type == MessageType::watch )
+		{
+			watch( peer, message.frame, now, out );
+			return;
+		}
+
+		auto known = std::find_if( peers.begin(), peers.end(), [ peer ]( Peer const& p ) { return p.id == peer; } );
+		if ( known == peers.end() )
+		{
+			// only a join admits a client, it starts from the current state
+			if ( message.type == MessageType::join )
+			{
+				peers.push_back( { peer, now } );
+				send( peer, stateMessage(), out );
+			}
+			return;
+		}
+		known->lastHeard = now;
+
+		switch ( message.type )
+		{
+			case MessageType::shot:
+			case MessageType::reset:
+			{
+				// a resend, the client missed the broadcast of its input
+				if ( message.sequence <= inputs )
+				{
+					send( peer, message.sequence == inputs && inputs ? lastInput : stateMessage(), out );
+					break;
+				}
+
+				// the client played on a state the server does not have, let it catch up
+				if ( message.sequence != inputs + 1 || ( message.type == MessageType::shot && match.isBallsMoving() ) )
+				{
+					send( peer, stateMessage(), out );
+					break;
+				}
+
+				lastInput = header( message.type );
+				lastInput.sequence = message.sequence;
+				if ( message.type == MessageType::shot )
+				{
+					lastInput.target = message.target;
+					lastInput.charge = message.charge;
+					match.shoot( message.target, message.charge );
+				}
+				else
+					match.reset();
+
+				inputs = message.sequence;
+				broadcast( lastInput, out );
+				break;
+			}
+
+			case MessageType::state:
+				send( peer, stateMessage(), out );
+				break;
+
+			case MessageType::join:
+			case MessageType::checksum:
+			case MessageType::watch:
+			case MessageType::snapshot:
+				break;
+		}
+	}
+
+
+	void ServerMatch::update( float dt, double now, std::vector< Outgoing >& out )
+	{
+		constexpr float timeStep = Params::Physics::timeStep;
+
+		if ( match.isBallsMoving() )
+		{
+			// single ticks, so a checksum can go out after any of them
+			accumulator += dt;
+			while ( accumulator >= timeStep && match.isBallsMoving() )
+			{
+				match.update( timeStep );
+				accumulator -= timeStep;
+
+				if ( !match.isBallsMoving() || match.elapsedTicks() % Params::Network::checksumTicks == 0 )
+					sendChecksum( now, out );
+			}
+		}
+		else
+		{
+			accumulator = 0.f;
+			if ( now - lastChecksum >= Params::Network::heartbeatInterval )
+				sendChecksum( now, out );
+		}
+
+		peers.erase( std::remove_if( peers.begin(), peers.end(), [ now ]( Peer const& peer )
+		{
+			return now - peer.lastHeard > Params::Network::peerTimeout;
+		} ), peers.end() );
+
+		sendSnapshots( now, out );
+	}
+
+
+	bool ServerMatch::isBallsMoving() const
+	{
+		return match.isBallsMoving();
+	}
+
+
+	bool ServerMatch::isAbandoned( double now ) const
+	{
+		return std::none_of( peers.begin(), peers.end(), [ now ]( Peer const& peer )
+		{
+			return now - peer.lastHeard <= Params::Network::peerTimeout;
+		} );
+	}
+
+
+	int ServerMatch::spectatorCount() const
+	{
+		return int( spectators.size() );
+	}
+}
+
+
+//-------------------------------------------------------
+//	client
+//-------------------------------------------------------
+
+namespace Net
+{
+	ClientMatch::ClientMatch( Match& match, std::uint32_t id ) :
+		match( match ),
+		id( id )
+	{
+		match.setDeterministic( true );
+
+		// a handful of inputs are in flight at a time, checksums are capped at 16 below
+		unacked.reserve( 16 );
+		remote.reserve( 16 );
+		pending.reserve( 17 );
+	}
+
+
+	Message ClientMatch::header( MessageType type ) const
+	{
+		Message message;
+		message.type = type;
+		message.match = id;
+		message.sequence = inputs;
+		message.tick = match.elapsedTicks();
+		return message;
+	}
+
+
+	void ClientMatch::send( Message const& message, DatagramQueue& out )
+	{
+		if ( !encode( message, out.push() ) )
+			out.pop();
+	}
+
+
+	void ClientMatch::join( DatagramQueue& out )
+	{
+		send( header( MessageType::join ), out );
+	}
+
+
+	void ClientMatch::requestState( DatagramQueue& out )
+	{
+		if ( stateRequested )
+			return;
+		stateRequested = true;
+		send( header( MessageType::state ), out );
+	}
+
+
+	void ClientMatch::apply( Message const& input )
+	{
+		if ( input.type == MessageType::shot )
+			match.shoot( input.target, input.charge );
+		else
+			match.reset();
+		inputs = input.sequence;
+	}
+
+
+	void ClientMatch::record()
+	{
+		Sample& sample = history[ match.elapsedTicks() % history.size() ];
+		sample.sequence = inputs;
+		sample.tick = match.elapsedTicks();
+		sample.hash = checksum( match.simulation().stateHash() );
+	}
+
+
+	bool ClientMatch::verify( Message const& server, DatagramQueue& out )
+	{
+		Sample const& sample = history[ server.tick % history.size() ];
+		if ( sample.sequence == server.sequence && sample.tick == server.tick )
+		{
+			if ( sample.hash != server.hash )
+				requestState( out );
+			return true;
+		}
+
+		if ( server.sequence == inputs && server.tick > match.elapsedTicks() )
+		{
+			// the server is ahead, unless the balls here already stopped
+			if ( match.isBallsMoving() )
+				return false;
+			requestState( out );
+			return true;
+		}
+
+		if ( server.sequence > inputs )
+		{
+			// inputs are sent before the checksums that follow them, none waiting means it got lost
+			if ( !remote.empty() )
+				return false;
+			requestState( out );
+		}
+
+		// behind this table and out of the history
+		return true;
+	}
+
+
+	void ClientMatch::receive( Message const& message, DatagramQueue& out )
+	{
+		if ( message.match != id )
+			return;
+
+		switch ( message.type )
+		{
+			case MessageType::shot:
+			case MessageType::reset:
+			{
+				// an own input coming back, the server played it where this table did
+				auto own = std::find_if( unacked.begin(), unacked.end(), [ &message ]( Message const& input )
+				{
+					return input.sequence == message.sequence;
+				} );
+				if ( own != unacked.end() )
+				{
+					if ( own->type != message.type || own->tick != message.tick ||
+						own->target.x != message.target.x || own->target.y != message.target.y || own->charge != message.charge )
+						requestState( out );
+					unacked.erase( unacked.begin(), own + 1 );
+					break;
+				}
+
+				if ( message.sequence <= inputs )
+					break;
+
+				// kept in sequence order, datagrams can arrive out of order or twice
+				auto at = std::find_if( remote.begin(), remote.end(), [ &message ]( Message const& input )
+				{
+					return input.sequence >= message.sequence;
+				} );
+				if ( at == remote.end() || at->sequence != message.sequence )
+					remote.insert( at, message );
+				break;
+			}
+
+			case MessageType::checksum:
+				if ( !verify( message, out ) )
+				{
+					pending.push_back( message );
+					if ( pending.size() > 16 )
+						pending.erase( pending.begin() );
+				}
+				break;
+
+			case MessageType::state:
+			{
+				if ( !message.balls.size() )
+					break;
+
+				if ( joined )
+					repaired++;
+				joined = true;
+
+				match.restore( message.balls, message.moving, message.tick );
+				inputs = message.sequence;
+				accumulator = 0.f;
+				stateRequested = false;
+				unacked.clear();
+				pending.clear();
+				history.fill( Sample() );
+				remote.erase( std::remove_if( remote.begin(), remote.end(), [ this ]( Message const& input )
+				{
+					return input.sequence <= inputs;
+				} ), remote.end() );
+				record();
+				break;
+			}
+
+			case MessageType::join:
+			case MessageType::watch:
+			case MessageType::snapshot:
+				break;
+		}
+	}
+
+
+	void ClientMatch::applyRemote( DatagramQueue& out )
+	{
+		while ( !remote.empty() && !stateRequested )
+		{
+			Message const& input = remote.front();
+			if ( input.sequence > inputs + 1 )
+			{
+				requestState( out );
+				return;
+			}
+
+			// played at the tick the server played it, shots only happen at rest
+			if ( match.elapsedTicks() < input.tick && match.isBallsMoving() )
+				return;
+			if ( match.elapsedTicks() != input.tick || ( input.type == MessageType::shot && match.isBallsMoving() ) )
+			{
+				requestState( out );
+				return;
+			}
+
+			apply( input );
+			remote.erase( remote.begin() );
+			record();
+		}
+	}
+
+
+	void ClientMatch::update( float dt, double now, DatagramQueue& out )
+	{
+		constexpr float timeStep = Params::Physics::timeStep;
+
+		applyRemote( out );
+		if ( !match.isBallsMoving() )
+		{
+			// only the shot charge advances
+			accumulator = 0.f;
+			match.update( dt );
+		}
+		else
+		{
+			accumulator += dt;
+			for ( int steps = 0; accumulator >= timeStep && match.isBallsMoving() && steps < Params::Physics::maxStepsPerFrame; steps++ )
+			{
+				match.update( timeStep );
+				accumulator -= timeStep;
+				record();
+
+				pending.erase( std::remove_if( pending.begin(), pending.end(), [ this, &out ]( Message const& checksum )
+				{
+					return verify( checksum, out );
+				} ), pending.end() );
+				applyRemote( out );
+			}
+		}
+
+		if ( now - lastKeepalive >= Params::Network::heartbeatInterval )
+		{
+			join( out );
+			lastKeepalive = now;
+		}
+
+		if ( now - lastResend >= Params::Network::resendInterval )
+		{
+			for ( Message const& input : unacked )
+				send( input, out );
+			if ( stateRequested )
+				send( header( MessageType::state ), out );
+			lastResend = now;
+		}
+	}
+
+
+	void ClientMatch::buttonReleased( Vector2 target, float offset, DatagramQueue& out )
+	{
+		// inputs of others are played first
+		if ( match.isBallsMoving() || !remote.empty() || stateRequested )
+			return;
+
+		Message input = header( MessageType::shot );
+		input.sequence = inputs + 1;
+		input.target = target;
+		input.charge = match.shotChargeAt( offset );
+
+		apply( input );
+		unacked.push_back( input );
+		send( input, out );
+	}
+
+
+	void ClientMatch::reset( DatagramQueue& out )
+	{
+		Message input = header( MessageType::reset );
+		input.sequence = inputs + 1;
+
+		apply( input );
+		record();
+		unacked.push_back( input );
+		send( input, out );
+	}
+
+
+	unsigned ClientMatch::repairs() const
+	{
+		return repaired;
+	}
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "vector2.hpp"
+#include "match.hpp"
+#include "netprotocol.hpp"
+#include "spectator.hpp"
+
+
+//-------------------------------------------------------
+//	server authoritative matches over the datagram protocol
+//-------------------------------------------------------
+
+// Both sides run the match in deterministic mode and step it one tick at a
+// time, so inputs, ticks and hashes line up exactly. Neither side touches a
+// socket: received messages go in, datagrams to send come out.
+namespace Net
+{
+	// opaque address of a client, the transport maps it back
+	using PeerId = std::uint64_t;
+
+
+	struct Outgoing
+	{
+		PeerId peer;
+		Datagram datagram;
+	};
+
+
+	// the authoritative table of one match, applies inputs and broadcasts them with checksums
+	class ServerMatch
+	{
+	public:
+		explicit ServerMatch( std::uint32_t id );
+
+		void receive( PeerId peer, Message const& message, double now, std::vector< Outgoing >& out );
+		// called once per server tick, a table at rest only sends heartbeats,
+		// the outgoing datagrams have to be sent before the next call
+		void update( float dt, double now, std::vector< Outgoing >& out );
+
+		bool isBallsMoving() const;
+		// every client timed out, spectators do not keep a match
+		bool isAbandoned( double now ) const;
+		int spectatorCount() const;
+
+	private:
+		struct Peer
+		{
+			PeerId id;
+			double lastHeard;
+		};
+
+		struct Spectator
+		{
+			PeerId id;
+			double lastHeard;
+			// 0 until the first snapshot is acked
+			std::uint32_t acked;
+		};
+
+		Message header( MessageType type ) const;
+		Message stateMessage() const;
+		void send( PeerId peer, Message const& message, std::vector< Outgoing >& out );
+		void broadcast( Message const& message, std::vector< Outgoing >& out );
+		void sendChecksum( double now, std::vector< Outgoing >& out );
+		void watch( PeerId peer, std::uint32_t frame, double now, std::vector< Outgoing >& out );
+		bool captureSnapshot();
+		void sendSnapshots( double now, std::vector< Outgoing >& out );
+
+		std::uint32_t id;
+		Match match;
+		std::vector< Peer > peers;
+		std::vector< Spectator > spectators;
+		SpectatorStream stream;
+		double lastSnapshot = 0.0;
+		unsigned inputs = 0;
+		// kept to answer a client whose copy of the broadcast got lost
+		Message lastInput;
+		float accumulator = 0.f;
+		double lastChecksum = 0.0;
+	};
+
+
+	// client side of a match, plays local inputs at once and repairs from the server on mismatch
+	class ClientMatch
+	{
+	public:
+		ClientMatch( Match& match, std::uint32_t id );
+
+		void join( DatagramQueue& out );
+		void receive( Message const& message, DatagramQueue& out );
+		// steps the match, also sends keepalives and inputs still waiting for the server
+		void update( float dt, double now, DatagramQueue& out );
+
+		// offset as in Match::buttonReleased
+		void buttonReleased( Vector2 target, float offset, DatagramQueue& out );
+		void reset( DatagramQueue& out );
+
+		// number of states taken over from the server after a mismatch
+		unsigned repairs() const;
+
+	private:
+		struct Sample
+		{
+			unsigned sequence = ~0u;
+			unsigned tick = 0;
+			std::uint32_t hash = 0;
+		};
+
+		Message header( MessageType type ) const;
+		void send( Message const& message, DatagramQueue& out );
+		void apply( Message const& input );
+		// plays inputs of others once this table reaches the tick they were played at
+		void applyRemote( DatagramQueue& out );
+		void record();
+		// compares a server checksum, returns false when it can only be checked later
+		bool verify( Message const& checksum, DatagramQueue& out );
+		void requestState( DatagramQueue& out );
+
+		Match& match;
+		std::uint32_t id;
+		unsigned inputs = 0;
+		float accumulator = 0.f;
+		double lastKeepalive = 0.0;
+		double lastResend = 0.0;
+		bool stateRequested = false;
+		bool joined = false;
+		unsigned repaired = 0;
+
+		// own inputs the server has not echoed yet, and inputs of others waiting for the balls to stop
+		std::vector< Message > unacked;
+		std::vector< Message > remote;
+		// checksums for ticks not simulated yet
+		std::vector< Message > pending;
+		// hashes of the most recent ticks, slot tick % size
+		std::array< Sample, 256 > history;
+	};
+}
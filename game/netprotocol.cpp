@@ -0,0 +1,253 @@
+#include <cmath>
+
+#include "netprotocol.hpp"
+#include "bytestream.hpp"
+
+
+namespace Net
+{
+	namespace
+	{
+		// one bit per ball, eight balls per byte
+		template< class Predicate >
+		void writeMask( ByteWriter& writer, int count, Predicate bit )
+		{
+			for ( int i = 0; i < count; i += 8 )
+			{
+				std::uint8_t mask = 0;
+				for ( int b = 0; b < 8 && i + b < count; b++ )
+					mask |= bit( i + b ) ? 1 << b : 0;
+				writer.u8( mask );
+			}
+		}
+
+		void readMask( ByteReader& reader, std::vector< std::uint8_t >& bits )
+		{
+			for ( size_t i = 0; i < bits.size(); i += 8 )
+			{
+				std::uint8_t mask = reader.u8();
+				for ( size_t b = 0; b < 8 && i + b < bits.size(); b++ )
+					bits[ i + b ] = ( mask >> b ) & 1;
+			}
+		}
+
+		// negative zero counts, the state has to come out bit for bit
+		bool hasVelocity( Physics::BallStore const& balls, int i )
+		{
+			return balls.vx[ i ] != 0.f || balls.vy[ i ] != 0.f || std::signbit( balls.vx[ i ] ) || std::signbit( balls.vy[ i ] );
+		}
+
+		void writeState( ByteWriter& writer, Physics::BallStore const& balls )
+		{
+			const int n = balls.size();
+			writer.varint( n );
+			writeMask( writer, n, [ &balls ]( int i ) { return balls.alive[ i ] != 0; } );
+
+			// lossless, the receiver resimulates from it; resting balls send no velocity
+			for ( int i = 0; i < n; i++ )
+			{
+				writer.f32( balls.x[ i ] );
+				writer.f32( balls.y[ i ] );
+			}
+			writeMask( writer, n, [ &balls ]( int i ) { return hasVelocity( balls, i ); } );
+			for ( int i = 0; i < n; i++ )
+			{
+				if ( hasVelocity( balls, i ) )
+				{
+					writer.f32( balls.vx[ i ] );
+					writer.f32( balls.vy[ i ] );
+				}
+			}
+		}
+
+		bool readState( ByteReader& reader, Physics::BallStore& balls )
+		{
+			const std::uint64_t n = reader.varint();
+			// a ball takes at least 8 bytes, so bigger counts cannot come from a valid datagram
+			if ( !n || n > maxDatagram / 8 )
+				return false;
+
+			balls.resize( int( n ) );
+			readMask( reader, balls.alive );
+			for ( std::uint64_t i = 0; i < n; i++ )
+			{
+				balls.x[ i ] = reader.f32();
+				balls.y[ i ] = reader.f32();
+			}
+
+			std::vector< std::uint8_t > moving( n );
+			readMask( reader, moving );
+			for ( std::uint64_t i = 0; i < n; i++ )
+			{
+				balls.vx[ i ] = moving[ i ] ? reader.f32() : 0.f;
+				balls.vy[ i ] = moving[ i ] ? reader.f32() : 0.f;
+			}
+			return true;
+		}
+	}
+
+
+	bool encode( Message const& message, std::vector< std::uint8_t >& datagram )
+	{
+		datagram.clear();
+		ByteWriter writer( datagram );
+		writer.u8( protocolVersion );
+		writer.u8( std::uint8_t( message.type ) );
+		writer.varint( message.match );
+		writer.varint( message.sequence );
+		writer.varint( message.tick );
+
+		switch ( message.type )
+		{
+			case MessageType::shot:
+				writer.f32( message.target.x );
+				writer.f32( message.target.y );
+				writer.f32( message.charge );
+				break;
+
+			case MessageType::checksum:
+				writer.u32( message.hash );
+				break;
+
+			case MessageType::watch:
+				writer.varint( message.frame );
+				break;
+
+			// only the spectator stream writes snapshots
+			case MessageType::snapshot:
+				return false;
+
+			case MessageType::state:
+				// a request has no balls and ends after the header
+				if ( message.balls.size() )
+				{
+					writer.u8( message.moving ? 1 : 0 );
+					writeState( writer, message.balls );
+				}
+				break;
+
+			case MessageType::join:
+			case MessageType::reset:
+				break;
+		}
+		return datagram.size() <= maxDatagram;
+	}
+
+
+	bool decode( std::uint8_t const* data, size_t size, Message& message )
+	{
+		ByteReader reader( data, size );
+		if ( reader.u8() != protocolVersion )
+			return false;
+
+		const std::uint8_t type = reader.u8();
+		if ( type < std::uint8_t( MessageType::join ) || type > std::uint8_t( MessageType::watch ) )
+			return false;
+
+		message.type = MessageType( type );
+		message.match = std::uint32_t( reader.varint() );
+		message.sequence = unsigned( reader.varint() );
+		message.tick = unsigned( reader.varint() );
+		message.balls.resize( 0 );
+
+		switch ( message.type )
+		{
+			case MessageType::shot:
+				message.target.x = reader.f32();
+				message.target.y = reader.f32();
+				message.charge = reader.f32();
+				if ( !std::isfinite( message.target.x ) || !std::isfinite( message.target.y ) || !( message.charge >= 0.f && message.charge <= 1.f ) )
+					return false;
+				break;
+
+			case MessageType::checksum:
+				message.hash = reader.u32();
+				break;
+
+			case MessageType::watch:
+				message.frame = std::uint32_t( reader.varint() );
+				break;
+
+			case MessageType::state:
+				if ( reader.atEnd() )
+					break;
+				message.moving = reader.u8() != 0;
+				if ( !readState( reader, message.balls ) )
+					return false;
+				break;
+
+			case MessageType::join:
+			case MessageType::reset:
+			case MessageType::snapshot:
+				break;
+		}
+		return !reader.failed() && reader.atEnd();
+	}
+
+
+	std::uint32_t checksum( std::uint64_t stateHash )
+	{
+		return std::uint32_t( stateHash ^ ( stateHash >> 32 ) );
+	}
+}
+
+
+//-------------------------------------------------------
+//	datagram queue
+//-------------------------------------------------------
+
+namespace Net
+{
+	std::vector< std::uint8_t >& DatagramQueue::push()
+	{
+		if ( count == buffers.size() )
+			buffers.emplace_back();
+
+		std::vector< std::uint8_t >& buffer = buffers[ count++ ];
+		buffer.clear();
+		return buffer;
+	}
+
+
+	void DatagramQueue::pop()
+	{
+		if ( count )
+			count--;
+	}
+
+
+	void DatagramQueue::clear()
+	{
+		count = 0;
+	}
+
+
+	size_t DatagramQueue::size() const
+	{
+		return count;
+	}
+
+
+	bool DatagramQueue::empty() const
+	{
+		return !count;
+	}
+
+
+	std::vector< std::uint8_t > const& DatagramQueue::operator[]( size_t i ) const
+	{
+		return buffers[ i ];
+	}
+
+
+	std::vector< std::vector< std::uint8_t > >::const_iterator DatagramQueue::begin() const
+	{
+		return buffers.begin();
+	}
+
+
+	std::vector< std::vector< std::uint8_t > >::const_iterator DatagramQueue::end() const
+	{
+		return buffers.begin() + count;
+	}
+}
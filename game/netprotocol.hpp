@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "vector2.hpp"
+#include "ballstore.hpp"
+
+
+//-------------------------------------------------------
+//	datagram protocol of networked matches
+//-------------------------------------------------------
+
+// Only inputs travel in the normal case. Every table is deterministic, so the
+// state after a given number of inputs and ticks is the same everywhere, and the
+// server sends 32 bit checksums of it that the clients compare against their
+// own. A full state is sent on joining and when a client reports a mismatch.
+namespace Net
+{
+	constexpr std::uint8_t protocolVersion = 1;
+	// largest datagram the encoder writes, a state of a few hundred balls fits
+	constexpr size_t maxDatagram = 8192;
+
+	enum class MessageType : std::uint8_t
+	{
+		// client to server, joins the match or keeps the membership alive
+		join = 1,
+		// both ways, an input, from the server it is the applied one
+		shot = 2,
+		reset = 3,
+		// server to client
+		checksum = 4,
+		// client to server asks for a state, server to client carries it
+		state = 5,
+		// spectator to server, watches the match and acks the last snapshot frame applied
+		watch = 6,
+		// server to spectator, written and read by the spectator stream, decode rejects it
+		snapshot = 7
+	};
+
+
+	// encoded once and shared by every peer it goes to
+	using Datagram = std::shared_ptr< std::vector< std::uint8_t > const >;
+
+
+	struct Message
+	{
+		MessageType type = MessageType::join;
+		std::uint32_t match = 0;
+
+		// inputs applied to the table including this one and its simulation ticks
+		unsigned sequence = 0;
+		unsigned tick = 0;
+
+		// shot
+		Vector2 target;
+		float charge = 0.f;
+
+		// checksum
+		std::uint32_t hash = 0;
+
+		// watch, 0 before the first snapshot
+		std::uint32_t frame = 0;
+
+		// state, empty in a request
+		bool moving = false;
+		Physics::BallStore balls;
+	};
+
+
+	// false when the message does not fit into maxDatagram
+	bool encode( Message const& message, std::vector< std::uint8_t >& datagram );
+	// false for anything that is not a well formed message of this protocol version
+	bool decode( std::uint8_t const* data, size_t size, Message& message );
+
+	// fold of the deterministic state hash that goes on the wire
+	std::uint32_t checksum( std::uint64_t stateHash );
+
+
+	// datagrams waiting to be sent by a client, clear keeps the buffers, so a
+	// steady stream of messages stops allocating once the queue reached its peak
+	class DatagramQueue
+	{
+	public:
+		// an empty buffer at the end of the queue
+		std::vector< std::uint8_t >& push();
+		// takes back the last push, for a message that did not encode
+		void pop();
+		void clear();
+
+		size_t size() const;
+		bool empty() const;
+		std::vector< std::uint8_t > const& operator[]( size_t i ) const;
+
+		std::vector< std::vector< std::uint8_t > >::const_iterator begin() const;
+		std::vector< std::vector< std::uint8_t > >::const_iterator end() const;
+
+	private:
+		std::vector< std::vector< std::uint8_t > > buffers;
+		size_t count = 0;
+	};
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+
+#include "vector2.hpp"
+
+
+//-------------------------------------------------------
+//	game parameters
+//-------------------------------------------------------
+
+namespace Params
+{
+	namespace System
+	{
+		constexpr int targetFPS = 60;
+		// off by default, the frame limiter paces drawing as it did without swap control
+		constexpr bool vsync = false;
+	}
+
+	namespace Table
+	{
+		constexpr float width = 15.f;
+		constexpr float height = 8.f;
+		constexpr float pocketRadius = 0.5f;
+
+		static constexpr std::array< Vector2, 6 > pocketsPositions =
+		{
+			Vector2{ -0.5f * width, -0.5f * height },
+			Vector2{ 0.f, -0.5f * height },
+			Vector2{ 0.5f * width, -0.5f * height },
+			Vector2{ -0.5f * width, 0.5f * height },
+			Vector2{ 0.f, 0.5f * height },
+			Vector2{ 0.5f * width, 0.5f * height }
+		};
+
+		static constexpr std::array< Vector2, 7 > ballsPositions =
+		{
+			// player ball
+			Vector2( -0.3f * width, 0.f ),
+			// other balls
+			Vector2( 0.2f * width, 0.f ),
+			Vector2( 0.25f * width, 0.05f * height ),
+			Vector2( 0.25f * width, -0.05f * height ),
+			Vector2( 0.3f * width, 0.1f * height ),
+			Vector2( 0.3f * width, 0.f ),
+			Vector2( 0.3f * width, -0.1f * height )
+		};
+	}
+
+	namespace Ball
+	{
+		constexpr float radius = 0.3f;
+	}
+
+	namespace Physics
+	{
+		// simulation runs with a constant step independent of the frame rate
+		constexpr float timeStep = 1.f / 120.f;
+		// upper bound of steps per frame, extra time is dropped
+		constexpr int maxStepsPerFrame = 32;
+		// discrete steps are split until no two balls can close in by more than this share
+		// of the ball radius within one part, fast shots only, resting clusters keep one part
+		constexpr float substepTravel = 0.5f;
+		constexpr int maxSubsteps = 8;
+		// passes of the contact solver over the contacts of a step, the velocity passes end
+		// early once no impulse changed by more than the tolerance, the position passes
+		// once nothing overlaps by more than the slop
+		constexpr int velocityIterations = 8;
+		constexpr int positionIterations = 2;
+		constexpr float solverTolerance = 1e-4f;
+		// overlap left in place as a share of the ball radius, so resting contacts persist
+		// into the next step and warm start it
+		constexpr float contactSlop = 0.01f;
+		// approach speed below which ball contacts do not bounce
+		constexpr float restitutionThreshold = 0.05f;
+		// upper bound of resolved impacts per continuous step, the discrete phases finish the rest
+		constexpr int maxEventsPerStep = 4096;
+		// upper bound of impacts the analytic resolver follows for one shot
+		constexpr int maxEventsPerShot = 65536;
+
+		constexpr float deceleration = 0.05f * Table::width;
+		constexpr float cushionLoss = 0.15f;
+		// share of the normal velocity passed to the other ball
+		constexpr float ballTransfer = 0.85f;
+		constexpr float ballRestitution = 0.95f;
+	}
+
+	namespace Layout
+	{
+		// compiled table file loaded at start, relative to the working directory
+		constexpr char const* file = "tables/default.tbl";
+		// seconds between two checks of the file for a hot reload
+		constexpr float reloadInterval = 0.5f;
+	}
+
+	namespace Network
+	{
+		// server host of networked matches, empty plays offline
+		constexpr char const* server = "";
+		constexpr unsigned short port = 27960;
+		// match joined by the game, every client of a match sees the same table
+		constexpr unsigned match = 1;
+
+		// ticks between two checksums while the balls move
+		constexpr unsigned checksumTicks = 60;
+		// seconds between checksums at rest and between keepalives of the clients
+		constexpr float heartbeatInterval = 1.f;
+		// seconds until an input without an answer from the server is sent again
+		constexpr float resendInterval = 0.2f;
+		// seconds of silence after which the server drops a client
+		constexpr float peerTimeout = 10.f;
+
+		// snapshot frames a spectator ack can lag behind and still get a delta, older ones get a keyframe
+		constexpr unsigned spectatorHistory = 64;
+		// seconds between the acks of a spectator while new frames come in
+		constexpr float spectatorAckInterval = 0.1f;
+	}
+
+	namespace Replay
+	{
+		// simulation ticks between two keyframes, bounds the work of a seek
+		constexpr unsigned keyframeInterval = 120;
+	}
+
+	namespace Ai
+	{
+		// wall clock time of one decision, no round starts that would not fit
+		constexpr double decisionBudget = 0.05;
+		// shots in the first round around every object ball and pocket pair, and the cap of that round
+		constexpr int samplesPerPair = 8;
+		constexpr int firstRoundSize = 1024;
+		// later rounds sample this many shots around the best ones of the round before
+		constexpr int roundSize = 256;
+		constexpr int elites = 16;
+		constexpr int maxRounds = 8;
+		// spread of the first round in radians and charge, every round halves it
+		constexpr float angleSpread = 0.02f;
+		constexpr float chargeSpread = 0.25f;
+		// the computer takes every other shot of the local game
+		constexpr bool opponent = false;
+	}
+
+	namespace Shot
+	{
+		constexpr float chargeTime = 1.f;
+		// cushion bounces the aim preview follows before it stops tracing
+		constexpr int previewEvents = 16;
+	}
+}
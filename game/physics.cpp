@@ -0,0 +1,446 @@
+#include <cmath>
+#include <algorithm>
+
+#include "physics.hpp"
+#include "determinism.hpp"
+#include "params.hpp"
+#include "kernels.hpp"
+#include "contacts.hpp"
+#include "../framework/profiler.hpp"
+
+
+//-------------------------------------------------------
+//	step phases not covered by the simd kernels
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace
+	{
+		void removePocketed( BallStore& balls, int i )
+		{
+			balls.alive[ i ] = 0;
+			balls.vx[ i ] = 0.f;
+			balls.vy[ i ] = 0.f;
+		}
+	}
+
+
+	namespace Phases
+	{
+		bool checkPockets( BallStore& balls, PocketLookup const& pockets )
+		{
+			for ( int i = 0, n = balls.size(); i < n; i++ )
+			{
+				if ( !balls.alive[ i ] || pockets.capture( balls.x[ i ], balls.y[ i ] ) < 0 )
+					continue;
+
+				removePocketed( balls, i );
+				if ( !i )
+					return false;
+			}
+			return true;
+		}
+
+
+		bool checkPockets( BallStore& balls, PocketLookup const& pockets, ActiveSet const& active )
+		{
+			for ( int i : active.balls() )
+			{
+				if ( !balls.alive[ i ] || pockets.capture( balls.x[ i ], balls.y[ i ] ) < 0 )
+					continue;
+
+				removePocketed( balls, i );
+				if ( !i )
+					return false;
+			}
+			return true;
+		}
+
+
+		template< class R >
+		void checkBallCollisions( BallStore& balls, BroadPhase& broadPhase, BasicContactSolver< R >& solver )
+		{
+			broadPhase.build( balls );
+			solver.gather( balls, broadPhase.pairs() );
+			solver.solve( balls );
+		}
+
+
+		template< class R >
+		void checkBallCollisions( BallStore& balls, BroadPhase& broadPhase, BasicContactSolver< R >& solver, ActiveSet& active, bool sparse )
+		{
+			if ( sparse )
+				broadPhase.build( balls, active );
+			else
+				broadPhase.build( balls );
+
+			solver.gather( balls, broadPhase.pairs() );
+			for ( Contact const& contact : solver.contacts() )
+			{
+				active.wake( contact.a );
+				active.wake( contact.b );
+			}
+			solver.solve( balls );
+		}
+
+
+		template void checkBallCollisions< Rules::Pool >( BallStore&, BroadPhase&, BasicContactSolver< Rules::Pool >& );
+		template void checkBallCollisions< Rules::Snooker >( BallStore&, BroadPhase&, BasicContactSolver< Rules::Snooker >& );
+		template void checkBallCollisions< Rules::Carom >( BallStore&, BroadPhase&, BasicContactSolver< Rules::Carom >& );
+		template void checkBallCollisions< Rules::Elastic >( BallStore&, BroadPhase&, BasicContactSolver< Rules::Elastic >& );
+
+		template void checkBallCollisions< Rules::Pool >( BallStore&, BroadPhase&, BasicContactSolver< Rules::Pool >&, ActiveSet&, bool );
+		template void checkBallCollisions< Rules::Snooker >( BallStore&, BroadPhase&, BasicContactSolver< Rules::Snooker >&, ActiveSet&, bool );
+		template void checkBallCollisions< Rules::Carom >( BallStore&, BroadPhase&, BasicContactSolver< Rules::Carom >&, ActiveSet&, bool );
+		template void checkBallCollisions< Rules::Elastic >( BallStore&, BroadPhase&, BasicContactSolver< Rules::Elastic >&, ActiveSet&, bool );
+	}
+}
+
+
+//-------------------------------------------------------
+//	fixed timestep simulation
+//-------------------------------------------------------
+
+namespace Physics
+{
+	template< class R >
+	void BasicSimulation< R >::setStepping( Stepping mode )
+	{
+		stepping = mode;
+		// the continuous stepper does not keep the active set
+		wakeMoving();
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::setTimeStep( float dt )
+	{
+		timeStep = dt;
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::setSolverIterations( int velocity, int position )
+	{
+		solver.setIterations( velocity, position );
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::setDeterministic( bool enabled )
+	{
+		deterministic = enabled;
+		if ( deterministic )
+			timeStep = Params::Physics::timeStep;
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::reset( std::vector< Vector2 > const& layout )
+	{
+		balls.assign( layout );
+		active.reset( balls.size() );
+		broadPhase.reserve( balls.size() );
+		solver.reserve( balls.size() );
+		solver.clear();
+		stopped.reserve( balls.size() );
+		accumulator = 0.f;
+		ballsMoving = false;
+		cueBallPocketed = false;
+		ticks = 0;
+		hash = Determinism::hash( balls );
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::restore( BallStore const& state, bool moving )
+	{
+		balls = state;
+		wakeMoving();
+		broadPhase.reserve( balls.size() );
+		solver.reserve( balls.size() );
+		solver.clear();
+		stopped.reserve( balls.size() );
+		accumulator = 0.f;
+		ballsMoving = moving;
+		cueBallPocketed = false;
+		hash = Determinism::hash( balls );
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::restore( BallStore const& state, bool moving, std::vector< Contact > const& warmStart )
+	{
+		restore( state, moving );
+		solver.restore( warmStart, balls.size() );
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::shoot( Vector2 target, float charge )
+	{
+		if ( ballsMoving || !balls.size() )
+			return;
+
+		Vector2 direction = { target.x - balls.x[ 0 ], target.y - balls.y[ 0 ] };
+		direction.normalize();
+		balls.vx[ 0 ] = direction.x * charge * R::width;
+		balls.vy[ 0 ] = direction.y * charge * R::width;
+		active.wake( 0 );
+
+		accumulator = 0.f;
+		ballsMoving = true;
+	}
+
+
+	template< class R >
+	int BasicSimulation< R >::advance( float dt )
+	{
+		if ( !ballsMoving )
+			return 0;
+
+		accumulator += dt;
+
+		int steps = 0;
+		while ( accumulator >= timeStep && ballsMoving )
+		{
+			if ( steps == Params::Physics::maxStepsPerFrame )
+			{
+				// deterministic runs keep the backlog and catch up later
+				if ( !deterministic )
+					accumulator = 0.f;
+				break;
+			}
+			step();
+			accumulator -= timeStep;
+			steps++;
+		}
+		return steps;
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::step()
+	{
+		stepOnce();
+
+		if ( deterministic )
+		{
+			ticks++;
+			hash = Determinism::hash( balls );
+		}
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::stepOnce()
+	{
+		if ( stepping == Stepping::continuous )
+		{
+			bool cueBallOnTable;
+			{
+				PROFILE_SCOPE( collisions );
+				cueBallOnTable = continuousStepper.step( balls, timeStep );
+			}
+			if ( cueBallOnTable && continuousStepper.unresolvedTime() > 0.f )
+				cueBallOnTable = finishDiscrete( continuousStepper.unresolvedTime() );
+
+			if ( !cueBallOnTable )
+			{
+				// scratch, the table has to be reset by the owner
+				cueBallPocketed = true;
+				ballsMoving = false;
+			}
+			else if ( !balls.isMoving() )
+				ballsMoving = false;
+			return;
+		}
+
+		const int parts = substeps( timeStep );
+		for ( int part = 0; part < parts; part++ )
+		{
+			if ( !substep( timeStep / float( parts ) ) )
+			{
+				cueBallPocketed = true;
+				ballsMoving = false;
+				return;
+			}
+		}
+
+		if ( !settleStopped() )
+		{
+			cueBallPocketed = true;
+			ballsMoving = false;
+			return;
+		}
+
+		if ( !active.count() )
+			ballsMoving = false;
+	}
+
+
+	template< class R >
+	bool BasicSimulation< R >::substep( float dt )
+	{
+		// the simd kernels over every ball beat gathers once most of the table is awake
+		const bool sparse = 2 * active.count() < balls.size();
+
+		if constexpr ( Contacts::Table< R >::hasPockets )
+		{
+			PROFILE_SCOPE( pockets );
+			if ( !( sparse ? Phases::checkPockets( balls, pockets, active ) : Phases::checkPockets( balls, pockets ) ) )
+				return false;
+		}
+
+		{
+			PROFILE_SCOPE( borders );
+			if ( sparse )
+				Kernels::checkBorders( balls, active.balls(), Contacts::Table< R >::cushions );
+			else
+				Kernels::checkBorders( balls, Contacts::Table< R >::cushions );
+		}
+
+		{
+			PROFILE_SCOPE( collisions );
+			Phases::checkBallCollisions< R >( balls, broadPhase, solver, active, sparse );
+		}
+		{
+			PROFILE_SCOPE( integration );
+			if ( sparse )
+			{
+				Kernels::integrate( balls, active.balls(), dt );
+				Kernels::applyFriction( balls, active.balls(), R::deceleration, dt );
+			}
+			else
+			{
+				Kernels::integrate( balls, dt );
+				Kernels::applyFriction( balls, R::deceleration, dt );
+			}
+		}
+		return true;
+	}
+
+
+	template< class R >
+	bool BasicSimulation< R >::finishDiscrete( float dt )
+	{
+		// the continuous stepper does not keep the active set
+		wakeMoving();
+		const int parts = substeps( dt );
+		for ( int part = 0; part < parts; part++ )
+		{
+			if ( !substep( dt / float( parts ) ) )
+				return false;
+		}
+		return true;
+	}
+
+
+	template< class R >
+	int BasicSimulation< R >::substeps( float dt ) const
+	{
+		constexpr float travel = Params::Physics::substepTravel * R::ballRadius;
+
+		// every moving ball is awake, and two balls close in at twice the top speed at most
+		float top = 0.f;
+		for ( int i : active.balls() )
+			top = std::max( top, balls.vx[ i ] * balls.vx[ i ] + balls.vy[ i ] * balls.vy[ i ] );
+
+		const float closing = 2.f * std::sqrt( top ) * dt;
+		if ( closing <= travel )
+			return 1;
+		return std::min( int( std::ceil( closing / travel ) ), Params::Physics::maxSubsteps );
+	}
+
+
+	template< class R >
+	bool BasicSimulation< R >::settleStopped()
+	{
+		stopped.clear();
+		for ( int i : active.balls() )
+		{
+			if ( balls.vx[ i ] == 0.f && balls.vy[ i ] == 0.f )
+				stopped.push_back( i );
+		}
+
+		// the checks the next step would have done at the final position, a sleeping ball
+		// is only looked at again once a contact wakes it
+		bool cueBallOnTable = true;
+		if constexpr ( Contacts::Table< R >::hasPockets )
+		{
+			for ( int i : stopped )
+			{
+				if ( balls.alive[ i ] && pockets.capture( balls.x[ i ], balls.y[ i ] ) >= 0 )
+				{
+					removePocketed( balls, i );
+					cueBallOnTable = cueBallOnTable && i;
+				}
+			}
+		}
+		Kernels::checkBorders( balls, stopped, Contacts::Table< R >::cushions );
+
+		for ( int i : stopped )
+			active.sleep( i );
+		return cueBallOnTable;
+	}
+
+
+	template< class R >
+	void BasicSimulation< R >::wakeMoving()
+	{
+		active.reset( balls.size() );
+		for ( int i = 0, n = balls.size(); i < n; i++ )
+		{
+			if ( balls.vx[ i ] != 0.f || balls.vy[ i ] != 0.f )
+				active.wake( i );
+		}
+	}
+
+
+	template< class R >
+	bool BasicSimulation< R >::isBallsMoving() const
+	{
+		return ballsMoving;
+	}
+
+
+	template< class R >
+	bool BasicSimulation< R >::isCueBallPocketed() const
+	{
+		return cueBallPocketed;
+	}
+
+
+	template< class R >
+	BallStore const& BasicSimulation< R >::state() const
+	{
+		return balls;
+	}
+
+
+	template< class R >
+	std::vector< Contact > const& BasicSimulation< R >::warmStart() const
+	{
+		return solver.warmStart();
+	}
+
+
+	template< class R >
+	unsigned BasicSimulation< R >::tick() const
+	{
+		return ticks;
+	}
+
+
+	template< class R >
+	std::uint64_t BasicSimulation< R >::stateHash() const
+	{
+		return hash;
+	}
+
+	template class BasicSimulation< Rules::Pool >;
+	template class BasicSimulation< Rules::Snooker >;
+	template class BasicSimulation< Rules::Carom >;
+	template class BasicSimulation< Rules::Elastic >;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vector2.hpp"
+#include "params.hpp"
+#include "rules.hpp"
+#include "ballstore.hpp"
+#include "broadphase.hpp"
+#include "pockets.hpp"
+#include "activeset.hpp"
+#include "ccd.hpp"
+#include "solver.hpp"
+
+
+//-------------------------------------------------------
+//	headless table physics, no scene or window dependency
+//-------------------------------------------------------
+
+namespace Physics
+{
+	// discrete step phases, the simulation runs them in this order, exposed for benchmarks,
+	// the collision phases are instantiated in physics.cpp for every rule set
+	namespace Phases
+	{
+		// returns false when the player ball has dropped into a pocket
+		bool checkPockets( BallStore& balls, PocketLookup const& pockets );
+		template< class R >
+		void checkBallCollisions( BallStore& balls, BroadPhase& broadPhase, BasicContactSolver< R >& solver );
+
+		// awake balls only, sparse collisions skip pairs of two sleeping balls,
+		// both balls of a contact are woken
+		bool checkPockets( BallStore& balls, PocketLookup const& pockets, ActiveSet const& active );
+		template< class R >
+		void checkBallCollisions( BallStore& balls, BroadPhase& broadPhase, BasicContactSolver< R >& solver, ActiveSet& active, bool sparse );
+	}
+
+
+	enum class Stepping
+	{
+		// overlap tests after the fact, needs small steps
+		discrete,
+		// advances from impact to impact, no tunnelling at any step size
+		continuous
+	};
+
+
+	// one table of rule set R, every rule set gets its own step code with the
+	// constants folded in, instantiated in physics.cpp
+	template< class R >
+	class BasicSimulation
+	{
+	public:
+		BasicSimulation() = default;
+
+		void setStepping( Stepping mode );
+		void setTimeStep( float dt );
+		// velocity and position passes of the contact solver, discrete stepping only
+		void setSolverIterations( int velocity, int position );
+
+		// fixed step with no time dropped under load and a state hash after every tick
+		void setDeterministic( bool enabled );
+
+		void reset( std::vector< Vector2 > const& layout );
+		// continues from a saved state, without the warm start of the saved table the
+		// next steps differ from the ones it took while balls touch
+		void restore( BallStore const& state, bool moving );
+		void restore( BallStore const& state, bool moving, std::vector< Contact > const& warmStart );
+		void shoot( Vector2 target, float charge );
+
+		// consumes frame time in fixed steps, returns number of steps done
+		int advance( float dt );
+		void step();
+
+		bool isBallsMoving() const;
+		bool isCueBallPocketed() const;
+
+		BallStore const& state() const;
+		// contact impulses the next step starts from, saved with the state by replay keyframes
+		std::vector< Contact > const& warmStart() const;
+
+		// ticks since the last reset and the hash after the last one, deterministic mode only
+		unsigned tick() const;
+		std::uint64_t stateHash() const;
+
+	private:
+		void stepOnce();
+		// one discrete part of a step, returns false when the player ball was pocketed
+		bool substep( float dt );
+		// parts a discrete step of dt is split into, from the speed of the fastest ball
+		int substeps( float dt ) const;
+		// discrete parts for the end of a continuous step the impact budget did not reach,
+		// returns false when the player ball was pocketed
+		bool finishDiscrete( float dt );
+		// puts balls that came to rest to sleep, returns false when the player ball was pocketed
+		bool settleStopped();
+		void wakeMoving();
+
+		BallStore balls;
+		// awake exactly when moving at the end of a step, drives the sparse step path
+		ActiveSet active;
+		std::vector< int > stopped;
+		PocketLookup pockets{ { R::pockets.begin(), R::pockets.end() }, R::pocketRadius, R::width, R::height };
+		BroadPhase broadPhase{ R::ballRadius, R::width, R::height };
+		BasicContactSolver< R > solver;
+		Ccd::BasicStepper< R > continuousStepper;
+		Stepping stepping = Stepping::discrete;
+		float timeStep = Params::Physics::timeStep;
+		float accumulator = 0.f;
+		bool ballsMoving = false;
+		bool cueBallPocketed = false;
+
+		bool deterministic = false;
+		unsigned ticks = 0;
+		std::uint64_t hash = 0;
+	};
+
+
+	using Simulation = BasicSimulation< Rules::Pool >;
+}
@@ -0,0 +1,87 @@
+#include <cmath>
+#include <algorithm>
+
+#include "pockets.hpp"
+#include "determinism.hpp"
+#include "params.hpp"
+
+
+namespace Physics
+{
+	PocketLookup::PocketLookup() :
+		PocketLookup( { Params::Table::pocketsPositions.begin(), Params::Table::pocketsPositions.end() },
+			Params::Table::pocketRadius, Params::Table::width, Params::Table::height )
+	{
+	}
+
+
+	PocketLookup::PocketLookup( std::vector< Vector2 > const& pockets, float radius, float width, float height ) :
+		radiusSq( radius * radius ),
+		positions( pockets )
+	{
+		// nothing to capture, a single empty cell and no grid sized by a zero radius
+		if ( positions.empty() || radius <= 0.f )
+		{
+			cellStart.assign( 2, 0 );
+			return;
+		}
+
+		// cells of one pocket diameter, the pockets sit on the rails so the grid spans
+		// the table plus one radius on every side
+		const float cellSize = 2.f * radius;
+		inverseCellSize = 1.f / cellSize;
+		originX = -0.5f * width - radius;
+		originY = -0.5f * height - radius;
+		columns = std::max( 1, int( std::ceil( ( width + 2.f * radius ) * inverseCellSize ) ) );
+		rows = std::max( 1, int( std::ceil( ( height + 2.f * radius ) * inverseCellSize ) ) );
+
+		std::vector< std::vector< int > > lists( columns * rows );
+		for ( int p = 0; p < int( positions.size() ); p++ )
+		{
+			for ( int row = 0; row < rows; row++ )
+			{
+				for ( int column = 0; column < columns; column++ )
+				{
+					// closest point of the cell to the pocket centre
+					const float left = originX + column * cellSize;
+					const float bottom = originY + row * cellSize;
+					const float dx = std::min( std::max( positions[ p ].x, left ), left + cellSize ) - positions[ p ].x;
+					const float dy = std::min( std::max( positions[ p ].y, bottom ), bottom + cellSize ) - positions[ p ].y;
+					if ( dx * dx + dy * dy <= radiusSq )
+						lists[ row * columns + column ].push_back( p );
+				}
+			}
+		}
+
+		cellStart.assign( 1, 0 );
+		for ( std::vector< int > const& list : lists )
+		{
+			cellPockets.insert( cellPockets.end(), list.begin(), list.end() );
+			cellStart.push_back( int( cellPockets.size() ) );
+		}
+	}
+
+
+	int PocketLookup::cellOf( float x, float y ) const
+	{
+		// anything beyond the grid belongs to its border cells
+		int column = std::min( std::max( int( ( x - originX ) * inverseCellSize ), 0 ), columns - 1 );
+		int row = std::min( std::max( int( ( y - originY ) * inverseCellSize ), 0 ), rows - 1 );
+		return row * columns + column;
+	}
+
+
+	int PocketLookup::capture( float x, float y ) const
+	{
+		const int cell = cellOf( x, y );
+		for ( int k = cellStart[ cell ], end = cellStart[ cell + 1 ]; k < end; k++ )
+		{
+			Vector2 const& pocket = positions[ cellPockets[ k ] ];
+			const float dx = pocket.x - x;
+			const float dy = pocket.y - y;
+			if ( dx * dx + dy * dy <= radiusSq )
+				return cellPockets[ k ];
+		}
+		return -1;
+	}
+}
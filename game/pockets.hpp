@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "vector2.hpp"
+
+
+//-------------------------------------------------------
+//	static pocket capture lookup
+//-------------------------------------------------------
+
+namespace Physics
+{
+	// coarse grid over the table built once per table, every cell lists the pockets
+	// whose capture circle reaches into it, so balls away from the rails find an
+	// empty cell and are never tested against any pocket
+	class PocketLookup
+	{
+	public:
+		PocketLookup();
+		// no pockets or a zero radius give a lookup that never captures
+		PocketLookup( std::vector< Vector2 > const& pockets, float radius, float width, float height );
+
+		// index of the pocket that captures the point, -1 when there is none
+		int capture( float x, float y ) const;
+
+	private:
+		int cellOf( float x, float y ) const;
+
+		int columns = 1;
+		int rows = 1;
+		float originX = 0.f;
+		float originY = 0.f;
+		float inverseCellSize = 1.f;
+		float radiusSq = 0.f;
+
+		// pockets of cell c are cellPockets[ cellStart[ c ] .. cellStart[ c + 1 ] ]
+		std::vector< int > cellStart;
+		std::vector< int > cellPockets;
+		std::vector< Vector2 > positions;
+	};
+}
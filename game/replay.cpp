@@ -0,0 +1,335 @@
+#include <cstring>
+#include <algorithm>
+
+#include "replay.hpp"
+#include "bytestream.hpp"
+
+
+namespace Replay
+{
+	namespace
+	{
+		constexpr std::uint8_t magic[ 4 ] = { 'M', 'B', 'R', '2' };
+		constexpr std::uint8_t keyframeTag = 3;
+
+		std::uint32_t bitsOf( float value )
+		{
+			std::uint32_t bits;
+			std::memcpy( &bits, &value, sizeof( bits ) );
+			return bits;
+		}
+
+		float floatOf( std::uint32_t bits )
+		{
+			float value;
+			std::memcpy( &value, &bits, sizeof( value ) );
+			return value;
+		}
+
+		// difference of the raw bits, small for small changes of values with the same sign
+		void writeDeltas( ByteWriter& writer, std::vector< float > const& current, std::vector< float > const& previous )
+		{
+			for ( size_t i = 0; i < current.size(); i++ )
+				writer.zigzag( std::int32_t( bitsOf( current[ i ] ) - bitsOf( previous[ i ] ) ) );
+		}
+
+		void readDeltas( ByteReader& reader, std::vector< float >& values )
+		{
+			for ( float& value : values )
+				value = floatOf( bitsOf( value ) + std::uint32_t( std::int32_t( reader.zigzag() ) ) );
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	recorder
+//-------------------------------------------------------
+
+namespace Replay
+{
+	Recorder::Recorder( unsigned keyframeInterval ) :
+		interval( std::max( keyframeInterval, 1u ) )
+	{
+	}
+
+
+	void Recorder::begin( std::vector< Vector2 > const& layout )
+	{
+		stream.clear();
+		lastTick = 0;
+		lastKeyframeTick = 0;
+		events = 0;
+		keyframeCount = 0;
+
+		ByteWriter writer( stream );
+		writer.bytes( magic, sizeof( magic ) );
+		writer.varint( interval );
+		writer.varint( layout.size() );
+		for ( Vector2 const& position : layout )
+		{
+			writer.f32( position.x );
+			writer.f32( position.y );
+		}
+
+		// the first keyframe is coded against an empty table
+		previous.resize( int( layout.size() ) );
+		previous.alive.assign( layout.size(), 0 );
+	}
+
+
+	void Recorder::recordShot( unsigned tick, Vector2 target, float charge )
+	{
+		ByteWriter writer( stream );
+		writer.u8( std::uint8_t( EventType::shot ) );
+		writer.varint( tick - lastTick );
+		writer.f32( target.x );
+		writer.f32( target.y );
+		writer.f32( charge );
+		lastTick = tick;
+		events++;
+	}
+
+
+	void Recorder::recordReset( unsigned tick )
+	{
+		ByteWriter writer( stream );
+		writer.u8( std::uint8_t( EventType::reset ) );
+		writer.varint( tick - lastTick );
+		lastTick = tick;
+		events++;
+	}
+
+
+	void Recorder::recordState( unsigned tick, Physics::Simulation const& simulation )
+	{
+		if ( !keyframeCount || tick >= lastKeyframeTick + interval )
+			writeKeyframe( tick, simulation );
+	}
+
+
+	void Recorder::finish( unsigned tick, Physics::Simulation const& simulation )
+	{
+		writeKeyframe( tick, simulation );
+	}
+
+
+	void Recorder::writeKeyframe( unsigned tick, Physics::Simulation const& simulation )
+	{
+		Physics::BallStore const& balls = simulation.state();
+
+		ByteWriter writer( stream );
+		writer.u8( keyframeTag );
+		writer.varint( tick - lastTick );
+		writer.u8( simulation.isBallsMoving() ? 1 : 0 );
+
+		for ( int i = 0; i < balls.size(); i += 8 )
+		{
+			std::uint8_t mask = 0;
+			for ( int bit = 0; bit < 8 && i + bit < balls.size(); bit++ )
+				mask |= balls.alive[ i + bit ] ? 1 << bit : 0;
+			writer.u8( mask );
+		}
+
+		writeDeltas( writer, balls.x, previous.x );
+		writeDeltas( writer, balls.y, previous.y );
+		writeDeltas( writer, balls.vx, previous.vx );
+		writeDeltas( writer, balls.vy, previous.vy );
+
+		// grouped by the first ball, so it is coded as a difference to the contact before
+		std::vector< Physics::Contact > const& contacts = simulation.warmStart();
+		writer.varint( contacts.size() );
+		int lastA = 0;
+		for ( Physics::Contact const& contact : contacts )
+		{
+			writer.varint( std::uint64_t( contact.a - lastA ) );
+			writer.varint( std::uint64_t( contact.b - contact.a ) );
+			writer.u32( bitsOf( contact.impulse ) );
+			lastA = contact.a;
+		}
+
+		previous = balls;
+		lastTick = tick;
+		lastKeyframeTick = tick;
+		keyframeCount++;
+	}
+
+
+	std::vector< std::uint8_t > const& Recorder::data() const
+	{
+		return stream;
+	}
+}
+
+
+//-------------------------------------------------------
+//	player
+//-------------------------------------------------------
+
+namespace Replay
+{
+	bool Player::load( std::vector< std::uint8_t > const& data )
+	{
+		layout.clear();
+		eventList.clear();
+		keyframes.clear();
+		lastTick = 0;
+
+		ByteReader reader( data.data(), data.size() );
+
+		std::uint8_t header[ sizeof( magic ) ];
+		reader.bytes( header, sizeof( header ) );
+		if ( std::memcmp( header, magic, sizeof( magic ) ) )
+			return false;
+
+		reader.varint();
+		const size_t count = size_t( reader.varint() );
+		if ( reader.failed() || count > data.size() )
+			return false;
+
+		for ( size_t i = 0; i < count; i++ )
+		{
+			float x = reader.f32();
+			float y = reader.f32();
+			layout.push_back( { x, y } );
+		}
+
+		// keyframes are decoded once here, so a seek never walks the delta chain
+		Physics::BallStore previous;
+		previous.resize( int( count ) );
+
+		while ( !reader.atEnd() && !reader.failed() )
+		{
+			const std::uint8_t tag = reader.u8();
+			lastTick += unsigned( reader.varint() );
+
+			if ( tag == keyframeTag )
+			{
+				Keyframe keyframe;
+				keyframe.tick = lastTick;
+				keyframe.events = unsigned( eventList.size() );
+				keyframe.moving = reader.u8() != 0;
+				keyframe.balls = previous;
+
+				for ( size_t i = 0; i < count; i += 8 )
+				{
+					std::uint8_t mask = reader.u8();
+					for ( size_t bit = 0; bit < 8 && i + bit < count; bit++ )
+						keyframe.balls.alive[ i + bit ] = ( mask >> bit ) & 1;
+				}
+
+				readDeltas( reader, keyframe.balls.x );
+				readDeltas( reader, keyframe.balls.y );
+				readDeltas( reader, keyframe.balls.vx );
+				readDeltas( reader, keyframe.balls.vy );
+
+				const size_t contacts = size_t( reader.varint() );
+				if ( reader.failed() || contacts > data.size() )
+					return false;
+				std::uint64_t a = 0;
+				for ( size_t k = 0; k < contacts; k++ )
+				{
+					a += reader.varint();
+					const std::uint64_t b = a + reader.varint();
+					if ( b <= a || b >= count )
+						return false;
+
+					Physics::Contact contact{};
+					contact.a = int( a );
+					contact.b = int( b );
+					contact.impulse = floatOf( reader.u32() );
+					keyframe.warmStart.push_back( contact );
+				}
+
+				previous = keyframe.balls;
+				keyframes.push_back( std::move( keyframe ) );
+				continue;
+			}
+
+			Event event;
+			event.tick = lastTick;
+			event.type = EventType( tag );
+			if ( event.type == EventType::shot )
+			{
+				event.target.x = reader.f32();
+				event.target.y = reader.f32();
+				event.charge = reader.f32();
+			}
+			else if ( event.type != EventType::reset )
+				return false;
+
+			eventList.push_back( event );
+		}
+
+		if ( reader.failed() || keyframes.empty() )
+			return false;
+
+		table.setDeterministic( true );
+		seek( 0 );
+		return true;
+	}
+
+
+	unsigned Player::length() const
+	{
+		return lastTick;
+	}
+
+
+	void Player::seek( unsigned target )
+	{
+		// last keyframe at or before the target
+		auto it = std::upper_bound( keyframes.begin(), keyframes.end(), target,
+			[]( unsigned tick, Keyframe const& keyframe ) { return tick < keyframe.tick; } );
+		Keyframe const& keyframe = it == keyframes.begin() ? keyframes.front() : *( it - 1 );
+
+		table.restore( keyframe.balls, keyframe.moving, keyframe.warmStart );
+		currentTick = keyframe.tick;
+		nextEvent = keyframe.events;
+
+		while ( true )
+		{
+			while ( nextEvent < eventList.size() && eventList[ nextEvent ].tick <= currentTick )
+				apply( eventList[ nextEvent++ ] );
+
+			if ( currentTick >= target || !table.isBallsMoving() )
+				break;
+
+			table.step();
+			currentTick++;
+		}
+	}
+
+
+	unsigned Player::tick() const
+	{
+		return currentTick;
+	}
+
+
+	void Player::apply( Event const& event )
+	{
+		if ( event.type == EventType::reset )
+			table.reset( layout );
+		else
+			table.shoot( event.target, event.charge );
+	}
+
+
+	Physics::Simulation const& Player::simulation() const
+	{
+		return table;
+	}
+
+
+	std::vector< Vector2 > const& Player::initialLayout() const
+	{
+		return layout;
+	}
+
+
+	std::vector< Event > const& Player::events() const
+	{
+		return eventList;
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vector2.hpp"
+#include "ballstore.hpp"
+#include "physics.hpp"
+#include "params.hpp"
+
+
+//-------------------------------------------------------
+//	compact binary match replays
+//-------------------------------------------------------
+
+// A replay holds the initial layout, the input events and periodic keyframes.
+// Ticks count simulation steps since the start of the match. Keyframes are
+// lossless, their float bits are delta coded against the previous keyframe and
+// they carry the contact impulses the next step warm starts from, because a seek
+// resimulates from them and has to land on the recorded states.
+namespace Replay
+{
+	enum class EventType : std::uint8_t
+	{
+		shot = 1,
+		reset = 2
+	};
+
+
+	struct Event
+	{
+		unsigned tick = 0;
+		EventType type = EventType::shot;
+		Vector2 target;
+		float charge = 0.f;
+	};
+
+
+	struct Keyframe
+	{
+		unsigned tick = 0;
+		// number of events already applied to this state
+		unsigned events = 0;
+		bool moving = false;
+		Physics::BallStore balls;
+		std::vector< Physics::Contact > warmStart;
+	};
+
+
+	class Recorder
+	{
+	public:
+		explicit Recorder( unsigned keyframeInterval = Params::Replay::keyframeInterval );
+
+		void begin( std::vector< Vector2 > const& layout );
+		void recordShot( unsigned tick, Vector2 target, float charge );
+		void recordReset( unsigned tick );
+		// writes a keyframe once the interval since the previous one has passed
+		void recordState( unsigned tick, Physics::Simulation const& simulation );
+		// closing keyframe so the replay covers everything up to the tick
+		void finish( unsigned tick, Physics::Simulation const& simulation );
+
+		std::vector< std::uint8_t > const& data() const;
+
+	private:
+		void writeKeyframe( unsigned tick, Physics::Simulation const& simulation );
+
+		std::vector< std::uint8_t > stream;
+		unsigned interval;
+		unsigned lastTick = 0;
+		unsigned lastKeyframeTick = 0;
+		unsigned events = 0;
+		unsigned keyframeCount = 0;
+		Physics::BallStore previous;
+	};
+
+
+	class Player
+	{
+	public:
+		bool load( std::vector< std::uint8_t > const& data );
+
+		// last tick covered by the replay
+		unsigned length() const;
+
+		// restores the nearest earlier keyframe and simulates forward to the tick
+		void seek( unsigned tick );
+		unsigned tick() const;
+
+		Physics::Simulation const& simulation() const;
+		std::vector< Vector2 > const& initialLayout() const;
+		std::vector< Event > const& events() const;
+
+	private:
+		void apply( Event const& event );
+
+		std::vector< Vector2 > layout;
+		std::vector< Event > eventList;
+		std::vector< Keyframe > keyframes;
+		unsigned lastTick = 0;
+
+		Physics::Simulation table;
+		unsigned currentTick = 0;
+		unsigned nextEvent = 0;
+	};
+}
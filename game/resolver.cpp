@@ -0,0 +1,518 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "resolver.hpp"
+#include "determinism.hpp"
+#include "contacts.hpp"
+#include "params.hpp"
+
+
+//-------------------------------------------------------
+//	closed form motion with constant deceleration
+//-------------------------------------------------------
+
+namespace Physics
+{
+	namespace
+	{
+		constexpr float never = std::numeric_limits< float >::infinity();
+		constexpr int maxRootIterations = 64;
+		constexpr double rootTolerance = 1e-9;
+
+		// path length covered after time t by a ball starting at speed s
+		template< class R >
+		float travelled( float s, float t )
+		{
+			constexpr float deceleration = R::deceleration;
+			t = std::min( t, s / deceleration );
+			return s * t - 0.5f * deceleration * t * t;
+		}
+
+		// time to cover the path length d, never when the ball stops before that
+		template< class R >
+		float timeToTravel( float s, float d )
+		{
+			constexpr float deceleration = R::deceleration;
+			if ( d <= 0.f )
+				return 0.f;
+
+			float discriminant = s * s - 2.f * deceleration * d;
+			if ( discriminant < 0.f )
+				return never;
+
+			// stable form of ( s - sqrt( discriminant ) ) / deceleration
+			return 2.f * d / ( s + std::sqrt( discriminant ) );
+		}
+
+		double evaluate( double const* c, int degree, double t )
+		{
+			double value = c[ degree ];
+			for ( int i = degree - 1; i >= 0; i-- )
+				value = value * t + c[ i ];
+			return value;
+		}
+
+		// sorted roots of a polynomial of degree up to 4 in [lo, hi], the derivative
+		// roots split the range into monotone pieces which are then bisected
+		int findRoots( double const* c, int degree, double lo, double hi, double* roots )
+		{
+			while ( degree > 0 && c[ degree ] == 0.0 )
+				degree--;
+			if ( degree == 0 )
+				return 0;
+
+			double derivative[ 4 ];
+			for ( int i = 1; i <= degree; i++ )
+				derivative[ i - 1 ] = i * c[ i ];
+
+			double breaks[ 6 ];
+			int count = 0;
+			breaks[ count++ ] = lo;
+			count += findRoots( derivative, degree - 1, lo, hi, breaks + count );
+			breaks[ count++ ] = hi;
+
+			int found = 0;
+			for ( int k = 0; k + 1 < count; k++ )
+			{
+				double left = breaks[ k ];
+				double right = breaks[ k + 1 ];
+				double valueLeft = evaluate( c, degree, left );
+				double valueRight = evaluate( c, degree, right );
+				if ( ( valueLeft > 0.0 ) == ( valueRight > 0.0 ) && valueRight != 0.0 )
+					continue;
+
+				// newton steps, falling back to bisection when a step leaves the bracket
+				const bool positiveLeft = valueLeft > 0.0;
+				double t = 0.5 * ( left + right );
+				for ( int iteration = 0; iteration < maxRootIterations && right - left > rootTolerance; iteration++ )
+				{
+					double value = evaluate( c, degree, t );
+					if ( value == 0.0 )
+						left = right = t;
+					else if ( ( value > 0.0 ) == positiveLeft )
+						left = t;
+					else
+						right = t;
+
+					double slope = evaluate( derivative, degree - 1, t );
+					double next = slope != 0.0 ? t - value / slope : left - 1.0;
+					t = next > left && next < right ? next : 0.5 * ( left + right );
+				}
+				if ( !found || right > roots[ found - 1 ] )
+					roots[ found++ ] = right;
+			}
+			return found;
+		}
+
+		// first moment in [lo, hi] when the quartic f enters the negative range, negative if never
+		double firstEntry( double const* f, double lo, double hi )
+		{
+			double slope = f[ 1 ] + lo * ( 2.0 * f[ 2 ] + lo * ( 3.0 * f[ 3 ] + lo * 4.0 * f[ 4 ] ) );
+			if ( evaluate( f, 4, lo ) <= 0.0 )
+			{
+				if ( slope < 0.0 )
+					return lo;
+			}
+
+			double roots[ 4 ];
+			int count = findRoots( f, 4, lo, hi, roots );
+			for ( int k = 0; k < count; k++ )
+			{
+				double t = roots[ k ];
+				double d = f[ 1 ] + t * ( 2.0 * f[ 2 ] + t * ( 3.0 * f[ 3 ] + t * 4.0 * f[ 4 ] ) );
+				if ( t > lo && d < 0.0 )
+					return t;
+			}
+			return -1.0;
+		}
+
+		// path length along the unit direction to the first point at limit, negative when never reached
+		float distanceToLimit( float position, float direction, float minPosition, float maxPosition )
+		{
+			if ( direction < 0.f )
+				return position <= minPosition ? 0.f : ( minPosition - position ) / direction;
+			if ( direction > 0.f )
+				return position >= maxPosition ? 0.f : ( maxPosition - position ) / direction;
+			return -1.f;
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	resolver
+//-------------------------------------------------------
+
+namespace Physics
+{
+	template< class R >
+	void BasicResolver< R >::reserve( int balls )
+	{
+		for ( std::vector< float >* storage : { &speed, &stopTime, &boundMinX, &boundMaxX, &boundMinY, &boundMaxY } )
+			storage->reserve( balls );
+		order.reserve( balls );
+		pairA.reserve( balls * ( balls - 1 ) / 2 );
+		pairB.reserve( balls * ( balls - 1 ) / 2 );
+	}
+
+
+	template< class R >
+	void BasicResolver< R >::prepare( BallStore const& balls )
+	{
+		constexpr float deceleration = R::deceleration;
+
+		const int n = balls.size();
+		speed.resize( n );
+		stopTime.resize( n );
+
+		for ( int i = 0; i < n; i++ )
+		{
+			speed[ i ] = balls.alive[ i ] ? std::sqrt( balls.vx[ i ] * balls.vx[ i ] + balls.vy[ i ] * balls.vy[ i ] ) : 0.f;
+			stopTime[ i ] = speed[ i ] / deceleration;
+		}
+	}
+
+
+	template< class R >
+	void BasicResolver< R >::buildPairs( BallStore const& balls )
+	{
+		constexpr float radius = R::ballRadius;
+
+		const int n = balls.size();
+		boundMinX.resize( n );
+		boundMaxX.resize( n );
+		boundMinY.resize( n );
+		boundMaxY.resize( n );
+		order.clear();
+		pairA.clear();
+		pairB.clear();
+
+		// bounds of the whole remaining path, valid until the next impact
+		for ( int i = 0; i < n; i++ )
+		{
+			if ( !balls.alive[ i ] )
+				continue;
+
+			float reach = speed[ i ] > 0.f ? travelled< R >( speed[ i ], stopTime[ i ] ) / speed[ i ] : 0.f;
+			float endX = balls.x[ i ] + balls.vx[ i ] * reach;
+			float endY = balls.y[ i ] + balls.vy[ i ] * reach;
+			boundMinX[ i ] = std::min( balls.x[ i ], endX ) - radius;
+			boundMaxX[ i ] = std::max( balls.x[ i ], endX ) + radius;
+			boundMinY[ i ] = std::min( balls.y[ i ], endY ) - radius;
+			boundMaxY[ i ] = std::max( balls.y[ i ], endY ) + radius;
+			order.push_back( i );
+		}
+
+		std::sort( order.begin(), order.end(), [ this ]( int a, int b )
+		{
+			return boundMinX[ a ] < boundMinX[ b ] || ( boundMinX[ a ] == boundMinX[ b ] && a < b );
+		} );
+
+		for ( size_t k = 0; k < order.size(); k++ )
+		{
+			const int a = order[ k ];
+			for ( size_t l = k + 1; l < order.size() && boundMinX[ order[ l ] ] <= boundMaxX[ a ]; l++ )
+			{
+				const int b = order[ l ];
+				if ( !speed[ a ] && !speed[ b ] )
+					continue;
+				if ( boundMinY[ b ] > boundMaxY[ a ] || boundMinY[ a ] > boundMaxY[ b ] )
+					continue;
+
+				pairA.push_back( a );
+				pairB.push_back( b );
+			}
+		}
+	}
+
+
+	template< class R >
+	float BasicResolver< R >::ballBallTime( BallStore const& balls, int a, int b, float horizon ) const
+	{
+		constexpr double diameter = Contacts::Table< R >::diameter;
+		constexpr double deceleration = R::deceleration;
+
+		horizon = std::min( horizon, std::max( stopTime[ a ], stopTime[ b ] ) );
+
+		// the balls can not close a gap wider than their combined path within the horizon
+		{
+			float dx = balls.x[ b ] - balls.x[ a ];
+			float dy = balls.y[ b ] - balls.y[ a ];
+			float reach = float( diameter ) + travelled< R >( speed[ a ], horizon ) + travelled< R >( speed[ b ], horizon );
+			if ( dx * dx + dy * dy > reach * reach )
+				return never;
+		}
+
+		// the distance vector is a quadratic in t between the stop times of the two balls,
+		// so the squared distance minus diameter squared is a quartic on each piece
+		float breaks[ 3 ] = { 0.f, std::min( stopTime[ a ], stopTime[ b ] ), horizon };
+		for ( int piece = 0; piece < 2; piece++ )
+		{
+			const double lo = breaks[ piece ];
+			const double hi = std::min( breaks[ piece + 1 ], horizon );
+			if ( hi < lo )
+				continue;
+
+			double ax = 0.0, ay = 0.0, bx = 0.0, by = 0.0, cx = 0.0, cy = 0.0;
+			auto add = [ & ]( int ball, double sign )
+			{
+				const double s = speed[ ball ];
+				const double ux = s > 0.0 ? balls.vx[ ball ] / s : 0.0;
+				const double uy = s > 0.0 ? balls.vy[ ball ] / s : 0.0;
+
+				if ( s > 0.0 && stopTime[ ball ] >= hi )
+				{
+					ax += sign * balls.x[ ball ];
+					ay += sign * balls.y[ ball ];
+					bx += sign * ux * s;
+					by += sign * uy * s;
+					cx -= sign * ux * 0.5 * deceleration;
+					cy -= sign * uy * 0.5 * deceleration;
+				}
+				else
+				{
+					const double d = travelled< R >( speed[ ball ], stopTime[ ball ] );
+					ax += sign * ( balls.x[ ball ] + ux * d );
+					ay += sign * ( balls.y[ ball ] + uy * d );
+				}
+			};
+			add( b, 1.0 );
+			add( a, -1.0 );
+
+			const double f[ 5 ] =
+			{
+				ax * ax + ay * ay - diameter * diameter,
+				2.0 * ( ax * bx + ay * by ),
+				bx * bx + by * by + 2.0 * ( ax * cx + ay * cy ),
+				2.0 * ( bx * cx + by * cy ),
+				cx * cx + cy * cy
+			};
+
+			double t = firstEntry( f, lo, hi );
+			if ( t >= 0.0 )
+				return float( t );
+		}
+		return never;
+	}
+
+
+	template< class R >
+	Ccd::Event BasicResolver< R >::findEarliest( BallStore const& balls )
+	{
+		constexpr Kernels::Cushions cushions = Contacts::Table< R >::cushions;
+
+		Ccd::Event earliest;
+		earliest.time = never;
+
+		auto consider = [ &earliest ]( float time, Ccd::EventType type, int ball, int other )
+		{
+			if ( time < earliest.time )
+			{
+				earliest.time = time;
+				earliest.type = type;
+				earliest.ball = ball;
+				earliest.other = other;
+			}
+		};
+
+		for ( int i = 0, n = balls.size(); i < n; i++ )
+		{
+			if ( !balls.alive[ i ] || !speed[ i ] )
+				continue;
+
+			const float ux = balls.vx[ i ] / speed[ i ];
+			const float uy = balls.vy[ i ] / speed[ i ];
+
+			float dx = distanceToLimit( balls.x[ i ], ux, cushions.minX, cushions.maxX );
+			if ( dx >= 0.f )
+				consider( timeToTravel< R >( speed[ i ], dx ), Ccd::EventType::cushionX, i, -1 );
+
+			float dy = distanceToLimit( balls.y[ i ], uy, cushions.minY, cushions.maxY );
+			if ( dy >= 0.f )
+				consider( timeToTravel< R >( speed[ i ], dy ), Ccd::EventType::cushionY, i, -1 );
+
+			if constexpr ( !Contacts::Table< R >::hasPockets )
+				continue;
+
+			for ( int p = 0; p < int( R::pockets.size() ); p++ )
+			{
+				constexpr float radius = R::pocketRadius;
+
+				// path length to the pocket circle along the unit direction
+				float px = balls.x[ i ] - R::pockets[ p ].x;
+				float py = balls.y[ i ] - R::pockets[ p ].y;
+				float c = px * px + py * py - radius * radius;
+				if ( c <= 0.f )
+				{
+					consider( 0.f, Ccd::EventType::pocket, i, p );
+					continue;
+				}
+
+				float b = px * ux + py * uy;
+				float discriminant = b * b - c;
+				if ( b >= 0.f || discriminant < 0.f )
+					continue;
+
+				consider( timeToTravel< R >( speed[ i ], -b - std::sqrt( discriminant ) ), Ccd::EventType::pocket, i, p );
+			}
+		}
+
+		for ( size_t k = 0; k < pairA.size(); k++ )
+			consider( ballBallTime( balls, pairA[ k ], pairB[ k ], earliest.time ), Ccd::EventType::ball, pairA[ k ], pairB[ k ] );
+
+		return earliest;
+	}
+
+
+	template< class R >
+	void BasicResolver< R >::advance( BallStore& balls, float time )
+	{
+		constexpr float deceleration = R::deceleration;
+
+		for ( int i = 0, n = balls.size(); i < n; i++ )
+		{
+			if ( !speed[ i ] )
+				continue;
+
+			float scale = travelled< R >( speed[ i ], time ) / speed[ i ];
+			balls.x[ i ] += balls.vx[ i ] * scale;
+			balls.y[ i ] += balls.vy[ i ] * scale;
+
+			float remaining = std::max( speed[ i ] - deceleration * time, 0.f ) / speed[ i ];
+			balls.vx[ i ] *= remaining;
+			balls.vy[ i ] *= remaining;
+		}
+	}
+
+
+	template< class R >
+	void BasicResolver< R >::begin( BallStore const& balls )
+	{
+		prepare( balls );
+		buildPairs( balls );
+	}
+
+
+	template< class R >
+	Ccd::Event BasicResolver< R >::step( BallStore& balls, ShotOutcome& outcome )
+	{
+		constexpr Kernels::Cushions cushions = Contacts::Table< R >::cushions;
+
+		Ccd::Event event = findEarliest( balls );
+		if ( event.time == never )
+		{
+			finish( balls, outcome );
+			return Ccd::Event();
+		}
+
+		advance( balls, event.time );
+		outcome.duration += event.time;
+		outcome.events++;
+
+		const int i = event.ball;
+		switch ( event.type )
+		{
+			case Ccd::EventType::ball:
+			{
+				const int j = event.other;
+				float dx = balls.x[ j ] - balls.x[ i ];
+				float dy = balls.y[ j ] - balls.y[ i ];
+				float len = std::sqrt( dx * dx + dy * dy );
+				if ( len > 0.f )
+					Contacts::exchange< R >( balls, i, j, dx / len, dy / len );
+				break;
+			}
+
+			case Ccd::EventType::cushionX:
+				balls.x[ i ] = std::min( std::max( balls.x[ i ], cushions.minX ), cushions.maxX );
+				Contacts::bounce( balls.vx[ i ], balls.vy[ i ], cushions.loss );
+				break;
+
+			case Ccd::EventType::cushionY:
+				balls.y[ i ] = std::min( std::max( balls.y[ i ], cushions.minY ), cushions.maxY );
+				Contacts::bounce( balls.vy[ i ], balls.vx[ i ], cushions.loss );
+				break;
+
+			case Ccd::EventType::pocket:
+				balls.alive[ i ] = 0;
+				balls.vx[ i ] = 0.f;
+				balls.vy[ i ] = 0.f;
+				outcome.pocketed.push_back( i );
+				if ( !i )
+					outcome.cueBallPocketed = true;
+				break;
+
+			case Ccd::EventType::none:
+				break;
+		}
+
+		// every impact changes directions, so speeds and path bounds are rebuilt
+		prepare( balls );
+		buildPairs( balls );
+		return event;
+	}
+
+
+	// no more impacts, everything rolls out to rest
+	template< class R >
+	void BasicResolver< R >::finish( BallStore& balls, ShotOutcome& outcome )
+	{
+		float last = 0.f;
+		for ( int i = 0, n = balls.size(); i < n; i++ )
+			last = std::max( last, stopTime[ i ] );
+		advance( balls, last );
+		outcome.duration += last;
+
+		for ( int i = 0, n = balls.size(); i < n; i++ )
+		{
+			balls.vx[ i ] = 0.f;
+			balls.vy[ i ] = 0.f;
+		}
+	}
+
+
+	template< class R >
+	void BasicResolver< R >::settle( BallStore& balls, ShotOutcome& outcome )
+	{
+		begin( balls );
+		while ( outcome.events < Params::Physics::maxEventsPerShot )
+		{
+			if ( step( balls, outcome ).type == Ccd::EventType::none )
+				return;
+		}
+		finish( balls, outcome );
+	}
+
+
+	template< class R >
+	void BasicResolver< R >::resolve( BallStore& balls, Shot const& shot, ShotOutcome& outcome )
+	{
+		outcome.pocketed.clear();
+		outcome.cueBallPocketed = false;
+		outcome.duration = 0.f;
+		outcome.events = 0;
+
+		if ( !balls.size() || !balls.alive[ 0 ] )
+			return;
+
+		applyShot< R >( balls, shot );
+		settle( balls, outcome );
+	}
+
+
+	template< class R >
+	ShotResult BasicResolver< R >::resolve( BallStore const& start, Shot const& shot )
+	{
+		ShotResult result;
+		result.balls = start;
+		resolve( result.balls, shot, result.outcome );
+		return result;
+	}
+
+
+	template class BasicResolver< Rules::Pool >;
+	template class BasicResolver< Rules::Snooker >;
+	template class BasicResolver< Rules::Carom >;
+	template class BasicResolver< Rules::Elastic >;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+
+#include "ballstore.hpp"
+#include "shot.hpp"
+#include "ccd.hpp"
+#include "rules.hpp"
+
+
+//-------------------------------------------------------
+//	analytic fast forward of a shot to the resting state
+//-------------------------------------------------------
+
+namespace Physics
+{
+	struct ShotOutcome
+	{
+		// balls in the order they dropped into pockets, the player ball included
+		std::vector< int > pocketed;
+		bool cueBallPocketed = false;
+		// simulated time until the last ball stopped
+		float duration = 0.f;
+		int events = 0;
+	};
+
+
+	struct ShotResult
+	{
+		BallStore balls;
+		ShotOutcome outcome;
+	};
+
+
+	// balls move along straight lines with constant deceleration between impacts,
+	// so the resolver jumps from one impact to the next in closed form,
+	// instantiated in resolver.cpp for every rule set
+	template< class R >
+	class BasicResolver
+	{
+	public:
+		// sizes the storage for a table of that many balls with every pair a candidate,
+		// so resolving does not allocate, for the small tables of a match
+		void reserve( int balls );
+
+		ShotResult resolve( BallStore const& start, Shot const& shot );
+
+		// runs on the given state in place and reuses the outcome storage
+		void resolve( BallStore& balls, Shot const& shot, ShotOutcome& outcome );
+
+		// runs whatever motion the balls already have until everything is at rest
+		void settle( BallStore& balls, ShotOutcome& outcome );
+
+		// settle one impact at a time: begin once, then step, which resolves the next impact
+		// and returns it, or rolls everything out to rest and returns an event of type none
+		void begin( BallStore const& balls );
+		Ccd::Event step( BallStore& balls, ShotOutcome& outcome );
+
+	private:
+		void prepare( BallStore const& balls );
+		void buildPairs( BallStore const& balls );
+		Ccd::Event findEarliest( BallStore const& balls );
+		void advance( BallStore& balls, float time );
+		void finish( BallStore& balls, ShotOutcome& outcome );
+
+		float ballBallTime( BallStore const& balls, int a, int b, float horizon ) const;
+
+		std::vector< float > speed;
+		std::vector< float > stopTime;
+		std::vector< float > boundMinX;
+		std::vector< float > boundMaxX;
+		std::vector< float > boundMinY;
+		std::vector< float > boundMaxY;
+		std::vector< int > order;
+		std::vector< int > pairA;
+		std::vector< int > pairB;
+	};
+
+
+	using Resolver = BasicResolver< Rules::Pool >;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+
+#include "vector2.hpp"
+#include "params.hpp"
+
+
+//-------------------------------------------------------
+//	compile time table and rule policies
+//-------------------------------------------------------
+
+// Every policy is a set of constants the simulation templates are instantiated
+// with, so each variant gets its own step code with the constants folded in.
+// The ball count stays a run time value, pocketing and layouts change it.
+namespace Rules
+{
+	// the game table, taken from Params so there is a single source for it
+	struct Pool
+	{
+		static constexpr float width = Params::Table::width;
+		static constexpr float height = Params::Table::height;
+		static constexpr float ballRadius = Params::Ball::radius;
+		static constexpr float pocketRadius = Params::Table::pocketRadius;
+		static constexpr std::array< Vector2, 6 > pockets = Params::Table::pocketsPositions;
+
+		static constexpr float deceleration = Params::Physics::deceleration;
+		static constexpr float cushionLoss = Params::Physics::cushionLoss;
+		static constexpr float ballTransfer = Params::Physics::ballTransfer;
+		static constexpr float ballRestitution = Params::Physics::ballRestitution;
+	};
+
+
+	// longer table, smaller balls and pockets, livelier cloth
+	struct Snooker
+	{
+		static constexpr float width = 17.8f;
+		static constexpr float height = 8.9f;
+		static constexpr float ballRadius = 0.26f;
+		static constexpr float pocketRadius = 0.43f;
+		static constexpr std::array< Vector2, 6 > pockets =
+		{
+			Vector2{ -0.5f * width, -0.5f * height },
+			Vector2{ 0.f, -0.5f * height },
+			Vector2{ 0.5f * width, -0.5f * height },
+			Vector2{ -0.5f * width, 0.5f * height },
+			Vector2{ 0.f, 0.5f * height },
+			Vector2{ 0.5f * width, 0.5f * height }
+		};
+
+		static constexpr float deceleration = 0.04f * width;
+		static constexpr float cushionLoss = 0.18f;
+		static constexpr float ballTransfer = 0.9f;
+		static constexpr float ballRestitution = 0.96f;
+	};
+
+
+	// no pockets, bouncier cushions
+	struct Carom
+	{
+		static constexpr float width = 14.2f;
+		static constexpr float height = 7.1f;
+		static constexpr float ballRadius = 0.31f;
+		static constexpr float pocketRadius = 0.f;
+		static constexpr std::array< Vector2, 0 > pockets = {};
+
+		static constexpr float deceleration = 0.06f * width;
+		static constexpr float cushionLoss = 0.1f;
+		static constexpr float ballTransfer = 0.92f;
+		static constexpr float ballRestitution = 0.97f;
+	};
+
+
+	// pool geometry with lossless contacts, for checking layouts and conservation
+	struct Elastic
+	{
+		static constexpr float width = Pool::width;
+		static constexpr float height = Pool::height;
+		static constexpr float ballRadius = Pool::ballRadius;
+		static constexpr float pocketRadius = Pool::pocketRadius;
+		static constexpr std::array< Vector2, 6 > pockets = Pool::pockets;
+
+		static constexpr float deceleration = Pool::deceleration;
+		static constexpr float cushionLoss = 0.f;
+		static constexpr float ballTransfer = 1.f;
+		static constexpr float ballRestitution = 1.f;
+	};
+}
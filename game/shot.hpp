@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cmath>
+
+#include "vector2.hpp"
+#include "ballstore.hpp"
+#include "determinism.hpp"
+
+
+//-------------------------------------------------------
+//	player shot parameters
+//-------------------------------------------------------
+
+namespace Physics
+{
+	struct Shot
+	{
+		// direction of the player ball in radians
+		float angle = 0.f;
+		// accumulated shot power in [0, 1]
+		float charge = 0.f;
+	};
+
+
+	// the shot mouseButtonReleased does for a cursor at target
+	inline Shot aimAt( BallStore const& balls, Vector2 target, float charge )
+	{
+		return { std::atan2( target.y - balls.y[ 0 ], target.x - balls.x[ 0 ] ), charge };
+	}
+
+
+	// the shot speed scales with the table width of rule set R
+	template< class R >
+	inline void applyShot( BallStore& balls, Shot const& shot )
+	{
+		float sine, cosine;
+		Determinism::sinCos( shot.angle, sine, cosine );
+
+		const float speed = shot.charge * R::width;
+		balls.vx[ 0 ] = cosine * speed;
+		balls.vy[ 0 ] = sine * speed;
+	}
+}
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "shotsearch.hpp"
+#include "params.hpp"
+
+
+namespace Ai
+{
+	namespace
+	{
+		// splitmix64, small and the same on every platform
+		class Random
+		{
+		public:
+			explicit Random( std::uint64_t seed ) :
+				state( seed )
+			{
+			}
+
+			std::uint64_t next()
+			{
+				std::uint64_t z = state += 0x9e3779b97f4a7c15ull;
+				z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+				z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+				return z ^ ( z >> 31 );
+			}
+
+			// uniform in [lo, hi)
+			float uniform( float lo, float hi )
+			{
+				return lo + ( hi - lo ) * float( next() >> 40 ) * ( 1.f / float( 1 << 24 ) );
+			}
+
+		private:
+			std::uint64_t state;
+		};
+
+
+		constexpr float minCharge = 0.05f;
+
+		double secondsSince( std::chrono::steady_clock::time_point start )
+		{
+			return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+		}
+
+
+		// object balls pocketed count most, losing the player ball cancels two of them,
+		// balls left near a pocket give partial credit so rounds without a pot still
+		// rank, and softer shots win ties
+		float rate( Physics::ShotResult const& result, float charge )
+		{
+			float score = -0.05f * charge;
+			for ( int ball : result.outcome.pocketed )
+				score += ball ? 1.f : -2.f;
+
+			float closest = Params::Table::width;
+			Physics::BallStore const& balls = result.balls;
+			for ( int i = 1, n = balls.size(); i < n; i++ )
+			{
+				if ( !balls.alive[ i ] )
+					continue;
+				for ( Vector2 const& pocket : Params::Table::pocketsPositions )
+					closest = std::min( closest, std::hypot( balls.x[ i ] - pocket.x, balls.y[ i ] - pocket.y ) );
+			}
+			return score + 0.5f * ( 1.f - closest / Params::Table::width );
+		}
+	}
+
+
+	ShotSearch::ShotSearch( ThreadPool& pool ) :
+		evaluator( pool ),
+		workers( pool.size() )
+	{
+	}
+
+
+	void ShotSearch::reserve( int balls )
+	{
+		evaluator.reserve( balls, std::max( Params::Ai::firstRoundSize, Params::Ai::roundSize ), results );
+
+		// the allocations of the largest decision in the order decide makes them, so its chunks are there
+		arena.reset();
+		arena.allocate< Physics::Shot >( size_t( balls ) * Params::Table::pocketsPositions.size() );
+		arena.allocate< Candidate >( Params::Ai::firstRoundSize );
+		arena.allocate< Physics::Shot >( Params::Ai::firstRoundSize );
+		for ( int round = 1; round < Params::Ai::maxRounds; round++ )
+		{
+			arena.allocate< Candidate >( Params::Ai::elites + Params::Ai::roundSize );
+			arena.allocate< Physics::Shot >( Params::Ai::roundSize );
+		}
+		arena.reset();
+	}
+
+
+	int ShotSearch::score( Physics::BallStore const& table, Candidate* candidates, int count, Decision& decision )
+	{
+		Physics::Shot* shots = arena.allocate< Physics::Shot >( count );
+		for ( int i = 0; i < count; i++ )
+			shots[ i ] = candidates[ i ].shot;
+
+		// the first slice measures the cost of a shot on this table, a decision always
+		// scores it, later slices take as many shots as the rest of the budget allows,
+		// at most doubling the count so far, since shot costs vary a lot
+		int scored = 0;
+		while ( scored < count )
+		{
+			const double elapsed = secondsSince( start );
+			int slice = count - scored;
+			if ( decision.evaluated )
+			{
+				const double perShot = elapsed / decision.evaluated;
+				slice = std::min( { slice, int( ( Params::Ai::decisionBudget - elapsed ) / perShot ), std::max( decision.evaluated, workers ) } );
+				if ( slice <= 0 )
+					break;
+			}
+			else
+				slice = std::min( slice, workers );
+
+			evaluator.evaluate( table, shots + scored, slice, results );
+			for ( int i = 0; i < slice; i++ )
+				candidates[ scored + i ].score = rate( results[ i ], shots[ scored + i ].charge );
+			scored += slice;
+			decision.evaluated += slice;
+		}
+		return scored;
+	}
+
+
+	Decision ShotSearch::decide( Physics::BallStore const& table, std::uint64_t seed )
+	{
+		start = std::chrono::steady_clock::now();
+		arena.reset();
+
+		Decision decision;
+		if ( !table.size() || !table.alive[ 0 ] )
+			return decision;
+
+		Random random( seed );
+		auto byScore = []( Candidate const& a, Candidate const& b ) { return a.score > b.score; };
+
+		// ghost ball aim: the player ball has to be one diameter behind the object ball,
+		// on the line from the pocket through the object ball
+		int pairs = 0;
+		Physics::Shot* aims = arena.allocate< Physics::Shot >( size_t( table.size() ) * Params::Table::pocketsPositions.size() );
+		for ( int i = 1, n = table.size(); i < n; i++ )
+		{
+			if ( !table.alive[ i ] )
+				continue;
+
+			for ( Vector2 const& pocket : Params::Table::pocketsPositions )
+			{
+				const float dx = pocket.x - table.x[ i ];
+				const float dy = pocket.y - table.y[ i ];
+				const float length = std::hypot( dx, dy );
+				if ( length <= 0.f )
+					continue;
+
+				constexpr float diameter = 2.f * Params::Ball::radius;
+				const float ghostX = table.x[ i ] - dx / length * diameter;
+				const float ghostY = table.y[ i ] - dy / length * diameter;
+				aims[ pairs++ ] = Physics::aimAt( table, { ghostX, ghostY }, 0.f );
+			}
+		}
+
+		// without object balls any direction is as good as another
+		if ( !pairs )
+			aims[ pairs++ ] = Physics::Shot();
+
+		// every pair gets its samples while they fit the first round, past that pairs are drawn at random
+		const bool everyPair = pairs * Params::Ai::samplesPerPair <= Params::Ai::firstRoundSize;
+		const int firstCount = everyPair ? pairs * Params::Ai::samplesPerPair : Params::Ai::firstRoundSize;
+		Candidate* candidates = arena.allocate< Candidate >( firstCount );
+		for ( int k = 0; k < firstCount; k++ )
+		{
+			const Physics::Shot& aim = aims[ everyPair ? k / Params::Ai::samplesPerPair : int( random.next() % std::uint64_t( pairs ) ) ];
+			candidates[ k ].shot.angle = aim.angle + random.uniform( -Params::Ai::angleSpread, Params::Ai::angleSpread );
+			candidates[ k ].shot.charge = random.uniform( minCharge, 1.f );
+		}
+		const int firstScored = score( table, candidates, firstCount, decision );
+		decision.rounds = 1;
+
+		int elites = std::min( Params::Ai::elites, firstScored );
+		std::partial_sort( candidates, candidates + elites, candidates + firstScored, byScore );
+
+		float angleSpread = 0.5f * Params::Ai::angleSpread;
+		float chargeSpread = 0.5f * Params::Ai::chargeSpread;
+		while ( decision.rounds < Params::Ai::maxRounds && secondsSince( start ) < Params::Ai::decisionBudget )
+		{
+			// the elites carry over with their scores, samples around them fill the rest
+			const int count = elites + Params::Ai::roundSize;
+			Candidate* next = arena.allocate< Candidate >( count );
+			std::copy( candidates, candidates + elites, next );
+			for ( int k = 0; k < Params::Ai::roundSize; k++ )
+			{
+				const Physics::Shot& parent = next[ k % elites ].shot;
+				next[ elites + k ].shot.angle = parent.angle + random.uniform( -angleSpread, angleSpread );
+				next[ elites + k ].shot.charge = std::min( std::max( parent.charge + random.uniform( -chargeSpread, chargeSpread ), minCharge ), 1.f );
+			}
+			const int scored = score( table, next + elites, Params::Ai::roundSize, decision );
+			if ( !scored )
+				break;
+			decision.rounds++;
+
+			const int total = elites + scored;
+			candidates = next;
+			elites = std::min( Params::Ai::elites, total );
+			std::partial_sort( candidates, candidates + elites, candidates + total, byScore );
+			angleSpread *= 0.5f;
+			chargeSpread *= 0.5f;
+		}
+
+		decision.shot = candidates[ 0 ].shot;
+		decision.score = candidates[ 0 ].score;
+		return decision;
+	}
+}
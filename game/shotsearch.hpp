@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "ballstore.hpp"
+#include "shot.hpp"
+#include "resolver.hpp"
+#include "batch.hpp"
+#include "../framework/arena.hpp"
+#include "threadpool.hpp"
+
+
+//-------------------------------------------------------
+//	computer opponent, monte carlo shot search
+//-------------------------------------------------------
+
+namespace Ai
+{
+	struct Decision
+	{
+		Physics::Shot shot;
+		float score = 0.f;
+		// shots resolved and search rounds done for the decision
+		int evaluated = 0;
+		int rounds = 0;
+	};
+
+
+	// The first round samples shots around the ghost ball aim of every object ball
+	// into every pocket, each following round samples around the best shots of the
+	// one before with a narrower spread. Rounds are resolved by the batch evaluator,
+	// so more workers get more rounds into the time budget.
+	class ShotSearch
+	{
+	public:
+		explicit ShotSearch( ThreadPool& pool );
+
+		// sizes everything a decision on a table of that many balls uses, so deciding
+		// does not allocate on the calling thread
+		void reserve( int balls );
+
+		// the same table and seed give the same shot when the budget allows the same rounds
+		Decision decide( Physics::BallStore const& table, std::uint64_t seed );
+
+	private:
+		struct Candidate
+		{
+			Physics::Shot shot;
+			float score;
+		};
+
+		// scores candidates in slices until the budget would run out, returns how many got scored
+		int score( Physics::BallStore const& table, Candidate* candidates, int count, Decision& decision );
+
+		Physics::BatchEvaluator evaluator;
+		int workers;
+		std::chrono::steady_clock::time_point start;
+		// everything sized per decision, reset when a decision starts
+		Arena arena;
+		std::vector< Physics::ShotResult > results;
+	};
+}
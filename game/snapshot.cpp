@@ -0,0 +1,36 @@
+#include "snapshot.hpp"
+#include "match.hpp"
+#include "params.hpp"
+
+
+TableSnapshot::TableSnapshot()
+{
+	cuePath.reserve( Params::Shot::previewEvents + 1 );
+	objectPath.reserve( 2 );
+}
+
+
+void TableSnapshot::capture( Match const& match, double captureTime )
+{
+	generation = match.generation();
+	chargeProgress = match.shotChargeProgress();
+	time = captureTime;
+	balls = match.simulation().state();
+}
+
+
+void TableSnapshot::interpolate( TableSnapshot const& previous, TableSnapshot const& latest, float alpha, Physics::BallStore& balls )
+{
+	balls = latest.balls;
+	if ( previous.generation != latest.generation || previous.balls.size() != latest.balls.size() )
+		return;
+
+	for ( int i = 0, n = latest.balls.size(); i < n; i++ )
+	{
+		if ( !latest.balls.alive[ i ] || !previous.balls.alive[ i ] )
+			continue;
+
+		balls.x[ i ] = previous.balls.x[ i ] + ( latest.balls.x[ i ] - previous.balls.x[ i ] ) * alpha;
+		balls.y[ i ] = previous.balls.y[ i ] + ( latest.balls.y[ i ] - previous.balls.y[ i ] ) * alpha;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "vector2.hpp"
+#include "ballstore.hpp"
+
+class Match;
+
+
+//-------------------------------------------------------
+//	table state handed from the simulation to the renderer
+//-------------------------------------------------------
+
+struct TableSnapshot
+{
+	// the preview paths get their largest size up front, copies never grow them then
+	TableSnapshot();
+
+	unsigned generation = 0;
+	float chargeProgress = 0.f;
+	// steady clock seconds when the state was captured
+	double time = 0.0;
+	Physics::BallStore balls;
+	// aim preview of the shot being charged, empty otherwise
+	std::vector< Vector2 > cuePath;
+	std::vector< Vector2 > objectPath;
+
+	// reuses the storage of the snapshot
+	void capture( Match const& match, double captureTime );
+
+	// positions between two snapshots, alpha 0 gives the previous one and 1 the latest,
+	// nothing is blended across a reset
+	static void interpolate( TableSnapshot const& previous, TableSnapshot const& latest, float alpha, Physics::BallStore& balls );
+};
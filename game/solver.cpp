@@ -0,0 +1,248 @@
+#include <cmath>
+#include <algorithm>
+
+#include "solver.hpp"
+#include "determinism.hpp"
+#include "contacts.hpp"
+
+
+namespace Physics
+{
+	namespace
+	{
+		// equal masses, an impulse per unit mass moves both balls by the same amount
+		void applyImpulse( BallStore& balls, Contact const& contact, float impulse )
+		{
+			balls.vx[ contact.a ] -= contact.nx * impulse;
+			balls.vy[ contact.a ] -= contact.ny * impulse;
+			balls.vx[ contact.b ] += contact.nx * impulse;
+			balls.vy[ contact.b ] += contact.ny * impulse;
+		}
+
+
+		float normalSpeed( BallStore const& balls, Contact const& contact )
+		{
+			return ( balls.vx[ contact.b ] - balls.vx[ contact.a ] ) * contact.nx + ( balls.vy[ contact.b ] - balls.vy[ contact.a ] ) * contact.ny;
+		}
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::setIterations( int velocity, int position )
+	{
+		iterations = std::max( velocity, 1 );
+		positionIterations = std::max( position, 0 );
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::reserve( int balls )
+	{
+		// the same bound the broad phase reserves its candidates with
+		current.reserve( 4 * balls );
+		previous.reserve( 4 * balls );
+		previousStart.reserve( balls + 1 );
+		cursor.reserve( balls + 1 );
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::clear()
+	{
+		current.clear();
+		previous.clear();
+		previousStart.clear();
+	}
+
+
+	template< class R >
+	int BasicContactSolver< R >::gather( BallStore const& balls, std::vector< BallPair > const& pairs )
+	{
+		constexpr float diameter = Contacts::Table< R >::diameter;
+
+		current.clear();
+		for ( BallPair const& pair : pairs )
+		{
+			const int a = std::min( pair.a, pair.b );
+			const int b = std::max( pair.a, pair.b );
+
+			float dx = balls.x[ b ] - balls.x[ a ];
+			float dy = balls.y[ b ] - balls.y[ a ];
+			float lenSq = dx * dx + dy * dy;
+			if ( lenSq >= diameter * diameter || lenSq == 0.f )
+				continue;
+
+			float len = std::sqrt( lenSq );
+			current.push_back( { a, b, dx / len, dy / len, 0.f, false } );
+		}
+		return int( current.size() );
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::prepare( BallStore& balls )
+	{
+		constexpr float threshold = Params::Physics::restitutionThreshold;
+
+		const int buckets = int( previousStart.size() ) - 1;
+		for ( Contact& contact : current )
+		{
+			// a ball touches a handful of others, its bucket is scanned
+			bool persists = false;
+			for ( int k = contact.a < buckets ? previousStart[ contact.a ] : 0, end = contact.a < buckets ? previousStart[ contact.a + 1 ] : 0; k < end; k++ )
+			{
+				if ( previous[ k ].b == contact.b )
+				{
+					contact.impulse = previous[ k ].impulse;
+					persists = true;
+					break;
+				}
+			}
+
+			// a persisting contact rests on its old impulse, slow approaches do not bounce
+			// so a packed cluster comes to rest instead of jittering
+			contact.impact = !persists && normalSpeed( balls, contact ) < -threshold;
+		}
+
+		// the impacts are found from the velocities before any impulse
+		for ( Contact const& contact : current )
+		{
+			if ( contact.impulse > 0.f )
+				applyImpulse( balls, contact, contact.impulse );
+		}
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::solveVelocities( BallStore& balls )
+	{
+		for ( int iteration = 0; iteration < iterations; iteration++ )
+		{
+			float largest = 0.f;
+			for ( Contact& contact : current )
+			{
+				// the accumulated impulse only ever pushes, a contact that got too much gives it back
+				float impulse = std::max( contact.impulse - 0.5f * normalSpeed( balls, contact ), 0.f );
+				float delta = impulse - contact.impulse;
+				contact.impulse = impulse;
+				applyImpulse( balls, contact, delta );
+				largest = std::max( largest, std::abs( delta ) );
+			}
+
+			// an isolated impact is done after one pass
+			if ( largest < Params::Physics::solverTolerance )
+				break;
+		}
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::bounce( BallStore& balls )
+	{
+		constexpr float restitution = Contacts::Table< R >::restitution;
+
+		// all at once, from the impulses that stopped the approach, and not kept for warm starting,
+		// the losses of the exchange follow so an isolated impact ends where exchange puts it
+		for ( Contact const& contact : current )
+		{
+			if ( !contact.impact )
+				continue;
+
+			applyImpulse( balls, contact, restitution * contact.impulse );
+			Contacts::dampImpact< R >( balls, contact.a, contact.b, contact.nx, contact.ny );
+		}
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::solvePositions( BallStore& balls )
+	{
+		constexpr float diameter = Contacts::Table< R >::diameter;
+		constexpr float slop = Params::Physics::contactSlop * R::ballRadius;
+
+		// positions only, separating overlaps this way adds no energy to the table
+		for ( int iteration = 0; iteration < positionIterations; iteration++ )
+		{
+			bool separated = true;
+			for ( Contact const& contact : current )
+			{
+				const int a = contact.a;
+				const int b = contact.b;
+
+				float dx = balls.x[ b ] - balls.x[ a ];
+				float dy = balls.y[ b ] - balls.y[ a ];
+				float lenSq = dx * dx + dy * dy;
+				if ( lenSq >= ( diameter - slop ) * ( diameter - slop ) || lenSq == 0.f )
+					continue;
+
+				float len = std::sqrt( lenSq );
+				float push = 0.5f * ( diameter - slop - len ) / len;
+				balls.x[ a ] -= dx * push;
+				balls.y[ a ] -= dy * push;
+				balls.x[ b ] += dx * push;
+				balls.y[ b ] += dy * push;
+				separated = false;
+			}
+
+			if ( separated )
+				break;
+		}
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::solve( BallStore& balls )
+	{
+		prepare( balls );
+		solveVelocities( balls );
+		bounce( balls );
+		solvePositions( balls );
+		keep( balls.size() );
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::keep( int balls )
+	{
+		// counting sort by the first ball, so the next warm start finds a pair in its bucket
+		previousStart.assign( balls + 1, 0 );
+		for ( Contact const& contact : current )
+			previousStart[ contact.a + 1 ]++;
+		for ( int i = 0; i < balls; i++ )
+			previousStart[ i + 1 ] += previousStart[ i ];
+
+		cursor.assign( previousStart.begin(), previousStart.end() );
+		previous.resize( current.size() );
+		for ( Contact const& contact : current )
+			previous[ cursor[ contact.a ]++ ] = contact;
+		current.clear();
+	}
+
+
+	template< class R >
+	std::vector< Contact > const& BasicContactSolver< R >::warmStart() const
+	{
+		return previous;
+	}
+
+
+	template< class R >
+	void BasicContactSolver< R >::restore( std::vector< Contact > const& contacts, int balls )
+	{
+		current.assign( contacts.begin(), contacts.end() );
+		keep( balls );
+	}
+
+
+	template< class R >
+	std::vector< Contact > const& BasicContactSolver< R >::contacts() const
+	{
+		return current;
+	}
+
+
+	template class BasicContactSolver< Rules::Pool >;
+	template class BasicContactSolver< Rules::Snooker >;
+	template class BasicContactSolver< Rules::Carom >;
+	template class BasicContactSolver< Rules::Elastic >;
+}
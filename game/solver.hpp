@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+#include "ballstore.hpp"
+#include "broadphase.hpp"
+#include "params.hpp"
+#include "rules.hpp"
+
+
+//-------------------------------------------------------
+//	sequential impulse contact solver
+//-------------------------------------------------------
+
+namespace Physics
+{
+	struct Contact
+	{
+		// a < b, the normal points from a to b
+		int a;
+		int b;
+		float nx;
+		float ny;
+		// accumulated normal impulse per unit mass that stops the approach, kept for warm starting
+		float impulse;
+		// new this step and approaching fast enough to bounce
+		bool impact;
+	};
+
+
+	// All touching pairs of a step are gathered first and solved together, so a
+	// correction made for one pair is seen by every other pair of a cluster.
+	// Contacts that persist from the step before start from their old impulse.
+	// The passes stop every approach, impacts then get the share of that impulse
+	// the restitution asks for on top, which unlike a bounce speed per contact
+	// cannot add energy to a cluster hit in several places at once.
+	// Impacts then lose what Contacts::exchange takes off the pair, tangent
+	// transfer included, so the discrete, continuous and analytic paths share
+	// one response; resting contacts stay normal impulses only.
+	template< class R >
+	class BasicContactSolver
+	{
+	public:
+		void setIterations( int velocity, int position );
+
+		// sizes the storage for a table of that many balls, so solving does not allocate
+		void reserve( int balls );
+		// forgets the impulses of the last step, for a new or restored table
+		void clear();
+		// the impulses the next solve warm starts from, grouped by the first ball, and a saved
+		// list put back, only the balls and the impulse of a contact are used
+		std::vector< Contact > const& warmStart() const;
+		void restore( std::vector< Contact > const& contacts, int balls );
+
+		// narrow phase over the broad phase candidates, returns the number of contacts
+		int gather( BallStore const& balls, std::vector< BallPair > const& pairs );
+		// velocity passes with warm starting, the bounces, then position passes for the overlaps
+		void solve( BallStore& balls );
+
+		// contacts of the last gather, the next solve works on them
+		std::vector< Contact > const& contacts() const;
+
+	private:
+		// finds the impacts and warm starts from the contacts of the last solve
+		void prepare( BallStore& balls );
+		void solveVelocities( BallStore& balls );
+		void bounce( BallStore& balls );
+		void solvePositions( BallStore& balls );
+		// moves the solved contacts over to previous for the next warm start
+		void keep( int balls );
+
+		int iterations = Params::Physics::velocityIterations;
+		int positionIterations = Params::Physics::positionIterations;
+		// in broad phase order, the order is deterministic
+		std::vector< Contact > current;
+		// grouped by the first ball, previousStart[ a ] .. previousStart[ a + 1 ] are the contacts of a
+		std::vector< Contact > previous;
+		std::vector< int > previousStart;
+		std::vector< int > cursor;
+	};
+
+
+	using ContactSolver = BasicContactSolver< Rules::Pool >;
+}
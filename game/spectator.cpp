@@ -0,0 +1,365 @@
+#include <cmath>
+#include <algorithm>
+
+#include "spectator.hpp"
+#include "bytestream.hpp"
+#include "params.hpp"
+
+
+namespace Net
+{
+	namespace
+	{
+		// table relative, the whole table spans the 16 bits with Params::Table::width / 65535 per step
+		std::uint16_t quantize( float value, float extent )
+		{
+			const float scaled = ( value / extent + 0.5f ) * 65535.f;
+			return std::uint16_t( std::lround( std::min( std::max( scaled, 0.f ), 65535.f ) ) );
+		}
+
+		float dequantize( std::uint16_t value, float extent )
+		{
+			return ( float( value ) / 65535.f - 0.5f ) * extent;
+		}
+
+
+		bool hasMoved( SpectatorFrame const& frame, SpectatorFrame const& base, int i )
+		{
+			return !frame.isPocketed( i ) && ( base.isPocketed( i ) || frame.x[ i ] != base.x[ i ] || frame.y[ i ] != base.y[ i ] );
+		}
+
+
+		// header as in encode, then the frame, its distance to the base with 0 for a keyframe,
+		// the pocketed mask and the positions, all of them or the moved ones as differences
+		void writeSnapshot( ByteWriter& writer, std::uint32_t match, SpectatorFrame const& frame, SpectatorFrame const* base )
+		{
+			writer.u8( protocolVersion );
+			writer.u8( std::uint8_t( MessageType::snapshot ) );
+			writer.varint( match );
+			writer.varint( frame.sequence );
+			writer.varint( frame.tick );
+			writer.varint( frame.frame );
+			writer.varint( base ? frame.frame - base->frame : 0 );
+			writer.u8( frame.moving ? 1 : 0 );
+			writer.varint( std::uint64_t( frame.balls ) );
+			writer.bytes( frame.pocketed.data(), frame.pocketed.size() );
+
+			if ( !base )
+			{
+				for ( int i = 0; i < frame.balls; i++ )
+				{
+					if ( !frame.isPocketed( i ) )
+					{
+						writer.u16( frame.x[ i ] );
+						writer.u16( frame.y[ i ] );
+					}
+				}
+				return;
+			}
+
+			for ( int i = 0; i < frame.balls; i += 8 )
+			{
+				std::uint8_t mask = 0;
+				for ( int b = 0; b < 8 && i + b < frame.balls; b++ )
+					mask |= hasMoved( frame, *base, i + b ) ? 1 << b : 0;
+				writer.u8( mask );
+			}
+			for ( int i = 0; i < frame.balls; i++ )
+			{
+				if ( hasMoved( frame, *base, i ) )
+				{
+					writer.zigzag( int( frame.x[ i ] ) - int( base->x[ i ] ) );
+					writer.zigzag( int( frame.y[ i ] ) - int( base->y[ i ] ) );
+				}
+			}
+		}
+
+
+		// a difference read from the wire has to land on the table
+		bool addDelta( std::uint16_t base, std::int64_t delta, std::uint16_t& value )
+		{
+			const std::int64_t result = std::int64_t( base ) + delta;
+			if ( result < 0 || result > 65535 )
+				return false;
+			value = std::uint16_t( result );
+			return true;
+		}
+	}
+
+
+	bool SpectatorFrame::isPocketed( int ball ) const
+	{
+		return ( pocketed[ ball >> 3 ] >> ( ball & 7 ) ) & 1;
+	}
+}
+
+
+//-------------------------------------------------------
+//	server
+//-------------------------------------------------------
+
+namespace Net
+{
+	SpectatorStream::SpectatorStream( std::uint32_t match ) :
+		match( match ),
+		history( Params::Network::spectatorHistory )
+	{
+	}
+
+
+	bool SpectatorStream::capture( Physics::BallStore const& balls, unsigned sequence, unsigned tick, bool moving )
+	{
+		constexpr float width = Params::Table::width;
+		constexpr float height = Params::Table::height;
+
+		if ( frames )
+		{
+			SpectatorFrame const& last = history[ frames % history.size() ];
+			if ( last.sequence == sequence && last.tick == tick )
+				return false;
+		}
+
+		// the slot of a frame too old for a delta, its storage is reused
+		frames++;
+		SpectatorFrame& frame = history[ frames % history.size() ];
+		const int n = balls.size();
+		frame.frame = frames;
+		frame.sequence = sequence;
+		frame.tick = tick;
+		frame.moving = moving;
+		frame.balls = n;
+		frame.x.resize( n );
+		frame.y.resize( n );
+		frame.pocketed.assign( ( n + 7 ) / 8, 0 );
+
+		// a pocketed ball is at 0 on both ends, so it comes back as a difference from there
+		for ( int i = 0; i < n; i++ )
+		{
+			const bool alive = balls.alive[ i ] != 0;
+			frame.x[ i ] = alive ? quantize( balls.x[ i ], width ) : 0;
+			frame.y[ i ] = alive ? quantize( balls.y[ i ], height ) : 0;
+			if ( !alive )
+				frame.pocketed[ i >> 3 ] |= std::uint8_t( 1 << ( i & 7 ) );
+		}
+
+		encoded.clear();
+		return true;
+	}
+
+
+	std::uint32_t SpectatorStream::latest() const
+	{
+		return frames;
+	}
+
+
+	int SpectatorStream::acquireBuffer()
+	{
+		for ( int i = 0; i < int( buffers.size() ); i++ )
+		{
+			// use_count is only read between ticks, no datagram is sent or dropped meanwhile
+			const bool queued = buffers[ i ].use_count() > 1;
+			const bool current = std::any_of( encoded.begin(), encoded.end(), [ i ]( Encoding const& encoding ) { return encoding.buffer == i; } );
+			if ( !queued && !current )
+				return i;
+		}
+
+		buffers.push_back( std::make_shared< std::vector< std::uint8_t > >() );
+		return int( buffers.size() ) - 1;
+	}
+
+
+	Datagram SpectatorStream::datagramFrom( std::uint32_t acked )
+	{
+		if ( !frames )
+			return nullptr;
+
+		const size_t slots = history.size();
+		SpectatorFrame const& frame = history[ frames % slots ];
+
+		// an ack the history still holds, for the same balls
+		SpectatorFrame const* base = nullptr;
+		if ( acked && acked <= frames && frames - acked < slots )
+		{
+			SpectatorFrame const& candidate = history[ acked % slots ];
+			if ( candidate.frame == acked && candidate.balls == frame.balls )
+				base = &candidate;
+		}
+
+		const std::uint32_t baseFrame = base ? acked : 0;
+		for ( Encoding const& encoding : encoded )
+		{
+			if ( encoding.base == baseFrame )
+				return buffers[ encoding.buffer ];
+		}
+
+		const int index = acquireBuffer();
+		std::vector< std::uint8_t >& buffer = *buffers[ index ];
+		buffer.clear();
+		ByteWriter writer( buffer );
+		writeSnapshot( writer, match, frame, base );
+		if ( buffer.size() > maxDatagram )
+			return nullptr;
+
+		encoded.push_back( { baseFrame, index } );
+		return buffers[ index ];
+	}
+
+
+	int SpectatorStream::encodings() const
+	{
+		return int( encoded.size() );
+	}
+}
+
+
+//-------------------------------------------------------
+//	spectator
+//-------------------------------------------------------
+
+namespace Net
+{
+	SpectatorClient::SpectatorClient( std::uint32_t match ) :
+		match( match ),
+		history( Params::Network::spectatorHistory )
+	{
+	}
+
+
+	bool SpectatorClient::apply( std::uint8_t const* data, size_t size )
+	{
+		ByteReader reader( data, size );
+		if ( reader.u8() != protocolVersion || reader.u8() != std::uint8_t( MessageType::snapshot ) || reader.varint() != match )
+			return false;
+
+		SpectatorFrame& frame = decoded;
+		frame.sequence = unsigned( reader.varint() );
+		frame.tick = unsigned( reader.varint() );
+
+		// late copies are dropped, the acked frame only moves forward
+		const std::uint64_t number = reader.varint();
+		const std::uint64_t distance = reader.varint();
+		if ( !number || number > 0xffffffffu || distance >= number || ( latest && number <= latest->frame ) )
+			return false;
+		frame.frame = std::uint32_t( number );
+
+		SpectatorFrame const* base = nullptr;
+		if ( distance )
+		{
+			base = &history[ ( number - distance ) % history.size() ];
+			if ( base->frame != number - distance )
+				return false;
+		}
+
+		frame.moving = reader.u8() != 0;
+		const std::uint64_t n = reader.varint();
+		// a mask byte per eight balls, more cannot come from a valid datagram
+		if ( n > 8 * maxDatagram || ( base && n != std::uint64_t( base->balls ) ) )
+			return false;
+
+		frame.balls = int( n );
+		frame.x.resize( n );
+		frame.y.resize( n );
+		frame.pocketed.resize( ( n + 7 ) / 8 );
+		reader.bytes( frame.pocketed.data(), frame.pocketed.size() );
+
+		if ( !base )
+		{
+			for ( int i = 0; i < frame.balls; i++ )
+			{
+				const bool pocketed = frame.isPocketed( i );
+				frame.x[ i ] = pocketed ? 0 : reader.u16();
+				frame.y[ i ] = pocketed ? 0 : reader.u16();
+			}
+		}
+		else
+		{
+			changed.resize( frame.pocketed.size() );
+			reader.bytes( changed.data(), changed.size() );
+			for ( int i = 0; i < frame.balls; i++ )
+			{
+				if ( frame.isPocketed( i ) )
+				{
+					frame.x[ i ] = frame.y[ i ] = 0;
+					continue;
+				}
+
+				if ( !( ( changed[ i >> 3 ] >> ( i & 7 ) ) & 1 ) )
+				{
+					frame.x[ i ] = base->x[ i ];
+					frame.y[ i ] = base->y[ i ];
+				}
+				else if ( !addDelta( base->x[ i ], reader.zigzag(), frame.x[ i ] ) || !addDelta( base->y[ i ], reader.zigzag(), frame.y[ i ] ) )
+					return false;
+			}
+		}
+		return !reader.failed() && reader.atEnd();
+	}
+
+
+	void SpectatorClient::receive( std::uint8_t const* data, size_t size )
+	{
+		constexpr float width = Params::Table::width;
+		constexpr float height = Params::Table::height;
+
+		if ( !apply( data, size ) )
+			return;
+
+		// the slot held a frame too old to be a base, the decoded one takes its place
+		SpectatorFrame& slot = history[ decoded.frame % history.size() ];
+		std::swap( slot, decoded );
+		latest = &slot;
+
+		balls.resize( slot.balls );
+		for ( int i = 0; i < slot.balls; i++ )
+		{
+			balls.x[ i ] = dequantize( slot.x[ i ], width );
+			balls.y[ i ] = dequantize( slot.y[ i ], height );
+			balls.vx[ i ] = balls.vy[ i ] = 0.f;
+			balls.alive[ i ] = !slot.isPocketed( i );
+		}
+	}
+
+
+	void SpectatorClient::update( double now, DatagramQueue& out )
+	{
+		// acks follow the frames closely while the table moves, at rest they keep the membership alive
+		const std::uint32_t applied = latest ? latest->frame : 0;
+		const float interval = applied != ackSent ? Params::Network::spectatorAckInterval : Params::Network::heartbeatInterval;
+		if ( now - lastAck < interval )
+			return;
+
+		Message message;
+		message.type = MessageType::watch;
+		message.match = match;
+		message.frame = applied;
+		if ( latest )
+		{
+			message.sequence = latest->sequence;
+			message.tick = latest->tick;
+		}
+
+		if ( !encode( message, out.push() ) )
+			out.pop();
+		ackSent = applied;
+		lastAck = now;
+	}
+
+
+	bool SpectatorClient::hasState() const
+	{
+		return latest != nullptr;
+	}
+
+
+	Physics::BallStore const& SpectatorClient::state() const
+	{
+		return balls;
+	}
+
+
+	SpectatorFrame const& SpectatorClient::frame() const
+	{
+		return latest ? *latest : decoded;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "ballstore.hpp"
+#include "netprotocol.hpp"
+
+
+//-------------------------------------------------------
+//	spectator snapshots of a match
+//-------------------------------------------------------
+
+// Spectators do not simulate, they are sent the ball positions of every tick.
+// Positions are 16 bit fixed point across the table and pocketed balls are a
+// bitmask. A snapshot is a delta against the frame the spectator acked last and
+// carries only the balls that moved since. Every spectator with the same ack gets
+// the same datagram, so a tick is encoded once per distinct ack instead of once
+// per spectator, and the outgoing datagrams all point at that one buffer.
+namespace Net
+{
+	struct SpectatorFrame
+	{
+		// numbered by the stream from 1, 0 is no frame
+		std::uint32_t frame = 0;
+		unsigned sequence = 0;
+		unsigned tick = 0;
+		bool moving = false;
+		int balls = 0;
+		std::vector< std::uint16_t > x;
+		std::vector< std::uint16_t > y;
+		// bit i % 8 of byte i / 8 is set for a pocketed ball
+		std::vector< std::uint8_t > pocketed;
+
+		bool isPocketed( int ball ) const;
+	};
+
+
+	// server side, one per match
+	class SpectatorStream
+	{
+	public:
+		explicit SpectatorStream( std::uint32_t match );
+
+		// quantizes the table into a new frame, false when the sequence and tick
+		// are the ones of the latest frame and nothing was kept
+		bool capture( Physics::BallStore const& balls, unsigned sequence, unsigned tick, bool moving );
+		std::uint32_t latest() const;
+
+		// brings a spectator from the acked frame to the latest, a keyframe when the ack
+		// is 0 or too old, null before the first capture or when it does not fit a datagram;
+		// buffers are reused once no datagram points at them anymore, so the datagrams
+		// of a tick have to be sent before the next capture
+		Datagram datagramFrom( std::uint32_t acked );
+
+		// encodings of the latest frame, one per distinct ack asked for
+		int encodings() const;
+
+	private:
+		struct Encoding
+		{
+			std::uint32_t base;
+			int buffer;
+		};
+
+		// a buffer no outgoing datagram points at anymore
+		int acquireBuffer();
+
+		std::uint32_t match;
+		std::uint32_t frames = 0;
+		// slot frame % size
+		std::vector< SpectatorFrame > history;
+		std::vector< Encoding > encoded;
+		std::vector< std::shared_ptr< std::vector< std::uint8_t > > > buffers;
+	};
+
+
+	// spectator side, applies the snapshots of one match and acks them
+	class SpectatorClient
+	{
+	public:
+		explicit SpectatorClient( std::uint32_t match );
+
+		// anything but a snapshot of this match is ignored, as is one whose base is gone
+		// or that is older than the frame applied last
+		void receive( std::uint8_t const* data, size_t size );
+		// asks to watch and acks, as a keepalive at rest
+		void update( double now, DatagramQueue& out );
+
+		bool hasState() const;
+		// positions of the latest frame, velocities are zero
+		Physics::BallStore const& state() const;
+		SpectatorFrame const& frame() const;
+
+	private:
+		bool apply( std::uint8_t const* data, size_t size );
+
+		std::uint32_t match;
+		std::uint32_t ackSent = 0;
+		double lastAck = -1e9;
+		std::vector< SpectatorFrame > history;
+		SpectatorFrame decoded;
+		std::vector< std::uint8_t > changed;
+		SpectatorFrame const* latest = nullptr;
+		Physics::BallStore balls;
+	};
+}
@@ -0,0 +1,184 @@
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+
+#include "tablefile.hpp"
+#include "bytestream.hpp"
+
+
+//-------------------------------------------------------
+//	reading
+//-------------------------------------------------------
+
+namespace TableFile
+{
+	std::vector< Vector2 > View::layout() const
+	{
+		return { balls, balls + header->ballCount };
+	}
+
+
+	View parse( void const* data, size_t size )
+	{
+		View view;
+		// the header and positions are read in place and need float alignment
+		if ( !data || size < sizeof( Header ) || reinterpret_cast< std::uintptr_t >( data ) % alignof( Header ) )
+			return view;
+
+		Header const* header = static_cast< Header const* >( data );
+		if ( header->magic != magic || header->version != version || !header->ballCount )
+			return view;
+
+		const std::uint64_t points = std::uint64_t( header->pocketCount ) + header->ballCount;
+		if ( size < sizeof( Header ) + points * sizeof( Vector2 ) )
+			return view;
+
+		view.header = header;
+		view.pockets = reinterpret_cast< Vector2 const* >( header + 1 );
+		view.balls = view.pockets + header->pocketCount;
+		return view;
+	}
+}
+
+
+//-------------------------------------------------------
+//	text source compiler
+//-------------------------------------------------------
+
+namespace TableFile
+{
+	namespace
+	{
+		struct Source
+		{
+			bool hasTable = false;
+			float width = 0.f;
+			float height = 0.f;
+
+			// the scalar keywords in header order, all of them required
+			static constexpr int scalarCount = 6;
+			float scalars[ scalarCount ] = {};
+			bool hasScalar[ scalarCount ] = {};
+
+			std::vector< Vector2 > pockets;
+			std::vector< Vector2 > balls;
+		};
+
+
+		constexpr char const* scalarNames[ Source::scalarCount ] =
+		{
+			"ball_radius",
+			"pocket_radius",
+			"deceleration",
+			"cushion_loss",
+			"ball_transfer",
+			"ball_restitution"
+		};
+
+
+		// values after the keyword, nothing but a comment may follow them
+		bool readValues( std::istringstream& fields, float* values, int count )
+		{
+			for ( int i = 0; i < count; i++ )
+			{
+				if ( !( fields >> values[ i ] ) || !std::isfinite( values[ i ] ) )
+					return false;
+			}
+
+			std::string rest;
+			return !( fields >> rest ) || rest[ 0 ] == '#';
+		}
+	}
+
+
+	bool compile( std::string const& text, std::vector< std::uint8_t >& binary, std::string& error )
+	{
+		Source source;
+		std::istringstream lines( text );
+		std::string line;
+
+		for ( int number = 1; std::getline( lines, line ); number++ )
+		{
+			std::istringstream fields( line );
+			std::string keyword;
+			if ( !( fields >> keyword ) || keyword[ 0 ] == '#' )
+				continue;
+
+			auto fail = [ &error, number ]( std::string const& message )
+			{
+				error = "line " + std::to_string( number ) + ": " + message;
+				return false;
+			};
+
+			float values[ 2 ] = {};
+			if ( keyword == "table" || keyword == "pocket" || keyword == "ball" )
+			{
+				if ( !readValues( fields, values, 2 ) )
+					return fail( keyword + " expects two numbers" );
+
+				if ( keyword == "table" )
+				{
+					if ( values[ 0 ] <= 0.f || values[ 1 ] <= 0.f )
+						return fail( "table size must be positive" );
+					source.hasTable = true;
+					source.width = values[ 0 ];
+					source.height = values[ 1 ];
+				}
+				else
+					( keyword == "ball" ? source.balls : source.pockets ).push_back( { values[ 0 ], values[ 1 ] } );
+				continue;
+			}
+
+			int scalar = 0;
+			while ( scalar < Source::scalarCount && keyword != scalarNames[ scalar ] )
+				scalar++;
+			if ( scalar == Source::scalarCount )
+				return fail( "unknown keyword " + keyword );
+			if ( !readValues( fields, values, 1 ) )
+				return fail( keyword + " expects one number" );
+
+			source.scalars[ scalar ] = values[ 0 ];
+			source.hasScalar[ scalar ] = true;
+		}
+
+		if ( !source.hasTable )
+		{
+			error = "missing table";
+			return false;
+		}
+		for ( int scalar = 0; scalar < Source::scalarCount; scalar++ )
+		{
+			if ( !source.hasScalar[ scalar ] )
+			{
+				error = std::string( "missing " ) + scalarNames[ scalar ];
+				return false;
+			}
+		}
+		if ( source.balls.empty() )
+		{
+			error = "no balls, the first one is the player ball";
+			return false;
+		}
+
+		binary.clear();
+		ByteWriter writer( binary );
+		writer.u32( magic );
+		writer.u32( version );
+		writer.u32( std::uint32_t( source.pockets.size() ) );
+		writer.u32( std::uint32_t( source.balls.size() ) );
+		writer.f32( source.width );
+		writer.f32( source.height );
+		for ( float value : source.scalars )
+			writer.f32( value );
+
+		for ( std::vector< Vector2 > const* points : { &source.pockets, &source.balls } )
+		{
+			for ( Vector2 const& point : *points )
+			{
+				writer.f32( point.x );
+				writer.f32( point.y );
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "vector2.hpp"
+
+
+//-------------------------------------------------------
+//	binary table layout files
+//-------------------------------------------------------
+
+// A table file is a fixed header followed by the pocket and the ball positions
+// as little endian float pairs, the player ball first. Parsing only checks the
+// sizes and hands out pointers into the bytes, so a memory mapped file is read
+// in place. Files are compiled from a line based text source, see compile.
+namespace TableFile
+{
+	// "TBL1" read as a little endian word
+	constexpr std::uint32_t magic = 0x314c4254;
+	constexpr std::uint32_t version = 1;
+
+	struct Header
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t pocketCount;
+		std::uint32_t ballCount;
+
+		float width;
+		float height;
+		float ballRadius;
+		float pocketRadius;
+
+		float deceleration;
+		float cushionLoss;
+		float ballTransfer;
+		float ballRestitution;
+	};
+
+	static_assert( sizeof( Header ) == 48, "the header is read in place" );
+	static_assert( sizeof( Vector2 ) == 8, "positions are read in place" );
+
+
+	// points into the parsed bytes, valid as long as they are
+	struct View
+	{
+		Header const* header = nullptr;
+		Vector2 const* pockets = nullptr;
+		Vector2 const* balls = nullptr;
+
+		explicit operator bool() const { return header != nullptr; }
+
+		std::vector< Vector2 > layout() const;
+	};
+
+
+	// checks the header and the sizes, an empty view when the bytes are not a table file
+	View parse( void const* data, size_t size );
+
+	// text source to table file, returns false with a message naming the line on errors
+	//
+	//	# comment
+	//	table <width> <height>
+	//	ball_radius <r>        pocket_radius <r>
+	//	deceleration <d>       cushion_loss <l>
+	//	ball_transfer <t>      ball_restitution <e>
+	//	pocket <x> <y>         one line per pocket
+	//	ball <x> <y>           one line per ball, the player ball first
+	bool compile( std::string const& text, std::vector< std::uint8_t >& binary, std::string& error );
+
+	// the steppers are specialized per rule set, a file can only drive the one it was made for,
+	// null when it was, else the first constant that differs
+	template< class R >
+	char const* mismatch( View const& view );
+}
+
+
+namespace TableFile
+{
+	namespace Detail
+	{
+		inline bool near( float a, float b )
+		{
+			return std::abs( a - b ) <= 1e-5f * std::max( 1.f, std::abs( b ) );
+		}
+	}
+
+
+	template< class R >
+	char const* mismatch( View const& view )
+	{
+		using Detail::near;
+
+		Header const& header = *view.header;
+		if ( header.pocketCount != R::pockets.size() )
+			return "pocket count";
+
+		for ( size_t p = 0; p < R::pockets.size(); p++ )
+		{
+			if ( !near( view.pockets[ p ].x, R::pockets[ p ].x ) || !near( view.pockets[ p ].y, R::pockets[ p ].y ) )
+				return "pocket position";
+		}
+
+		struct Constant
+		{
+			float file;
+			float rules;
+			char const* name;
+		};
+		const Constant constants[] =
+		{
+			{ header.width, R::width, "width" },
+			{ header.height, R::height, "height" },
+			{ header.ballRadius, R::ballRadius, "ball radius" },
+			{ header.pocketRadius, R::pocketRadius, "pocket radius" },
+			{ header.deceleration, R::deceleration, "deceleration" },
+			{ header.cushionLoss, R::cushionLoss, "cushion loss" },
+			{ header.ballTransfer, R::ballTransfer, "ball transfer" },
+			{ header.ballRestitution, R::ballRestitution, "ball restitution" },
+		};
+		for ( Constant const& constant : constants )
+		{
+			if ( !near( constant.file, constant.rules ) )
+				return constant.name;
+		}
+		return nullptr;
+	}
+}
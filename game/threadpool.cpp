@@ -0,0 +1,158 @@
+#include <cassert>
+#include <algorithm>
+
+#include "threadpool.hpp"
+
+
+ThreadPool::ThreadPool( int threadCount )
+{
+	if ( threadCount <= 0 )
+		threadCount = std::max( int( std::thread::hardware_concurrency() ), 1 );
+
+	for ( int i = 0; i < threadCount; i++ )
+		queues.push_back( std::make_unique< Queue >() );
+
+	for ( int i = 1; i < threadCount; i++ )
+		threads.emplace_back( &ThreadPool::workerLoop, this, i );
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard< std::mutex > lock( jobMutex );
+		stopping = true;
+	}
+	jobStarted.notify_all();
+
+	for ( std::thread& thread : threads )
+		thread.join();
+}
+
+
+int ThreadPool::size() const
+{
+	return int( queues.size() );
+}
+
+
+void ThreadPool::reserve( int chunks )
+{
+	// round robin, no queue gets more than its share rounded up
+	const size_t share = size_t( chunks / size() + 1 );
+	for ( std::unique_ptr< Queue > const& queue : queues )
+	{
+		std::lock_guard< std::mutex > lock( queue->mutex );
+		queue->ranges.reserve( share );
+	}
+}
+
+
+void ThreadPool::run( int count, int grain, Job newJob, void const* newBody )
+{
+	if ( count <= 0 )
+		return;
+
+	grain = std::max( grain, 1 );
+	if ( size() == 1 || count <= grain )
+	{
+		newJob( newBody, 0, count, 0 );
+		return;
+	}
+
+	std::unique_lock< std::mutex > lock( jobMutex );
+	assert( !body && "nested parallelFor is not supported" );
+
+	// the last job drained every queue
+	for ( std::unique_ptr< Queue > const& queue : queues )
+	{
+		std::lock_guard< std::mutex > queueLock( queue->mutex );
+		queue->ranges.clear();
+		queue->front = 0;
+	}
+
+	// chunks are dealt round robin, idle workers steal from the others
+	int chunks = 0;
+	for ( int begin = 0; begin < count; begin += grain, chunks++ )
+	{
+		Queue& queue = *queues[ chunks % size() ];
+		std::lock_guard< std::mutex > queueLock( queue.mutex );
+		queue.ranges.push_back( { begin, std::min( begin + grain, count ) } );
+	}
+
+	pending = chunks;
+	job = newJob;
+	body = newBody;
+	busyWorkers = size() - 1;
+	generation++;
+	lock.unlock();
+	jobStarted.notify_all();
+
+	drain( 0 );
+
+	lock.lock();
+	jobFinished.wait( lock, [ this ] { return pending == 0 && busyWorkers == 0; } );
+	job = nullptr;
+	body = nullptr;
+}
+
+
+void ThreadPool::workerLoop( int worker )
+{
+	unsigned seen = 0;
+	while ( true )
+	{
+		{
+			std::unique_lock< std::mutex > lock( jobMutex );
+			jobStarted.wait( lock, [ & ] { return stopping || generation != seen; } );
+			if ( stopping )
+				return;
+			seen = generation;
+		}
+
+		drain( worker );
+
+		std::lock_guard< std::mutex > lock( jobMutex );
+		if ( --busyWorkers == 0 )
+			jobFinished.notify_all();
+	}
+}
+
+
+void ThreadPool::drain( int worker )
+{
+	Range range;
+	while ( pending > 0 && pop( worker, range ) )
+	{
+		job( body, range.begin, range.end, worker );
+		pending--;
+	}
+}
+
+
+bool ThreadPool::pop( int worker, Range& range )
+{
+	// own queue from the back keeps the chunks hot in this core's cache
+	{
+		Queue& own = *queues[ worker ];
+		std::lock_guard< std::mutex > lock( own.mutex );
+		if ( own.front < own.ranges.size() )
+		{
+			range = own.ranges.back();
+			own.ranges.pop_back();
+			return true;
+		}
+	}
+
+	for ( int i = 1; i < size(); i++ )
+	{
+		Queue& victim = *queues[ ( worker + i ) % size() ];
+		std::lock_guard< std::mutex > lock( victim.mutex );
+		if ( victim.front < victim.ranges.size() )
+		{
+			range = victim.ranges[ victim.front++ ];
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	work stealing thread pool for data parallel loops
+//-------------------------------------------------------
+
+class ThreadPool
+{
+public:
+	// zero threads means one per hardware thread, the calling thread is worker 0
+	explicit ThreadPool( int threads = 0 );
+	ThreadPool( ThreadPool const& ) = delete;
+	~ThreadPool();
+
+	int size() const;
+
+	// sizes the queues for a job dealt into that many chunks, so dealing it does not allocate
+	void reserve( int chunks );
+
+	// calls body( begin, end, worker ) for chunks of [0, count) and waits for all of them,
+	// worker is in [0, size()) and lets the body pick per worker scratch state,
+	// nothing is allocated once the queues have held the largest job
+	template< class Body >
+	void parallelFor( int count, int grain, Body const& body );
+
+private:
+	// the body behind a plain pointer, a std::function would allocate for larger captures
+	using Job = void (*)( void const* body, int begin, int end, int worker );
+
+	struct Range
+	{
+		int begin;
+		int end;
+	};
+
+	// filled before the workers start and only taken from afterwards, the owner pops
+	// the back and thieves advance front, so the storage is kept from job to job
+	struct Queue
+	{
+		std::mutex mutex;
+		std::vector< Range > ranges;
+		size_t front = 0;
+	};
+
+	void run( int count, int grain, Job job, void const* body );
+	void workerLoop( int worker );
+	void drain( int worker );
+	bool pop( int worker, Range& range );
+
+	std::vector< std::thread > threads;
+	std::vector< std::unique_ptr< Queue > > queues;
+
+	std::mutex jobMutex;
+	std::condition_variable jobStarted;
+	std::condition_variable jobFinished;
+	Job job = nullptr;
+	void const* body = nullptr;
+	std::atomic< int > pending = { 0 };
+	int busyWorkers = 0;
+	unsigned generation = 0;
+	bool stopping = false;
+};
+
+
+template< class Body >
+void ThreadPool::parallelFor( int count, int grain, Body const& body )
+{
+	run( count, grain, []( void const* context, int begin, int end, int worker )
+	{
+		( *static_cast< Body const* >( context ) )( begin, end, worker );
+	}, &body );
+}
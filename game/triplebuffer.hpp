@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+
+//-------------------------------------------------------
+//	lock free single producer single consumer triple buffer
+//-------------------------------------------------------
+
+// the producer always has a slot to write and the consumer always has a slot to read,
+// the third one is swapped between them atomically, neither side ever waits
+template< class T >
+class TripleBuffer
+{
+public:
+	// producer side: fill the write slot, then publish it
+	T& writeSlot()
+	{
+		return slots[ back ];
+	}
+
+	void publish()
+	{
+		back = middle.exchange( back | freshBit, std::memory_order_acq_rel ) & indexMask;
+	}
+
+	// consumer side: true when something was published since the previous call,
+	// the read slot then holds the latest value until the next acquire
+	bool acquire()
+	{
+		if ( !( middle.load( std::memory_order_relaxed ) & freshBit ) )
+			return false;
+
+		front = middle.exchange( front, std::memory_order_acq_rel ) & indexMask;
+		return true;
+	}
+
+	T const& readSlot() const
+	{
+		return slots[ front ];
+	}
+
+private:
+	static constexpr unsigned indexMask = 3;
+	static constexpr unsigned freshBit = 4;
+
+	std::array< T, 3 > slots;
+	std::atomic< unsigned > middle{ 1 };
+	unsigned back = 0;
+	unsigned front = 2;
+};
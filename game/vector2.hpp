@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cmath>
+
+
+//-------------------------------------------------------
+//	Basic Vector2 class
+//-------------------------------------------------------
+
+class Vector2
+{
+public:
+	float x = 0.f;
+	float y = 0.f;
+
+	constexpr Vector2() = default;
+	constexpr Vector2( float vx, float vy );
+	constexpr Vector2( Vector2 const &other ) = default;
+
+	float length() const;
+	void normalize();
+	void invertY();
+	void invertX();
+};
+
+
+constexpr Vector2::Vector2( float vx, float vy ) :
+	x( vx ),
+	y( vy )
+{
+}
+
+inline float Vector2::length() const
+{
+	return std::sqrt( x * x + y * y );
+}
+
+inline void Vector2::normalize()
+{
+	float len = this->length();
+	x /= len;
+	y /= len;
+}
+
+inline void Vector2::invertY()
+{
+	y *= -1;
+}
+
+inline void Vector2::invertX()
+{
+	x *= -1;
+}
@@ -0,0 +1,165 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../framework/udpsocket.hpp"
+#include "../game/params.hpp"
+#include "../game/netmatch.hpp"
+#include "../game/threadpool.hpp"
+
+
+//-------------------------------------------------------
+//	headless match server
+//-------------------------------------------------------
+
+// usage: server [--port n] [--threads n]
+// Hosts any number of matches on one udp port, a match is created by the first
+// join for its id and dropped once all of its clients timed out. Tables at rest
+// cost a heartbeat per second, only moving ones are simulated. Spectators watch a
+// match that exists, the state of each tick is encoded once for all of them.
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Traffic
+	{
+		std::uint64_t datagramsIn = 0;
+		std::uint64_t datagramsOut = 0;
+		std::uint64_t bytesIn = 0;
+		std::uint64_t bytesOut = 0;
+	};
+
+
+	void flush( UdpSocket& socket, std::vector< Net::Outgoing >& outbox, Traffic& traffic )
+	{
+		for ( Net::Outgoing const& outgoing : outbox )
+		{
+			if ( socket.send( UdpAddress::fromId( outgoing.peer ), outgoing.datagram->data(), outgoing.datagram->size() ) )
+			{
+				traffic.datagramsOut++;
+				traffic.bytesOut += outgoing.datagram->size();
+			}
+		}
+		// lets the spectator streams reuse their buffers
+		outbox.clear();
+	}
+}
+
+
+int main( int argc, char** argv )
+{
+	std::uint16_t port = Params::Network::port;
+	int threads = 0;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( !std::strcmp( argv[ i ], "--port" ) && i + 1 < argc )
+			port = std::uint16_t( std::atoi( argv[ ++i ] ) );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) && i + 1 < argc )
+			threads = std::atoi( argv[ ++i ] );
+		else
+		{
+			std::fprintf( stderr, "usage: %s [--port n] [--threads n]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	UdpSocket socket;
+	if ( !socket.open( port ) )
+	{
+		std::fprintf( stderr, "cannot bind udp port %u\n", unsigned( port ) );
+		return 1;
+	}
+
+	ThreadPool pool( threads );
+	std::printf( "serving on udp port %u with %d threads\n", unsigned( port ), pool.size() );
+	std::fflush( stdout );
+
+	std::unordered_map< std::uint32_t, std::unique_ptr< Net::ServerMatch > > matches;
+	std::vector< Net::ServerMatch* > tables;
+	// one outbox per worker, the matches share nothing while they update
+	std::vector< std::vector< Net::Outgoing > > outboxes( pool.size() );
+
+	constexpr float dt = Params::Physics::timeStep;
+	const Clock::time_point start = Clock::now();
+	Clock::time_point nextTick = start;
+	double nextReport = 10.0;
+
+	Traffic traffic;
+	std::uint8_t const* datagram = nullptr;
+	size_t size = 0;
+	Net::Message message;
+
+	for ( ;; )
+	{
+		const double now = std::chrono::duration< double >( Clock::now() - start ).count();
+
+		UdpAddress from;
+		while ( socket.receive( from, datagram, size ) )
+		{
+			traffic.datagramsIn++;
+			traffic.bytesIn += size;
+			if ( !Net::decode( datagram, size, message ) )
+				continue;
+
+			auto found = matches.find( message.match );
+			if ( found == matches.end() )
+			{
+				if ( message.type != Net::MessageType::join )
+					continue;
+				found = matches.emplace( message.match, std::make_unique< Net::ServerMatch >( message.match ) ).first;
+			}
+			found->second->receive( from.id(), message, now, outboxes[ 0 ] );
+		}
+		flush( socket, outboxes[ 0 ], traffic );
+
+		tables.clear();
+		for ( auto& entry : matches )
+			tables.push_back( entry.second.get() );
+
+		pool.parallelFor( int( tables.size() ), 256, [ & ]( int begin, int end, int worker )
+		{
+			for ( int i = begin; i < end; i++ )
+				tables[ i ]->update( dt, now, outboxes[ worker ] );
+		} );
+
+		for ( std::vector< Net::Outgoing >& outbox : outboxes )
+			flush( socket, outbox, traffic );
+
+		// tables still points at erased matches from here on
+		for ( auto it = matches.begin(); it != matches.end(); )
+			it = it->second->isAbandoned( now ) ? matches.erase( it ) : std::next( it );
+
+		if ( now >= nextReport )
+		{
+			int moving = 0;
+			int spectators = 0;
+			for ( auto const& entry : matches )
+			{
+				moving += entry.second->isBallsMoving();
+				spectators += entry.second->spectatorCount();
+			}
+
+			std::printf( "%zu matches, %d moving, %d spectators, in %llu datagrams %llu bytes, out %llu datagrams %llu bytes\n", matches.size(), moving, spectators,
+				( unsigned long long )traffic.datagramsIn, ( unsigned long long )traffic.bytesIn,
+				( unsigned long long )traffic.datagramsOut, ( unsigned long long )traffic.bytesOut );
+			std::fflush( stdout );
+			traffic = {};
+			nextReport += 10.0;
+		}
+
+		// fixed ticks, a late tick is not caught up so the server degrades instead of spiralling
+		nextTick += std::chrono::duration_cast< Clock::duration >( std::chrono::duration< double >( dt ) );
+		const Clock::time_point current = Clock::now();
+		if ( nextTick < current )
+			nextTick = current;
+		std::this_thread::sleep_until( nextTick );
+	}
+}
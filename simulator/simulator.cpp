@@ -0,0 +1,444 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../game/params.hpp"
+#include "../game/layouts.hpp"
+#include "../game/tablefile.hpp"
+#include "../game/determinism.hpp"
+#include "../game/physics.hpp"
+#include "../game/match.hpp"
+#include "../game/replay.hpp"
+#include "../game/threadpool.hpp"
+
+
+//-------------------------------------------------------
+//	headless table simulator
+//-------------------------------------------------------
+
+// usage: simulator [--layout standard|rack|snooker|stress] [--balls n] [--table file.tbl]
+//                  [--shots file] [--tables n] [--threads n] [--dt seconds] [--continuous]
+//                  [--record file.rpl]
+//        simulator --replay file.rpl [--seek tick]
+// Plays a list of shots on a table without a window and prints the resting state,
+// then plays the same list on many tables at once and reports the throughput.
+// Every table has to end in the same state, the exit code is 1 when one does not.
+// --record plays the inputs once more through a Match with a replay recorder and
+// writes the replay, the match has to end like the reference run. Replays are
+// played back with the discrete step at the fixed time step, so it needs both.
+//
+// --replay seeks to the tick, the end by default, from the nearest keyframe and prints
+// the state there. The same inputs are then simulated from the layout without keyframes,
+// the exit code is 1 when the two states differ.
+//
+// A shot file holds one input per line:
+//	# comment
+//	shot <x> <y> <charge>    aims the player ball at the point, charge in [0, 1]
+//	reset                    puts the layout back
+// Without a file a single full power shot at the first object ball is played.
+
+namespace
+{
+	struct Timer
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		double seconds() const
+		{
+			return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+		}
+	};
+
+
+	struct Input
+	{
+		bool reset = false;
+		Vector2 target;
+		float charge = 0.f;
+	};
+
+
+	// a moving table always comes to rest, the cap only guards against a broken layout
+	constexpr int maxTicksPerShot = 1 << 20;
+
+
+	std::vector< Vector2 > namedLayout( std::string const& name, int balls )
+	{
+		if ( name == "rack" )
+			return Layouts::rack( balls > 0 ? balls - 1 : 15 );
+		if ( name == "snooker" )
+			return Layouts::snooker();
+		if ( name == "stress" )
+			return Layouts::stress( balls > 0 ? balls - 1 : 1023 );
+		if ( name == "standard" )
+			return Layouts::standard();
+		return {};
+	}
+
+
+	bool loadTable( char const* path, std::vector< Vector2 >& layout, std::string& error )
+	{
+		std::ifstream file( path, std::ios::binary );
+		if ( !file )
+		{
+			error = "cannot read the file";
+			return false;
+		}
+		const std::vector< char > bytes( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+
+		TableFile::View table = TableFile::parse( bytes.data(), bytes.size() );
+		if ( !table )
+		{
+			error = "not a table file";
+			return false;
+		}
+		// the simulator steps the pool rules, like the game
+		if ( char const* constant = TableFile::mismatch< Rules::Pool >( table ) )
+		{
+			error = std::string( "the table is not made for the pool rules, its " ) + constant + " differs";
+			return false;
+		}
+
+		layout = table.layout();
+		return true;
+	}
+
+
+	bool loadShots( char const* path, std::vector< Input >& inputs, std::string& error )
+	{
+		std::ifstream file( path );
+		if ( !file )
+		{
+			error = "cannot read the file";
+			return false;
+		}
+
+		std::string line;
+		for ( int number = 1; std::getline( file, line ); number++ )
+		{
+			std::istringstream fields( line );
+			std::string keyword;
+			if ( !( fields >> keyword ) || keyword[ 0 ] == '#' )
+				continue;
+
+			Input input;
+			if ( keyword == "reset" )
+				input.reset = true;
+			else if ( keyword != "shot" || !( fields >> input.target.x >> input.target.y >> input.charge ) || !( input.charge >= 0.f && input.charge <= 1.f ) )
+			{
+				error = "line " + std::to_string( number ) + ": expected shot <x> <y> <charge> or reset";
+				return false;
+			}
+			inputs.push_back( input );
+		}
+		return true;
+	}
+
+
+	// plays the inputs from the layout and returns the ticks simulated,
+	// a pocketed player ball resets the table like Match does
+	std::uint64_t play( Physics::Simulation& table, std::vector< Vector2 > const& layout, std::vector< Input > const& inputs )
+	{
+		std::uint64_t ticks = 0;
+		table.reset( layout );
+		for ( Input const& input : inputs )
+		{
+			if ( input.reset )
+			{
+				table.reset( layout );
+				continue;
+			}
+
+			table.shoot( input.target, input.charge );
+			for ( int i = 0; i < maxTicksPerShot && table.isBallsMoving(); i++ )
+			{
+				table.step();
+				ticks++;
+			}
+			if ( table.isCueBallPocketed() )
+				table.reset( layout );
+		}
+		return ticks;
+	}
+
+
+	// the inputs played through a Match the way the game does, one fixed step per update
+	Physics::BallStore record( std::vector< Vector2 > const& layout, std::vector< Input > const& inputs, Replay::Recorder& recorder )
+	{
+		Match match( layout );
+		match.setRecorder( &recorder );
+		for ( Input const& input : inputs )
+		{
+			if ( input.reset )
+			{
+				match.reset();
+				continue;
+			}
+
+			match.shoot( input.target, input.charge );
+			for ( int i = 0; i < maxTicksPerShot && match.isBallsMoving(); i++ )
+				match.update( Params::Physics::timeStep );
+		}
+		recorder.finish( match.elapsedTicks(), match.simulation() );
+		return match.simulation().state();
+	}
+
+
+	// the events of a replay applied the way Replay::Player applies them, starting from the layout
+	Physics::BallStore resimulate( Replay::Player const& player, unsigned target )
+	{
+		Physics::Simulation table;
+		table.setDeterministic( true );
+		table.reset( player.initialLayout() );
+
+		std::vector< Replay::Event > const& events = player.events();
+		size_t next = 0;
+		for ( unsigned tick = 0; ; tick++ )
+		{
+			for ( ; next < events.size() && events[ next ].tick <= tick; next++ )
+			{
+				if ( events[ next ].type == Replay::EventType::reset )
+					table.reset( player.initialLayout() );
+				else
+					table.shoot( events[ next ].target, events[ next ].charge );
+			}
+
+			if ( tick >= target || !table.isBallsMoving() )
+				break;
+			table.step();
+		}
+		return table.state();
+	}
+
+
+	bool readFile( char const* path, std::vector< std::uint8_t >& bytes )
+	{
+		std::ifstream file( path, std::ios::binary );
+		if ( !file )
+			return false;
+		bytes.assign( std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >() );
+		return true;
+	}
+
+
+	bool writeFile( char const* path, std::vector< std::uint8_t > const& bytes )
+	{
+		std::ofstream file( path, std::ios::binary );
+		file.write( reinterpret_cast< char const* >( bytes.data() ), std::streamsize( bytes.size() ) );
+		return bool( file );
+	}
+
+
+	void printState( Physics::BallStore const& balls )
+	{
+		for ( int i = 0; i < balls.size(); i++ )
+		{
+			if ( balls.alive[ i ] )
+				std::printf( "ball %d %.9g %.9g\n", i, balls.x[ i ], balls.y[ i ] );
+			else
+				std::printf( "ball %d pocketed\n", i );
+		}
+		std::printf( "hash %016llx\n", ( unsigned long long )Physics::Determinism::hash( balls ) );
+	}
+}
+
+
+int main( int argc, char** argv )
+{
+	std::string layoutName = "standard";
+	int balls = 0;
+	char const* tablePath = nullptr;
+	char const* shotsPath = nullptr;
+	int tableCount = 1000;
+	int threads = 0;
+	float dt = Params::Physics::timeStep;
+	bool continuous = false;
+	char const* recordPath = nullptr;
+	char const* replayPath = nullptr;
+	long long seekTick = -1;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( !std::strcmp( argv[ i ], "--layout" ) && i + 1 < argc )
+			layoutName = argv[ ++i ];
+		else if ( !std::strcmp( argv[ i ], "--balls" ) && i + 1 < argc )
+			balls = std::atoi( argv[ ++i ] );
+		else if ( !std::strcmp( argv[ i ], "--table" ) && i + 1 < argc )
+			tablePath = argv[ ++i ];
+		else if ( !std::strcmp( argv[ i ], "--shots" ) && i + 1 < argc )
+			shotsPath = argv[ ++i ];
+		else if ( !std::strcmp( argv[ i ], "--tables" ) && i + 1 < argc )
+			tableCount = std::max( std::atoi( argv[ ++i ] ), 0 );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) && i + 1 < argc )
+			threads = std::atoi( argv[ ++i ] );
+		else if ( !std::strcmp( argv[ i ], "--dt" ) && i + 1 < argc )
+			dt = float( std::atof( argv[ ++i ] ) );
+		else if ( !std::strcmp( argv[ i ], "--continuous" ) )
+			continuous = true;
+		else if ( !std::strcmp( argv[ i ], "--record" ) && i + 1 < argc )
+			recordPath = argv[ ++i ];
+		else if ( !std::strcmp( argv[ i ], "--replay" ) && i + 1 < argc )
+			replayPath = argv[ ++i ];
+		else if ( !std::strcmp( argv[ i ], "--seek" ) && i + 1 < argc )
+			seekTick = std::max( std::atoll( argv[ ++i ] ), 0ll );
+		else
+		{
+			std::fprintf( stderr, "usage: %s [--layout standard|rack|snooker|stress] [--balls n] [--table file.tbl]\n"
+				"       [--shots file] [--tables n] [--threads n] [--dt seconds] [--continuous] [--record file.rpl]\n"
+				"   or: %s --replay file.rpl [--seek tick]\n", argv[ 0 ], argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	if ( replayPath )
+	{
+		std::vector< std::uint8_t > bytes;
+		Replay::Player player;
+		if ( !readFile( replayPath, bytes ) || !player.load( bytes ) )
+		{
+			std::fprintf( stderr, "%s: not a replay\n", replayPath );
+			return 2;
+		}
+
+		const unsigned target = seekTick < 0 ? player.length() : unsigned( std::min( seekTick, ( long long )player.length() ) );
+		Timer seek;
+		player.seek( target );
+		const double seekSeconds = seek.seconds();
+		printState( player.simulation().state() );
+		std::printf( "tick %u of %u, %zu events, seek in %.3f ms\n", player.tick(), player.length(), player.events().size(), seekSeconds * 1e3 );
+
+		// a seek restores a keyframe, the straight run has to land on the same bits
+		if ( Physics::Determinism::hash( resimulate( player, target ) ) != Physics::Determinism::hash( player.simulation().state() ) )
+		{
+			std::printf( "the seek and the straight run ended in different states\n" );
+			return 1;
+		}
+		return 0;
+	}
+
+	if ( recordPath && ( continuous || dt != Params::Physics::timeStep ) )
+	{
+		std::fprintf( stderr, "replays are played back with the discrete step at %g s, --record takes neither --continuous nor --dt\n", Params::Physics::timeStep );
+		return 2;
+	}
+
+	if ( !( dt > 0.f ) )
+	{
+		std::fprintf( stderr, "the time step has to be positive\n" );
+		return 2;
+	}
+
+	std::vector< Vector2 > layout;
+	std::string error;
+	if ( tablePath )
+	{
+		if ( !loadTable( tablePath, layout, error ) )
+		{
+			std::fprintf( stderr, "%s: %s\n", tablePath, error.c_str() );
+			return 2;
+		}
+	}
+	else
+	{
+		layout = namedLayout( layoutName, balls );
+		if ( layout.empty() )
+		{
+			std::fprintf( stderr, "unknown layout %s\n", layoutName.c_str() );
+			return 2;
+		}
+	}
+
+	std::vector< Input > inputs;
+	if ( shotsPath )
+	{
+		if ( !loadShots( shotsPath, inputs, error ) )
+		{
+			std::fprintf( stderr, "%s: %s\n", shotsPath, error.c_str() );
+			return 2;
+		}
+	}
+	else if ( layout.size() > 1 )
+	{
+		Input input;
+		input.target = layout[ 1 ];
+		input.charge = 1.f;
+		inputs.push_back( input );
+	}
+
+	ThreadPool pool( threads );
+	// one table per worker, reset for every run
+	std::vector< Physics::Simulation > workers( pool.size() );
+	for ( Physics::Simulation& table : workers )
+	{
+		table.setStepping( continuous ? Physics::Stepping::continuous : Physics::Stepping::discrete );
+		table.setTimeStep( dt );
+	}
+
+	std::printf( "%zu balls, %zu inputs, %s stepping at %g s\n", layout.size(), inputs.size(), continuous ? "continuous" : "discrete", dt );
+
+	// the reference run, every other table has to match it
+	Timer reference;
+	const std::uint64_t ticks = play( workers[ 0 ], layout, inputs );
+	const double referenceSeconds = reference.seconds();
+	const std::uint64_t hash = Physics::Determinism::hash( workers[ 0 ].state() );
+	printState( workers[ 0 ].state() );
+	std::printf( "%llu ticks in %.3f ms\n", ( unsigned long long )ticks, referenceSeconds * 1e3 );
+	if ( recordPath )
+	{
+		Replay::Recorder recorder;
+		if ( Physics::Determinism::hash( record( layout, inputs, recorder ) ) != hash )
+		{
+			std::printf( "the recorded match ended in a different state\n" );
+			return 1;
+		}
+		if ( !writeFile( recordPath, recorder.data() ) )
+		{
+			std::fprintf( stderr, "%s: cannot write the replay\n", recordPath );
+			return 2;
+		}
+		std::printf( "%zu bytes of replay written to %s\n", recorder.data().size(), recordPath );
+	}
+	std::fflush( stdout );
+
+	if ( !tableCount )
+		return 0;
+
+	std::vector< std::uint64_t > hashes( tableCount );
+	std::vector< std::uint64_t > workerTicks( pool.size() );
+
+	Timer timer;
+	pool.parallelFor( tableCount, 1, [ & ]( int begin, int end, int worker )
+	{
+		for ( int i = begin; i < end; i++ )
+		{
+			workerTicks[ worker ] += play( workers[ worker ], layout, inputs );
+			hashes[ i ] = Physics::Determinism::hash( workers[ worker ].state() );
+		}
+	} );
+	const double seconds = timer.seconds();
+
+	std::uint64_t totalTicks = 0;
+	for ( std::uint64_t count : workerTicks )
+		totalTicks += count;
+
+	int mismatches = 0;
+	for ( std::uint64_t tableHash : hashes )
+		mismatches += tableHash != hash;
+
+	std::printf( "%d tables on %d threads in %.3f s: %.0f ticks/sec, %.1f tables/sec\n",
+		tableCount, pool.size(), seconds, totalTicks / seconds, tableCount / seconds );
+	if ( mismatches )
+	{
+		std::printf( "%d table(s) ended in a different state\n", mismatches );
+		return 1;
+	}
+	return 0;
+}
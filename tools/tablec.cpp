@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../game/tablefile.hpp"
+
+
+//-------------------------------------------------------
+//	table file compiler
+//-------------------------------------------------------
+
+// usage: tablec source.txt output.tbl
+// Compiles a text table source into the binary file the game maps at start,
+// a running game picks the new file up within Params::Layout::reloadInterval.
+
+int main( int argc, char** argv )
+{
+	if ( argc != 3 )
+	{
+		std::fprintf( stderr, "usage: %s source.txt output.tbl\n", argv[ 0 ] );
+		return 2;
+	}
+
+	std::ifstream input( argv[ 1 ] );
+	if ( !input )
+	{
+		std::fprintf( stderr, "cannot read %s\n", argv[ 1 ] );
+		return 2;
+	}
+	const std::string text( ( std::istreambuf_iterator< char >( input ) ), std::istreambuf_iterator< char >() );
+
+	std::vector< std::uint8_t > binary;
+	std::string error;
+	if ( !TableFile::compile( text, binary, error ) )
+	{
+		std::fprintf( stderr, "%s: %s\n", argv[ 1 ], error.c_str() );
+		return 1;
+	}
+
+	std::ofstream output( argv[ 2 ], std::ios::binary );
+	output.write( reinterpret_cast< char const* >( binary.data() ), std::streamsize( binary.size() ) );
+	if ( !output )
+	{
+		std::fprintf( stderr, "cannot write %s\n", argv[ 2 ] );
+		return 2;
+	}
+
+	TableFile::View table = TableFile::parse( binary.data(), binary.size() );
+	std::printf( "%s: %u pockets, %u balls, %zu bytes\n", argv[ 2 ], table.header->pocketCount, table.header->ballCount, binary.size() );
+	return 0;
+}